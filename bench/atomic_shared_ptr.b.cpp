@@ -0,0 +1,69 @@
+// Read-mostly benchmarks for publishing a snapshot through a shared_ptr slot:
+// thread 0 is the writer, every other thread is a reader.
+#include <bm.h>
+
+#include <atomic_shared_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+using bm::payload;
+
+/// Number of reads the writer performs between two publications.
+constexpr int k_reads_per_write = 64;
+
+struct ksl_atomic_slot {
+    ksl::atomic_shared_ptr<payload> d_slot{ksl::make_shared<payload>(0)};
+
+    ksl::shared_ptr<payload> load() { return d_slot.load(); }
+    void store(int value) { d_slot.store(ksl::make_shared<payload>(value)); }
+};
+
+struct ksl_mutex_slot {
+    std::mutex d_mutex;
+    ksl::shared_ptr<payload> d_slot{ksl::make_shared<payload>(0)};
+
+    ksl::shared_ptr<payload> load() {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        return d_slot;
+    }
+
+    void store(int value) {
+        ksl::shared_ptr<payload> next = ksl::make_shared<payload>(value);
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_slot.swap(next);
+    }
+};
+
+struct std_atomic_slot {
+    std::atomic<std::shared_ptr<payload>> d_slot{std::make_shared<payload>(0)};
+
+    std::shared_ptr<payload> load() { return d_slot.load(); }
+    void store(int value) { d_slot.store(std::make_shared<payload>(value)); }
+};
+
+template <typename Slot> void BM_PublishReadMostly(benchmark::State &state) {
+    static Slot slot;
+    const bool writer = state.thread_index() == 0;
+    int count = 0;
+    for (auto _ : state) {
+        if (writer && ++count == k_reads_per_write) {
+            slot.store(count);
+            count = 0;
+        } else {
+            auto snapshot = slot.load();
+            benchmark::DoNotOptimize(snapshot->d_value);
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_PublishReadMostly, ksl_atomic_slot)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_PublishReadMostly, ksl_mutex_slot)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_PublishReadMostly, std_atomic_slot)->ThreadRange(1, bm::max_threads());
@@ -1,3 +1,37 @@
+#include <bm.h>
+#include <memory_trace.h>
+
 #include <benchmark/benchmark.h>
 
-BENCHMARK_MAIN();
\ No newline at end of file
+#include <iostream>
+#include <memory>
+
+int main(int argc, char **argv) {
+    const bool json_out = bm::json_out_requested(argc, argv);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+
+    // Every case gets allocation and, where the kernel allows, hardware
+    // counters from an extra run under the memory manager
+    bm::counting_memory_manager manager;
+    benchmark::RegisterMemoryManager(&manager);
+    manager.calibrate();
+    bm::counting_reporter reporter(&manager);
+    if (json_out) {
+        bm::counting_reporter file_reporter(&manager, std::make_unique<benchmark::JSONReporter>());
+        benchmark::RunSpecifiedBenchmarks(&reporter, &file_reporter);
+    } else {
+        benchmark::RunSpecifiedBenchmarks(&reporter);
+    }
+    benchmark::RegisterMemoryManager(nullptr);
+    benchmark::Shutdown();
+
+    // ENABLE_MEMORY_TRACE builds report the run's copies, moves, locks and
+    // the blocks still alive, next to any gperftools profile of it
+    if constexpr (ksl::memory_trace::k_enabled) {
+        ksl::memory_trace::dump(std::cerr);
+    }
+    return 0;
+}
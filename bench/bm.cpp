@@ -1 +1,349 @@
-#include <bm.h>
\ No newline at end of file
+#include <bm.h>
+
+#include <numa_arena.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <malloc.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace bm {
+
+int max_threads() {
+    return static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+}
+
+// ============================================================================
+// NODE PINNING
+// ============================================================================
+
+#if defined(__linux__)
+static_assert(sizeof(cpu_set_t) <= sizeof(std::array<std::uint64_t, 16>),
+              "node_pin saves a whole cpu_set_t");
+
+node_pin::node_pin(int node) {
+    std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    // A list of ranges such as "0-3,8-11"
+    std::string range;
+    while (std::getline(list, range, ',')) {
+        // A node without CPUs lists nothing, which must not pin to CPU 0
+        std::size_t first = 0;
+        std::size_t last = 0;
+        if (!ksl::numa_arena::parse_cpu_range(range, first, last)) {
+            continue;
+        }
+        for (std::size_t cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if (CPU_COUNT(&cpus) == 0) {
+        return;
+    }
+    auto *saved = reinterpret_cast<cpu_set_t *>(d_saved.data());
+    d_pinned = ::sched_getaffinity(0, sizeof(cpu_set_t), saved) == 0 &&
+               ::sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0;
+}
+
+node_pin::~node_pin() {
+    if (d_pinned) {
+        ::sched_setaffinity(0, sizeof(cpu_set_t), reinterpret_cast<cpu_set_t *>(d_saved.data()));
+    }
+}
+#else
+node_pin::node_pin(int) {}
+
+node_pin::~node_pin() = default;
+#endif
+
+// ============================================================================
+// ALLOCATION COUNTING
+// ============================================================================
+
+namespace {
+
+/// Plain thread_local integers: nothing to construct or destroy, so
+/// counting never allocates or registers anything itself.
+thread_local alloc_stats t_stats{};
+
+void *counted_allocate(std::size_t size, std::size_t align) noexcept {
+    if (size == 0) {
+        size = 1;
+    }
+    void *ptr = align <= alignof(std::max_align_t)
+                    ? std::malloc(size)
+                    : std::aligned_alloc(align, (size + align - 1) / align * align);
+    if (ptr) {
+        const auto bytes = static_cast<std::int64_t>(malloc_usable_size(ptr));
+        t_stats.allocs++;
+        t_stats.bytes += static_cast<std::uint64_t>(bytes);
+        t_stats.live_bytes += bytes;
+        t_stats.peak_live_bytes = std::max(t_stats.peak_live_bytes, t_stats.live_bytes);
+    }
+    return ptr;
+}
+
+void *counted_allocate_or_throw(std::size_t size, std::size_t align) {
+    void *ptr = counted_allocate(size, align);
+    while (!ptr) {
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+        ptr = counted_allocate(size, align);
+    }
+    return ptr;
+}
+
+void counted_free(void *ptr) noexcept {
+    if (ptr) {
+        t_stats.frees++;
+        t_stats.live_bytes -= static_cast<std::int64_t>(malloc_usable_size(ptr));
+        std::free(ptr);
+    }
+}
+
+} // namespace
+
+alloc_stats thread_alloc_stats() noexcept { return t_stats; }
+
+void reset_peak_live_bytes() noexcept { t_stats.peak_live_bytes = t_stats.live_bytes; }
+
+// ============================================================================
+// PERF COUNTERS
+// ============================================================================
+
+#if defined(__linux__)
+namespace {
+
+int open_counter(std::uint64_t config, int group) noexcept {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group < 0 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+}
+
+} // namespace
+
+perf_counters::perf_counters() {
+    d_leader = open_counter(PERF_COUNT_HW_INSTRUCTIONS, -1);
+    if (d_leader < 0) {
+        return;
+    }
+    d_members[0] = open_counter(PERF_COUNT_HW_CPU_CYCLES, d_leader);
+    d_members[1] = open_counter(PERF_COUNT_HW_CACHE_MISSES, d_leader);
+    if (d_members[0] < 0 || d_members[1] < 0) {
+        close();
+    }
+}
+
+perf_counters::~perf_counters() { close(); }
+
+void perf_counters::close() noexcept {
+    for (int *fd : {&d_members[1], &d_members[0], &d_leader}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void perf_counters::start() noexcept {
+    if (available()) {
+        ioctl(d_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(d_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+perf_sample perf_counters::stop() noexcept {
+    if (!available()) {
+        return {};
+    }
+    ioctl(d_leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    // PERF_FORMAT_GROUP: the number of counters, then their values in the
+    // order they joined the group
+    std::uint64_t values[4] = {};
+    if (read(d_leader, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values))) {
+        return {};
+    }
+    return {values[1], values[2], values[3]};
+}
+#else
+perf_counters::perf_counters() = default;
+perf_counters::~perf_counters() = default;
+void perf_counters::close() noexcept {}
+void perf_counters::start() noexcept {}
+perf_sample perf_counters::stop() noexcept { return {}; }
+#endif
+
+// ============================================================================
+// MEMORY MANAGER AND REPORTER
+// ============================================================================
+
+void counting_memory_manager::Start() {
+    reset_peak_live_bytes();
+    d_start = thread_alloc_stats();
+    d_perf.start();
+}
+
+void counting_memory_manager::Stop(Result *result) { Stop(*result); }
+
+void counting_memory_manager::Stop(Result &result) {
+    d_last.perf = d_perf.stop();
+    const alloc_stats end = thread_alloc_stats();
+    d_last.allocs = static_cast<std::int64_t>(end.allocs - d_start.allocs);
+    d_last.bytes = static_cast<std::int64_t>(end.bytes - d_start.bytes);
+    result.num_allocs = d_last.allocs;
+    result.total_allocated_bytes = d_last.bytes;
+    result.net_heap_growth = end.live_bytes - d_start.live_bytes;
+    result.max_bytes_used = end.peak_live_bytes - d_start.live_bytes;
+}
+
+namespace {
+
+/// Does nothing, so its memory run counts only the runner's work.
+void BM_HarnessBaseline(benchmark::State &state) {
+    for (auto _ : state) {
+    }
+}
+
+BENCHMARK(BM_HarnessBaseline)->Iterations(counting_memory_manager::k_memory_iterations);
+
+/// Swallows the calibration run's report.
+struct silent_reporter : benchmark::BenchmarkReporter {
+    bool ReportContext(const Context &) override { return true; }
+    void ReportRuns(const std::vector<Run> &) override {}
+};
+
+} // namespace
+
+void counting_memory_manager::calibrate() {
+    silent_reporter silent;
+    benchmark::RunSpecifiedBenchmarks(&silent, "^BM_HarnessBaseline/");
+    d_baseline = d_last;
+}
+
+run_counts counting_memory_manager::last_run() const noexcept {
+    const auto less = [](auto value, auto baseline) -> decltype(value) {
+        return value > baseline ? value - baseline : 0;
+    };
+    return {less(d_last.allocs, d_baseline.allocs),
+            less(d_last.bytes, d_baseline.bytes),
+            {less(d_last.perf.instructions, d_baseline.perf.instructions),
+             less(d_last.perf.cycles, d_baseline.perf.cycles),
+             less(d_last.perf.cache_misses, d_baseline.perf.cache_misses)}};
+}
+
+counting_reporter::counting_reporter(counting_memory_manager *manager,
+                                     std::unique_ptr<benchmark::BenchmarkReporter> inner)
+    : d_inner(inner ? std::move(inner)
+                    : std::unique_ptr<benchmark::BenchmarkReporter>(
+                          benchmark::CreateDefaultDisplayReporter())),
+      d_manager(manager) {}
+
+bool counting_reporter::ReportContext(const Context &context) {
+    d_inner->SetOutputStream(&GetOutputStream());
+    d_inner->SetErrorStream(&GetErrorStream());
+    return d_inner->ReportContext(context);
+}
+
+void counting_reporter::ReportRuns(const std::vector<Run> &reports) {
+    std::vector<Run> counted = reports;
+    for (Run &run : counted) {
+        if (!run.memory_result || run.run_type != Run::RT_Iteration) {
+            continue;
+        }
+        const double iterations = static_cast<double>(
+            std::min<std::int64_t>(counting_memory_manager::k_memory_iterations, run.iterations));
+        const run_counts counts = d_manager->last_run();
+        run.counters["allocs/op"] = static_cast<double>(counts.allocs) / iterations;
+        run.counters["bytes/op"] = static_cast<double>(counts.bytes) / iterations;
+        if (d_manager->has_perf()) {
+            run.counters["instr/op"] = static_cast<double>(counts.perf.instructions) / iterations;
+            run.counters["cycles/op"] = static_cast<double>(counts.perf.cycles) / iterations;
+            run.counters["llc_miss/op"] =
+                static_cast<double>(counts.perf.cache_misses) / iterations;
+        }
+    }
+    d_inner->ReportRuns(counted);
+}
+
+void counting_reporter::Finalize() { d_inner->Finalize(); }
+
+bool json_out_requested(int argc, char **argv) {
+    bool out = false;
+    bool json = true;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg.starts_with("--benchmark_out=")) {
+            out = true;
+        } else if (arg.starts_with("--benchmark_out_format=")) {
+            json = arg == "--benchmark_out_format=json";
+        }
+    }
+    return out && json;
+}
+
+} // namespace bm
+
+// ============================================================================
+// GLOBAL OPERATOR NEW AND DELETE
+// ============================================================================
+
+void *operator new(std::size_t size) { return bm::counted_allocate_or_throw(size, 0); }
+void *operator new[](std::size_t size) { return bm::counted_allocate_or_throw(size, 0); }
+void *operator new(std::size_t size, std::align_val_t align) {
+    return bm::counted_allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+void *operator new[](std::size_t size, std::align_val_t align) {
+    return bm::counted_allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+    return bm::counted_allocate(size, 0);
+}
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+    return bm::counted_allocate(size, 0);
+}
+void *operator new(std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return bm::counted_allocate(size, static_cast<std::size_t>(align));
+}
+void *operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t &) noexcept {
+    return bm::counted_allocate(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void *ptr) noexcept { bm::counted_free(ptr); }
+void operator delete[](void *ptr) noexcept { bm::counted_free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { bm::counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { bm::counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t) noexcept { bm::counted_free(ptr); }
+void operator delete[](void *ptr, std::align_val_t) noexcept { bm::counted_free(ptr); }
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { bm::counted_free(ptr); }
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { bm::counted_free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { bm::counted_free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { bm::counted_free(ptr); }
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    bm::counted_free(ptr);
+}
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept {
+    bm::counted_free(ptr);
+}
@@ -1 +1,203 @@
-#pragma once
\ No newline at end of file
+#pragma once
+
+#include <local_shared_ptr.h>
+#include <shared_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace bm {
+
+/// Object managed by the smart pointer benchmarks. It is kept small so
+/// that the measured cost is dominated by the handle and control block.
+struct payload {
+    int d_value;
+
+    explicit payload(int value = 0) : d_value(value) {}
+};
+
+/// Smart pointer family under test. Benchmarks are written once as
+/// templates over a family so `ksl` and `std` run the exact same code.
+struct ksl_family {
+    template <typename T> using shared = ksl::shared_ptr<T>;
+    template <typename T> using weak = ksl::weak_ptr<T>;
+
+    template <typename T, typename... Args> static shared<T> make(Args &&...args) {
+        return ksl::make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename Alloc, typename... Args>
+    static shared<T> allocate(const Alloc &alloc, Args &&...args) {
+        return ksl::allocate_shared<T>(alloc, std::forward<Args>(args)...);
+    }
+};
+
+struct std_family {
+    template <typename T> using shared = std::shared_ptr<T>;
+    template <typename T> using weak = std::weak_ptr<T>;
+
+    template <typename T, typename... Args> static shared<T> make(Args &&...args) {
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    template <typename T, typename Alloc, typename... Args>
+    static shared<T> allocate(const Alloc &alloc, Args &&...args) {
+        return std::allocate_shared<T>(alloc, std::forward<Args>(args)...);
+    }
+};
+
+struct local_family {
+    template <typename T> using shared = ksl::local_shared_ptr<T>;
+    template <typename T> using weak = ksl::local_weak_ptr<T>;
+
+    template <typename T, typename... Args> static shared<T> make(Args &&...args) {
+        return ksl::make_local_shared<T>(std::forward<Args>(args)...);
+    }
+};
+
+/// Upper bound used by the multi-threaded benchmarks' ThreadRange().
+int max_threads();
+
+/// Number of handles created per batch in benchmarks that have to pause
+/// the timer, so the pause overhead is amortized.
+inline constexpr int k_batch_size = 1024;
+
+/// Keeps the calling thread on the CPUs of one NUMA node, as sysfs lists
+/// them, until the scope ends, then restores its affinity. Where they
+/// cannot be read or set, pinned() is false and the thread is left alone.
+class node_pin {
+    std::array<std::uint64_t, 16> d_saved{};
+    bool d_pinned = false;
+
+  public:
+    explicit node_pin(int node);
+
+    node_pin(const node_pin &) = delete;
+    node_pin &operator=(const node_pin &) = delete;
+
+    ~node_pin();
+
+    [[nodiscard]] bool pinned() const noexcept { return d_pinned; }
+};
+
+// ============================================================================
+// HARNESS COUNTERS
+// ============================================================================
+
+/// Heap activity of the calling thread, counted by the global operator new
+/// and operator delete that benchlib replaces. Bytes are what the
+/// allocator handed out, so a request may count a little more than it
+/// asked for.
+struct alloc_stats {
+    std::uint64_t allocs;
+    std::uint64_t frees;
+    std::uint64_t bytes;
+    /// Bytes allocated and not yet freed on this thread, and their peak
+    /// since the last reset_peak_live_bytes().
+    std::int64_t live_bytes;
+    std::int64_t peak_live_bytes;
+};
+
+[[nodiscard]] alloc_stats thread_alloc_stats() noexcept;
+
+void reset_peak_live_bytes() noexcept;
+
+/// Hardware counts of the calling thread over one measurement.
+struct perf_sample {
+    std::uint64_t instructions;
+    std::uint64_t cycles;
+    std::uint64_t cache_misses;
+};
+
+/// Instructions, cycles and last-level cache misses of the calling thread,
+/// read as one perf_event group on Linux, in user space only. Elsewhere,
+/// or where the kernel refuses (perf_event_paranoid, containers), the
+/// counters are unavailable and nothing is reported.
+class perf_counters {
+    int d_leader = -1;
+    int d_members[2] = {-1, -1};
+
+    void close() noexcept;
+
+  public:
+    perf_counters();
+    perf_counters(const perf_counters &) = delete;
+    perf_counters &operator=(const perf_counters &) = delete;
+    ~perf_counters();
+
+    [[nodiscard]] bool available() const noexcept { return d_leader >= 0; }
+
+    void start() noexcept;
+    [[nodiscard]] perf_sample stop() noexcept;
+};
+
+/// Counts of one memory run.
+struct run_counts {
+    std::int64_t allocs;
+    std::int64_t bytes;
+    perf_sample perf;
+};
+
+/// Google Benchmark measures memory in a separate run of up to
+/// k_memory_iterations iterations of each case, on the main thread, with
+/// a MemoryManager's Start() and Stop() around it. This one reports the
+/// allocations counted above and, when available, samples perf_counters
+/// over the same run.
+///
+/// The runner allocates for the run itself, and calibrate() measures that
+/// on a case that does nothing, to be taken off every other case. What a
+/// case allocates outside its loop is still counted, so the per-op numbers
+/// of a case that sets up a large state are an upper bound.
+class counting_memory_manager : public benchmark::MemoryManager {
+    alloc_stats d_start{};
+    perf_counters d_perf;
+    run_counts d_last{};
+    run_counts d_baseline{};
+
+  public:
+    static constexpr std::int64_t k_memory_iterations = 16;
+
+    void Start() override;
+    void Stop(Result *result) override;
+    void Stop(Result &result) override;
+
+    /// Runs the empty case, with this manager registered, for the runner's
+    /// own share of each memory run.
+    void calibrate();
+
+    [[nodiscard]] bool has_perf() const noexcept { return d_perf.available(); }
+
+    /// Counts of the last memory run, less the runner's, which the runner
+    /// reports before it starts the next case.
+    [[nodiscard]] run_counts last_run() const noexcept;
+};
+
+/// Another reporter, the display one by default, with the memory run's
+/// counts added to every case as per-iteration counters: allocs/op and
+/// bytes/op always, instr/op, cycles/op and llc_miss/op when perf is
+/// available.
+class counting_reporter : public benchmark::BenchmarkReporter {
+    std::unique_ptr<benchmark::BenchmarkReporter> d_inner;
+    counting_memory_manager *d_manager;
+
+  public:
+    explicit counting_reporter(counting_memory_manager *manager,
+                               std::unique_ptr<benchmark::BenchmarkReporter> inner = nullptr);
+
+    bool ReportContext(const Context &context) override;
+    void ReportRuns(const std::vector<Run> &reports) override;
+    void Finalize() override;
+};
+
+/// Whether the arguments ask for a JSON --benchmark_out file, the format
+/// build.sh writes, so the counters can go there too. Read before
+/// benchmark::Initialize() takes the flags out.
+[[nodiscard]] bool json_out_requested(int argc, char **argv);
+
+} // namespace bm
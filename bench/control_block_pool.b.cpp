@@ -0,0 +1,61 @@
+// Benchmarks for adopting raw pointers with pooled and heap control blocks.
+#include <bm.h>
+
+#include <control_block_pool.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+
+namespace {
+
+using bm::payload;
+
+/// Both variants allocate the payload with new, the difference is where the
+/// control block adopting it comes from.
+void BM_AdoptHeap(benchmark::State &state) {
+    for (auto _ : state) {
+        ksl::shared_ptr<payload> ptr(new payload(1));
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+
+void BM_AdoptPooled(benchmark::State &state) {
+    const ksl::control_block_pool_stats before = ksl::control_block_pool::stats();
+    for (auto _ : state) {
+        ksl::shared_ptr<payload> ptr(new payload(1), ksl::pooled);
+        benchmark::DoNotOptimize(ptr);
+    }
+    if (state.thread_index() == 0) {
+        const ksl::control_block_pool_stats after = ksl::control_block_pool::stats();
+        const double hits = static_cast<double>(after.hits - before.hits);
+        const double misses = static_cast<double>(after.misses - before.misses);
+        state.counters["pool_hit_rate"] = hits / std::max(1.0, hits + misses);
+    }
+}
+
+void BM_ResetPooledPolicy(benchmark::State &state) {
+    ksl::control_block_pool::set_enabled_by_default(true);
+    ksl::shared_ptr<payload> ptr(new payload(1));
+    for (auto _ : state) {
+        ptr.reset(new payload(2));
+        benchmark::DoNotOptimize(ptr);
+    }
+    ptr.reset();
+    ksl::control_block_pool::set_enabled_by_default(false);
+}
+
+void BM_ResetHeap(benchmark::State &state) {
+    ksl::shared_ptr<payload> ptr(new payload(1));
+    for (auto _ : state) {
+        ptr.reset(new payload(2));
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_AdoptHeap)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_AdoptPooled)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_ResetHeap);
+BENCHMARK(BM_ResetPooledPolicy);
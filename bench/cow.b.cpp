@@ -0,0 +1,73 @@
+// Benchmarks for handing a multi-KB read-mostly value to a consumer by deep
+// copy against handing it over as a ksl::cow, and for what a cow costs the
+// consumer that does write: one deep copy, the same as before, but only
+// then.
+#include <bm.h>
+
+#include <cow.h>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+/// Stand-in for a config or a routing table: one heap buffer of the
+/// benchmark's size.
+struct table {
+    std::vector<std::byte> d_bytes;
+
+    explicit table(std::size_t size) : d_bytes(size, std::byte{1}) {}
+};
+
+/// Handoff strategies, each starting from a source of the given size.
+struct deep_copy_strategy {
+    using handle = table;
+
+    static handle make(std::size_t size) { return table(size); }
+    static const std::byte *data(const handle &value) { return value.d_bytes.data(); }
+};
+
+struct cow_strategy {
+    using handle = ksl::cow<table>;
+
+    static handle make(std::size_t size) { return handle(std::in_place, size); }
+    static const std::byte *data(const handle &value) { return value->d_bytes.data(); }
+};
+
+template <typename Strategy> void BM_Handoff(benchmark::State &state) {
+    const auto source = Strategy::make(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        typename Strategy::handle copy = source;
+        benchmark::DoNotOptimize(Strategy::data(copy));
+    }
+}
+
+/// The consumer changes one byte of what it got: the cow clones it.
+void BM_HandoffCowWrite(benchmark::State &state) {
+    const auto source = cow_strategy::make(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        ksl::cow<table> copy = source;
+        copy.write().d_bytes[0] = std::byte{2};
+        benchmark::DoNotOptimize(cow_strategy::data(copy));
+    }
+}
+
+/// Every thread takes copies of one shared source, as workers picking up
+/// the current config would. The cow's threads all write one count.
+template <typename Strategy> void BM_HandoffShared(benchmark::State &state) {
+    static const auto source = Strategy::make(16 << 10);
+    for (auto _ : state) {
+        typename Strategy::handle copy = source;
+        benchmark::DoNotOptimize(Strategy::data(copy));
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Handoff, deep_copy_strategy)->RangeMultiplier(4)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_Handoff, cow_strategy)->RangeMultiplier(4)->Range(1 << 10, 1 << 16);
+BENCHMARK(BM_HandoffCowWrite)->RangeMultiplier(4)->Range(1 << 10, 1 << 16);
+BENCHMARK_TEMPLATE(BM_HandoffShared, deep_copy_strategy)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_HandoffShared, cow_strategy)->ThreadRange(1, bm::max_threads());
@@ -0,0 +1,75 @@
+// Release latency of the last owner of a large object graph: destroyed
+// inline by make_shared, or queued by make_shared_deferred and destroyed by
+// a later drain_deferred().
+#include <bm.h>
+
+#include <deferred_release.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+/// Root of a graph of state.range(0) nodes, as a parsed document or a
+/// scene would be.
+struct graph {
+    std::vector<ksl::shared_ptr<payload>> d_nodes;
+
+    explicit graph(std::size_t size) {
+        d_nodes.reserve(size);
+        for (std::size_t i = 0; i < size; ++i) {
+            d_nodes.push_back(ksl::make_shared<payload>(static_cast<int>(i)));
+        }
+    }
+};
+
+struct inline_release {
+    static ksl::shared_ptr<graph> make(std::size_t size) { return ksl::make_shared<graph>(size); }
+};
+
+struct deferred_release {
+    static ksl::shared_ptr<graph> make(std::size_t size) {
+        return ksl::make_shared_deferred<graph>(size);
+    }
+};
+
+/// Time spent by the thread dropping the last reference. The deferred
+/// queue is drained outside the timed region.
+template <typename Policy> void BM_ReleaseGraph(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        ksl::shared_ptr<graph> root = Policy::make(size);
+        state.ResumeTiming();
+
+        root.reset();
+
+        state.PauseTiming();
+        ksl::drain_deferred();
+        state.ResumeTiming();
+    }
+}
+
+/// Cost moved to the draining thread, per batch of released graphs.
+void BM_DrainDeferred(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int i = 0; i < 16; ++i) {
+            deferred_release::make(size).reset();
+        }
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(ksl::drain_deferred());
+    }
+    state.SetItemsProcessed(state.iterations() * 16);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ReleaseGraph, inline_release)->Arg(1)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK_TEMPLATE(BM_ReleaseGraph, deferred_release)->Arg(1)->Arg(1 << 10)->Arg(1 << 16);
+BENCHMARK(BM_DrainDeferred)->Arg(1)->Arg(1 << 10);
@@ -0,0 +1,92 @@
+// Contention benchmarks for short-lived reads of one object published
+// through ksl::shared_ptr: every thread reads the same object, via
+// weak_ptr::lock(), a shared_ptr copy, or a hazard pointer.
+#include <bm.h>
+
+#include <hazard_pointer.h>
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+
+namespace {
+
+using bm::payload;
+
+/// The object every reader goes for, owned by a shared_ptr and published
+/// as a raw pointer for the hazard pointer readers.
+struct published {
+    ksl::shared_ptr<payload> d_owner{ksl::make_shared<payload>(1)};
+    ksl::weak_ptr<payload> d_observer{d_owner};
+    std::atomic<payload *> d_slot{d_owner.get()};
+};
+
+published &shared_state() {
+    static published state;
+    return state;
+}
+
+void BM_ReadWeakLock(benchmark::State &state) {
+    published &shared = shared_state();
+    for (auto _ : state) {
+        ksl::shared_ptr<payload> locked = shared.d_observer.lock();
+        benchmark::DoNotOptimize(locked->d_value);
+    }
+}
+
+void BM_ReadSharedCopy(benchmark::State &state) {
+    published &shared = shared_state();
+    for (auto _ : state) {
+        ksl::shared_ptr<payload> copy = shared.d_owner;
+        benchmark::DoNotOptimize(copy->d_value);
+    }
+}
+
+/// A guard per read, as a reader with no state of its own would use it.
+void BM_ReadProtected(benchmark::State &state) {
+    published &shared = shared_state();
+    for (auto _ : state) {
+        ksl::protected_ptr<payload> guard(shared.d_slot);
+        benchmark::DoNotOptimize(guard->d_value);
+    }
+}
+
+/// One long-lived guard re-protecting on every read.
+void BM_ReadProtectedReused(benchmark::State &state) {
+    published &shared = shared_state();
+    ksl::protected_ptr<payload> guard;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(guard.protect(shared.d_slot)->d_value);
+    }
+}
+
+/// Read-mostly with updates: thread 0 republishes every 64 iterations and
+/// retires the previous owner, the other threads read through a guard.
+void BM_PublishProtected(benchmark::State &state) {
+    constexpr int k_reads_per_write = 64;
+    static ksl::shared_ptr<payload> owner = ksl::make_shared<payload>(0);
+    static std::atomic<payload *> slot{owner.get()};
+
+    const bool writer = state.thread_index() == 0;
+    ksl::protected_ptr<payload> guard;
+    int count = 0;
+    for (auto _ : state) {
+        if (writer && ++count == k_reads_per_write) {
+            ksl::shared_ptr<payload> next = ksl::make_shared<payload>(count);
+            slot.store(next.get());
+            owner.swap(next);
+            ksl::retire(std::move(next));
+            count = 0;
+        } else {
+            benchmark::DoNotOptimize(guard.protect(slot)->d_value);
+        }
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_ReadWeakLock)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_ReadSharedCopy)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_ReadProtected)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_ReadProtectedReused)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_PublishProtected)->ThreadRange(1, bm::max_threads());
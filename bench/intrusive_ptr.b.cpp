@@ -0,0 +1,100 @@
+// Benchmarks for ksl::intrusive_ptr against ksl::shared_ptr created with
+// make_shared and with a raw pointer. Every case reports the handle size and
+// the bytes allocated per object as counters.
+#include <bm.h>
+
+#include <intrusive_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+/// payload with its reference count embedded.
+struct intrusive_payload : ksl::intrusive_ref_counter<intrusive_payload> {
+    int d_value;
+
+    explicit intrusive_payload(int value = 0) : d_value(value) {}
+};
+
+/// Allocation strategies under test, with the bytes each one allocates
+/// per object on the global heap (excluding allocator overhead).
+struct intrusive_strategy {
+    using handle = ksl::intrusive_ptr<intrusive_payload>;
+
+    static constexpr std::size_t k_heap_bytes = sizeof(intrusive_payload);
+
+    static handle make(int value) { return ksl::make_intrusive<intrusive_payload>(value); }
+};
+
+struct make_shared_strategy {
+    using handle = ksl::shared_ptr<payload>;
+
+    static constexpr std::size_t k_heap_bytes =
+        sizeof(ksl::control_block_make_shared_impl<payload>);
+
+    static handle make(int value) { return ksl::make_shared<payload>(value); }
+};
+
+struct raw_shared_strategy {
+    using handle = ksl::shared_ptr<payload>;
+
+    static constexpr std::size_t k_heap_bytes =
+        sizeof(payload) + sizeof(ksl::control_block_impl<payload>);
+
+    static handle make(int value) { return handle(new payload(value)); }
+};
+
+template <typename Strategy> void report_sizes(benchmark::State &state) {
+    state.counters["handle_bytes"] = sizeof(typename Strategy::handle);
+    state.counters["heap_bytes"] = Strategy::k_heap_bytes;
+}
+
+template <typename Strategy> void BM_Create(benchmark::State &state) {
+    for (auto _ : state) {
+        auto ptr = Strategy::make(1);
+        benchmark::DoNotOptimize(ptr);
+    }
+    report_sizes<Strategy>(state);
+}
+
+template <typename Strategy> void BM_CopyHandle(benchmark::State &state) {
+    auto ptr = Strategy::make(1);
+    for (auto _ : state) {
+        auto copy = ptr;
+        benchmark::DoNotOptimize(copy);
+    }
+    report_sizes<Strategy>(state);
+}
+
+/// Walks a vector of handles, where the handle size decides how many fit in
+/// a cache line.
+template <typename Strategy> void BM_TraverseHandles(benchmark::State &state) {
+    std::vector<typename Strategy::handle> handles;
+    handles.reserve(bm::k_batch_size);
+    for (int i = 0; i < bm::k_batch_size; ++i) {
+        handles.push_back(Strategy::make(i));
+    }
+    for (auto _ : state) {
+        int sum = 0;
+        for (const auto &handle : handles) {
+            sum += handle->d_value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+    report_sizes<Strategy>(state);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Create, intrusive_strategy);
+BENCHMARK_TEMPLATE(BM_Create, make_shared_strategy);
+BENCHMARK_TEMPLATE(BM_Create, raw_shared_strategy);
+BENCHMARK_TEMPLATE(BM_CopyHandle, intrusive_strategy);
+BENCHMARK_TEMPLATE(BM_CopyHandle, make_shared_strategy);
+BENCHMARK_TEMPLATE(BM_TraverseHandles, intrusive_strategy);
+BENCHMARK_TEMPLATE(BM_TraverseHandles, make_shared_strategy);
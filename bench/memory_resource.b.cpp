@@ -0,0 +1,139 @@
+// Benchmarks for the ksl::pmr resources against the global new/delete, for
+// allocations the size of a make_shared control block, and for building and
+// tearing down a request-scoped object graph with allocate_shared.
+#include <bm.h>
+
+#include <memory_resource.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+/// make_shared<payload> block: the size the pools are meant for.
+constexpr std::size_t k_block_bytes = sizeof(ksl::control_block_make_shared_impl<payload>);
+constexpr std::size_t k_block_align = alignof(ksl::control_block_make_shared_impl<payload>);
+
+/// Resources under test, each created fresh per benchmark run.
+struct new_delete_strategy {
+    ksl::pmr::memory_resource *resource() { return ksl::pmr::new_delete_resource(); }
+};
+
+struct unsynchronized_pool_strategy {
+    ksl::pmr::unsynchronized_pool_resource d_resource;
+
+    ksl::pmr::memory_resource *resource() { return &d_resource; }
+};
+
+struct synchronized_pool_strategy {
+    ksl::pmr::synchronized_pool_resource d_resource;
+
+    ksl::pmr::memory_resource *resource() { return &d_resource; }
+};
+
+/// One allocation and its free, back to back: the pools hand the same
+/// block out again every time.
+template <typename Strategy> void BM_AllocateBlock(benchmark::State &state) {
+    Strategy strategy;
+    ksl::pmr::memory_resource *resource = strategy.resource();
+    for (auto _ : state) {
+        void *ptr = resource->allocate(k_block_bytes, k_block_align);
+        benchmark::DoNotOptimize(ptr);
+        resource->deallocate(ptr, k_block_bytes, k_block_align);
+    }
+    state.counters["block_bytes"] = k_block_bytes;
+}
+
+/// A batch of live blocks freed in allocation order, so the free list is
+/// exercised beyond its head.
+template <typename Strategy> void BM_AllocateBatch(benchmark::State &state) {
+    Strategy strategy;
+    ksl::pmr::memory_resource *resource = strategy.resource();
+    std::vector<void *> blocks(bm::k_batch_size);
+    for (auto _ : state) {
+        for (void *&block : blocks) {
+            block = resource->allocate(k_block_bytes, k_block_align);
+        }
+        benchmark::DoNotOptimize(blocks.data());
+        for (void *block : blocks) {
+            resource->deallocate(block, k_block_bytes, k_block_align);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+/// The monotonic resource never frees a block; the whole batch goes with
+/// one release().
+void BM_AllocateBatchMonotonic(benchmark::State &state) {
+    ksl::pmr::monotonic_buffer_resource resource;
+    for (auto _ : state) {
+        for (int i = 0; i < bm::k_batch_size; ++i) {
+            void *ptr = resource.allocate(k_block_bytes, k_block_align);
+            benchmark::DoNotOptimize(ptr);
+        }
+        resource.release();
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+/// shared_ptr objects built for one request and all dropped at its end.
+template <typename Strategy> void BM_RequestGraph(benchmark::State &state) {
+    Strategy strategy;
+    ksl::pmr::polymorphic_allocator<payload> alloc(strategy.resource());
+    std::vector<ksl::shared_ptr<payload>> graph;
+    graph.reserve(bm::k_batch_size);
+    for (auto _ : state) {
+        for (int i = 0; i < bm::k_batch_size; ++i) {
+            graph.push_back(ksl::allocate_shared<payload>(alloc, i));
+        }
+        benchmark::DoNotOptimize(graph.data());
+        graph.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+void BM_RequestGraphMonotonic(benchmark::State &state) {
+    ksl::pmr::monotonic_buffer_resource request;
+    ksl::pmr::polymorphic_allocator<payload> alloc(&request);
+    std::vector<ksl::shared_ptr<payload>> graph;
+    graph.reserve(bm::k_batch_size);
+    for (auto _ : state) {
+        for (int i = 0; i < bm::k_batch_size; ++i) {
+            graph.push_back(ksl::allocate_shared<payload>(alloc, i));
+        }
+        benchmark::DoNotOptimize(graph.data());
+        graph.clear();
+        request.release();
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+void BM_RequestGraphMakeShared(benchmark::State &state) {
+    std::vector<ksl::shared_ptr<payload>> graph;
+    graph.reserve(bm::k_batch_size);
+    for (auto _ : state) {
+        for (int i = 0; i < bm::k_batch_size; ++i) {
+            graph.push_back(ksl::make_shared<payload>(i));
+        }
+        benchmark::DoNotOptimize(graph.data());
+        graph.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_AllocateBlock, new_delete_strategy);
+BENCHMARK_TEMPLATE(BM_AllocateBlock, unsynchronized_pool_strategy);
+BENCHMARK_TEMPLATE(BM_AllocateBlock, synchronized_pool_strategy);
+BENCHMARK_TEMPLATE(BM_AllocateBatch, new_delete_strategy);
+BENCHMARK_TEMPLATE(BM_AllocateBatch, unsynchronized_pool_strategy);
+BENCHMARK_TEMPLATE(BM_AllocateBatch, synchronized_pool_strategy);
+BENCHMARK(BM_AllocateBatchMonotonic);
+BENCHMARK_TEMPLATE(BM_RequestGraph, new_delete_strategy);
+BENCHMARK_TEMPLATE(BM_RequestGraph, unsynchronized_pool_strategy);
+BENCHMARK(BM_RequestGraphMonotonic);
+BENCHMARK(BM_RequestGraphMakeShared);
@@ -0,0 +1,89 @@
+// Benchmarks for placing make_shared objects on a NUMA node: what the node
+// arenas cost on the allocation path against the global heap, and what a
+// reader pinned to the first node pays for objects on its own node against
+// objects on the last one. On a single-node host both placements are the
+// same node, and the pair only shows the noise.
+#include <bm.h>
+
+#include <numa_arena.h>
+#include <shared_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+/// Allocation paths under test.
+struct global_heap_strategy {
+    static ksl::shared_ptr<payload> make() { return ksl::make_shared<payload>(1); }
+};
+
+struct on_node_strategy {
+    static ksl::shared_ptr<payload> make() { return ksl::make_shared_on_node<payload>(0, 1); }
+};
+
+/// make_shared itself, sent to node 0 by the thread's preferred node.
+struct preferred_node_strategy {
+    static ksl::shared_ptr<payload> make() {
+        ksl::preferred_node_scope scope(0);
+        return ksl::make_shared<payload>(1);
+    }
+};
+
+template <typename Strategy> void BM_PlacedMakeShared(benchmark::State &state) {
+    for (auto _ : state) {
+        auto ptr = Strategy::make();
+        benchmark::DoNotOptimize(ptr.get());
+    }
+}
+
+/// A reader on node 0 copies and reads handles to 1M objects in random
+/// order: every lookup increments and decrements a count on the object's
+/// node and reads the object. Arg 0 puts the objects on node 0, arg 1 on
+/// the last node.
+void BM_CrossNodeRead(benchmark::State &state) {
+    const int object_node = state.range(0) == 0 ? 0 : ksl::numa_arena::node_count() - 1;
+    bm::node_pin pin(0);
+    constexpr std::size_t k_objects = std::size_t{1} << 20;
+
+    std::vector<ksl::shared_ptr<payload>> index;
+    index.reserve(k_objects);
+    for (std::size_t i = 0; i < k_objects; ++i) {
+        index.push_back(ksl::make_shared_on_node<payload>(object_node, static_cast<int>(i)));
+    }
+    std::vector<std::uint32_t> order(k_objects);
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(7));
+
+    for (auto _ : state) {
+        std::int64_t sum = 0;
+        for (std::uint32_t position : order) {
+            ksl::shared_ptr<payload> copy = index[position];
+            sum += copy->d_value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(k_objects));
+
+    const bool remote = object_node != ksl::numa_arena::current_node();
+    state.SetLabel(!pin.pinned() ? "unpinned" : remote ? "remote" : "local");
+    const ksl::numa_node_stats stats = ksl::numa_arena::stats(object_node);
+    state.counters["unbound_bytes"] = benchmark::Counter(
+        static_cast<double>(stats.unbound_bytes), benchmark::Counter::kDefaults,
+        benchmark::Counter::kIs1024);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_PlacedMakeShared, global_heap_strategy);
+BENCHMARK_TEMPLATE(BM_PlacedMakeShared, on_node_strategy);
+BENCHMARK_TEMPLATE(BM_PlacedMakeShared, preferred_node_strategy);
+BENCHMARK(BM_CrossNodeRead)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,66 @@
+// Benchmarks for ksl::object_pool against creating every object with
+// make_shared. The message owns a buffer, so a fresh object also pays for
+// the buffer's allocation, which a recycled one keeps.
+#include <bm.h>
+
+#include <object_pool.h>
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+constexpr std::size_t k_message_bytes = 256;
+
+struct message {
+    std::vector<char> d_buffer;
+
+    message() { d_buffer.reserve(k_message_bytes); }
+};
+
+struct clear_message {
+    void operator()(message &m) const noexcept { m.d_buffer.clear(); }
+};
+
+/// Strategies under test, shared by every thread of a run.
+struct pool_strategy {
+    static ksl::shared_ptr<message> make() {
+        static ksl::object_pool<message, clear_message> s_pool;
+        return s_pool.acquire();
+    }
+};
+
+struct make_shared_strategy {
+    static ksl::shared_ptr<message> make() { return ksl::make_shared<message>(); }
+};
+
+template <typename Strategy> void BM_AcquireRelease(benchmark::State &state) {
+    for (auto _ : state) {
+        auto ptr = Strategy::make();
+        ptr->d_buffer.push_back('x');
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+
+/// A batch held at once, so the pool recycles a whole working set instead
+/// of one hot object.
+template <typename Strategy> void BM_AcquireBatch(benchmark::State &state) {
+    std::vector<ksl::shared_ptr<message>> batch;
+    batch.reserve(bm::k_batch_size);
+    for (auto _ : state) {
+        for (int i = 0; i < bm::k_batch_size; ++i) {
+            batch.push_back(Strategy::make());
+        }
+        benchmark::DoNotOptimize(batch.data());
+        batch.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_AcquireRelease, pool_strategy)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_AcquireRelease, make_shared_strategy)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_AcquireBatch, pool_strategy);
+BENCHMARK_TEMPLATE(BM_AcquireBatch, make_shared_strategy);
@@ -0,0 +1,47 @@
+// Scaling curve for copying one hot object from 1 to 64 threads: a single
+// shared count (ksl::shared_ptr, std::shared_ptr) against the sharded count
+// of ksl::scalable_shared_ptr.
+#include <bm.h>
+
+#include <scalable_shared_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+using bm::payload;
+
+/// Upper end of the curve, independent of the machine running it so
+/// results from different hosts line up.
+constexpr int k_max_scaling_threads = 64;
+
+struct scalable_family {
+    template <typename T> using shared = ksl::scalable_shared_ptr<T>;
+
+    template <typename T, typename... Args> static shared<T> make(Args &&...args) {
+        return ksl::make_shared_scalable<T>(std::forward<Args>(args)...);
+    }
+};
+
+/// Every thread copies and drops handles to the same object, as readers of
+/// a global configuration would.
+template <typename Family> void BM_HotObjectCopy(benchmark::State &state) {
+    static const auto source = Family::template make<payload>(1);
+    for (auto _ : state) {
+        typename Family::template shared<payload> copy(source);
+        benchmark::DoNotOptimize(copy->d_value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_HotObjectCopy, bm::ksl_family)
+    ->ThreadRange(1, k_max_scaling_threads)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HotObjectCopy, bm::std_family)
+    ->ThreadRange(1, k_max_scaling_threads)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_HotObjectCopy, scalable_family)
+    ->ThreadRange(1, k_max_scaling_threads)
+    ->UseRealTime();
@@ -0,0 +1,424 @@
+// Benchmarks for ksl::shared_ptr / ksl::weak_ptr against std::shared_ptr, and
+// the single-threaded ksl::local_shared_ptr family against both.
+#include <bm.h>
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+// ============================================================================
+// CONSTRUCTION AND DESTRUCTION
+// ============================================================================
+
+template <typename Family> void BM_ConstructRaw(benchmark::State &state) {
+    for (auto _ : state) {
+        typename Family::template shared<payload> ptr(new payload(1));
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+
+template <typename Family> void BM_MakeShared(benchmark::State &state) {
+    for (auto _ : state) {
+        auto ptr = Family::template make<payload>(1);
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+
+/// Large enough for ksl::make_shared to allocate it apart from its block.
+struct large_payload {
+    int d_value;
+    unsigned char d_bytes[4096];
+
+    explicit large_payload(int value = 0) : d_value(value) {}
+};
+
+/// A cache entry's life: created, observed by a weak_ptr, and expired while
+/// the weak_ptr remains. ksl pays a second allocation up front and frees the
+/// 4 KB payload at expiry; std keeps it until the weak_ptr goes.
+template <typename Family> void BM_MakeSharedLargeWithWeak(benchmark::State &state) {
+    for (auto _ : state) {
+        typename Family::template weak<large_payload> observer =
+            Family::template make<large_payload>(1);
+        benchmark::DoNotOptimize(observer);
+    }
+}
+
+/// allocate_shared from a per-request style arena: the monotonic resource is
+/// rewound every batch, so no iteration goes to the global heap.
+template <typename Family> void BM_AllocateSharedMonotonic(benchmark::State &state) {
+    std::pmr::monotonic_buffer_resource arena(64 * bm::k_batch_size);
+    std::pmr::polymorphic_allocator<payload> alloc(&arena);
+    int count = 0;
+    for (auto _ : state) {
+        auto ptr = Family::template allocate<payload>(alloc, 1);
+        benchmark::DoNotOptimize(ptr);
+        ptr.reset();
+        if (++count == bm::k_batch_size) {
+            arena.release();
+            count = 0;
+        }
+    }
+}
+
+/// Shared sample buffers: one allocation with make_shared<T[]> against
+/// new T[n] plus a separate control block. The argument is the element count.
+void BM_ArrayAdoptNew(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        ksl::shared_ptr<float[]> samples(new float[size]);
+        benchmark::DoNotOptimize(samples.get());
+    }
+}
+
+void BM_ArrayMakeShared(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        auto samples = ksl::make_shared<float[]>(size);
+        benchmark::DoNotOptimize(samples.get());
+    }
+}
+
+void BM_ArrayMakeSharedForOverwrite(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        auto samples = ksl::make_shared_for_overwrite<float[]>(size);
+        benchmark::DoNotOptimize(samples.get());
+    }
+}
+
+template <typename Family> void BM_Destroy(benchmark::State &state) {
+    using shared = typename Family::template shared<payload>;
+    std::vector<shared> ptrs;
+    ptrs.reserve(bm::k_batch_size);
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int i = 0; i < bm::k_batch_size; ++i) {
+            ptrs.push_back(Family::template make<payload>(i));
+        }
+        state.ResumeTiming();
+        ptrs.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * bm::k_batch_size);
+}
+
+// ============================================================================
+// COPY, MOVE AND RESET
+// ============================================================================
+
+template <typename Family> void BM_Copy(benchmark::State &state) {
+    auto source = Family::template make<payload>(1);
+    for (auto _ : state) {
+        typename Family::template shared<payload> copy(source);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+template <typename Family> void BM_Move(benchmark::State &state) {
+    auto first = Family::template make<payload>(1);
+    for (auto _ : state) {
+        typename Family::template shared<payload> second(std::move(first));
+        benchmark::DoNotOptimize(second);
+        first = std::move(second);
+    }
+}
+
+template <typename Family> void BM_Reset(benchmark::State &state) {
+    typename Family::template shared<payload> ptr(new payload(1));
+    for (auto _ : state) {
+        ptr.reset(new payload(2));
+        benchmark::DoNotOptimize(ptr);
+    }
+}
+
+// ============================================================================
+// WEAK_PTR LOCK
+// ============================================================================
+
+template <typename Family> void BM_WeakLock(benchmark::State &state) {
+    auto owner = Family::template make<payload>(1);
+    typename Family::template weak<payload> weak(owner);
+    for (auto _ : state) {
+        auto locked = weak.lock();
+        benchmark::DoNotOptimize(locked);
+    }
+}
+
+template <typename Family> void BM_WeakLockExpired(benchmark::State &state) {
+    typename Family::template weak<payload> weak;
+    {
+        auto owner = Family::template make<payload>(1);
+        weak = owner;
+    }
+    for (auto _ : state) {
+        auto locked = weak.lock();
+        benchmark::DoNotOptimize(locked);
+    }
+}
+
+/// Handing out an owner from inside the object, against copying a handle.
+struct ksl_self_payload : ksl::enable_shared_from_this<ksl_self_payload> {
+    int d_value = 0;
+};
+
+struct std_self_payload : std::enable_shared_from_this<std_self_payload> {
+    int d_value = 0;
+};
+
+template <typename Family, typename Self> void BM_SharedFromThis(benchmark::State &state) {
+    auto owner = Family::template make<Self>();
+    Self *object = owner.get();
+    for (auto _ : state) {
+        auto self = object->shared_from_this();
+        benchmark::DoNotOptimize(self);
+    }
+}
+
+// ============================================================================
+// CONVERSIONS AND CASTS
+// ============================================================================
+
+struct base_payload {
+    int d_value = 0;
+
+    virtual ~base_payload() = default;
+};
+
+struct derived_payload : base_payload {};
+
+/// Dispatch through a base handle when the caller keeps its own handle: a
+/// cast that takes a new reference, then drops it.
+void BM_StaticCastCopy(benchmark::State &state) {
+    ksl::shared_ptr<derived_payload> derived = ksl::make_shared<derived_payload>();
+    for (auto _ : state) {
+        ksl::shared_ptr<base_payload> base = ksl::static_pointer_cast<base_payload>(derived);
+        benchmark::DoNotOptimize(base);
+    }
+}
+
+/// The same round trip with the handle handed down by value: every cast
+/// moves the reference, so no count is touched.
+void BM_StaticCastMove(benchmark::State &state) {
+    ksl::shared_ptr<derived_payload> derived = ksl::make_shared<derived_payload>();
+    for (auto _ : state) {
+        ksl::shared_ptr<base_payload> base =
+            ksl::static_pointer_cast<base_payload>(std::move(derived));
+        benchmark::DoNotOptimize(base);
+        derived = ksl::static_pointer_cast<derived_payload>(std::move(base));
+    }
+}
+
+void BM_DynamicCastCopy(benchmark::State &state) {
+    ksl::shared_ptr<base_payload> base = ksl::make_shared<derived_payload>();
+    for (auto _ : state) {
+        auto derived = ksl::dynamic_pointer_cast<derived_payload>(base);
+        benchmark::DoNotOptimize(derived);
+    }
+}
+
+void BM_DynamicCastMove(benchmark::State &state) {
+    ksl::shared_ptr<base_payload> base = ksl::make_shared<derived_payload>();
+    for (auto _ : state) {
+        auto derived = ksl::dynamic_pointer_cast<derived_payload>(std::move(base));
+        benchmark::DoNotOptimize(derived);
+        base = std::move(derived);
+    }
+}
+
+// ============================================================================
+// MULTI-THREADED COPY AND RELEASE
+// ============================================================================
+
+/// Every thread copies and releases the same handle, so all of them
+/// contend on one control block.
+template <typename Family> void BM_ContendedCopy(benchmark::State &state) {
+    static const auto source = Family::template make<payload>(1);
+    for (auto _ : state) {
+        typename Family::template shared<payload> copy(source);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+/// Every thread copies its own handle, so there is no sharing between
+/// threads and only the cost of the atomic operations themselves shows.
+template <typename Family> void BM_UncontendedCopy(benchmark::State &state) {
+    auto source = Family::template make<payload>(1);
+    for (auto _ : state) {
+        typename Family::template shared<payload> copy(source);
+        benchmark::DoNotOptimize(copy);
+    }
+}
+
+// ============================================================================
+// FAN-OUT
+// ============================================================================
+
+/// One message broadcast to state.range(0) subscribers and dropped by all
+/// of them: n increments and n decrements on its count.
+void BM_FanOutCopy(benchmark::State &state) {
+    const auto subscribers = static_cast<std::size_t>(state.range(0));
+    static const auto source = ksl::make_shared<payload>(1);
+    std::vector<ksl::shared_ptr<payload>> inboxes;
+    inboxes.reserve(subscribers);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < subscribers; ++i) {
+            inboxes.push_back(source);
+        }
+        benchmark::DoNotOptimize(inboxes.data());
+        inboxes.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// The same broadcast with share_n and release_n: one increment and one
+/// decrement, however many subscribers.
+void BM_FanOutBatched(benchmark::State &state) {
+    const auto subscribers = static_cast<std::size_t>(state.range(0));
+    static const auto source = ksl::make_shared<payload>(1);
+    std::vector<ksl::shared_ptr<payload>> inboxes;
+    inboxes.reserve(subscribers);
+    for (auto _ : state) {
+        ksl::share_n(source, subscribers, std::back_inserter(inboxes));
+        benchmark::DoNotOptimize(inboxes.data());
+        ksl::release_n(inboxes.begin(), subscribers);
+        inboxes.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// ============================================================================
+// CONTROL BLOCK LAYOUT UNDER WRITES
+// ============================================================================
+
+/// Shared object its owners keep writing to, as statistics or a cursor.
+struct hot_object {
+    std::atomic<long> d_writes{0};
+};
+
+struct compact_layout {
+    static ksl::shared_ptr<hot_object> make() { return ksl::make_shared<hot_object>(); }
+};
+
+struct padded_layout {
+    static ksl::shared_ptr<hot_object> make() {
+        return ksl::make_shared<hot_object>(ksl::padded_layout);
+    }
+};
+
+/// Even threads write the object, odd threads copy and release handles to
+/// it. With the compact layout both hit the same cache line although they
+/// touch different data; the padded layout moves the object off the
+/// counters' line.
+template <typename Layout> void BM_WriteWhileCopying(benchmark::State &state) {
+    static const ksl::shared_ptr<hot_object> source = Layout::make();
+    if (state.thread_index() % 2 == 0) {
+        for (auto _ : state) {
+            source->d_writes.fetch_add(1, std::memory_order_relaxed);
+        }
+    } else {
+        for (auto _ : state) {
+            ksl::shared_ptr<hot_object> copy(source);
+            benchmark::DoNotOptimize(copy);
+        }
+    }
+}
+
+/// Single-threaded cost of the larger, over-aligned allocation.
+template <typename Layout> void BM_MakeSharedLayout(benchmark::State &state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Layout::make());
+    }
+}
+
+// ============================================================================
+// COUNTER MEMORY ORDERING
+// ============================================================================
+
+/// Orderings used by a reference count before and after moving the control
+/// block counters off the seq_cst defaults.
+struct seq_cst_ordering {
+    static constexpr std::memory_order k_increment = std::memory_order_seq_cst;
+    static constexpr std::memory_order k_decrement = std::memory_order_seq_cst;
+};
+
+struct relaxed_ordering {
+    static constexpr std::memory_order k_increment = std::memory_order_relaxed;
+    static constexpr std::memory_order k_decrement = std::memory_order_acq_rel;
+};
+
+/// A copy storm reduced to its counter traffic: every thread takes and drops
+/// a reference on one shared count. On x86 both orderings compile to the same
+/// locked instruction, on ARM the seq_cst version adds full barriers.
+template <typename Ordering> void BM_CopyStormCounter(benchmark::State &state) {
+    static std::atomic<std::size_t> count{1};
+    for (auto _ : state) {
+        count.fetch_add(1, Ordering::k_increment);
+        benchmark::DoNotOptimize(count.fetch_sub(1, Ordering::k_decrement));
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ConstructRaw, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_ConstructRaw, bm::std_family);
+BENCHMARK_TEMPLATE(BM_ConstructRaw, bm::local_family);
+BENCHMARK_TEMPLATE(BM_MakeShared, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_MakeShared, bm::std_family);
+BENCHMARK_TEMPLATE(BM_MakeShared, bm::local_family);
+BENCHMARK_TEMPLATE(BM_MakeSharedLargeWithWeak, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_MakeSharedLargeWithWeak, bm::std_family);
+BENCHMARK_TEMPLATE(BM_AllocateSharedMonotonic, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_AllocateSharedMonotonic, bm::std_family);
+BENCHMARK(BM_ArrayAdoptNew)->Arg(16)->Arg(4096);
+BENCHMARK(BM_ArrayMakeShared)->Arg(16)->Arg(4096);
+BENCHMARK(BM_ArrayMakeSharedForOverwrite)->Arg(16)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_Destroy, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_Destroy, bm::std_family);
+BENCHMARK_TEMPLATE(BM_Destroy, bm::local_family);
+
+BENCHMARK_TEMPLATE(BM_Copy, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_Copy, bm::std_family);
+BENCHMARK_TEMPLATE(BM_Copy, bm::local_family);
+BENCHMARK_TEMPLATE(BM_Move, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_Move, bm::std_family);
+BENCHMARK_TEMPLATE(BM_Move, bm::local_family);
+BENCHMARK_TEMPLATE(BM_Reset, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_Reset, bm::std_family);
+BENCHMARK_TEMPLATE(BM_Reset, bm::local_family);
+
+BENCHMARK_TEMPLATE(BM_WeakLock, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_WeakLock, bm::std_family);
+BENCHMARK_TEMPLATE(BM_WeakLock, bm::local_family);
+BENCHMARK_TEMPLATE(BM_WeakLockExpired, bm::ksl_family);
+BENCHMARK_TEMPLATE(BM_WeakLockExpired, bm::std_family);
+BENCHMARK_TEMPLATE(BM_WeakLockExpired, bm::local_family);
+BENCHMARK_TEMPLATE(BM_SharedFromThis, bm::ksl_family, ksl_self_payload);
+BENCHMARK_TEMPLATE(BM_SharedFromThis, bm::std_family, std_self_payload);
+
+BENCHMARK(BM_StaticCastCopy);
+BENCHMARK(BM_StaticCastMove);
+BENCHMARK(BM_DynamicCastCopy);
+BENCHMARK(BM_DynamicCastMove);
+
+BENCHMARK_TEMPLATE(BM_ContendedCopy, bm::ksl_family)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_ContendedCopy, bm::std_family)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_UncontendedCopy, bm::ksl_family)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_UncontendedCopy, bm::std_family)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_UncontendedCopy, bm::local_family)->ThreadRange(1, bm::max_threads());
+
+BENCHMARK(BM_FanOutCopy)->Arg(1)->Arg(16)->Arg(256)->ThreadRange(1, bm::max_threads());
+BENCHMARK(BM_FanOutBatched)->Arg(1)->Arg(16)->Arg(256)->ThreadRange(1, bm::max_threads());
+
+BENCHMARK_TEMPLATE(BM_WriteWhileCopying, compact_layout)->ThreadRange(2, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_WriteWhileCopying, padded_layout)->ThreadRange(2, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_MakeSharedLayout, compact_layout);
+BENCHMARK_TEMPLATE(BM_MakeSharedLayout, padded_layout);
+
+BENCHMARK_TEMPLATE(BM_CopyStormCounter, seq_cst_ordering)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_CopyStormCounter, relaxed_ordering)->ThreadRange(1, bm::max_threads());
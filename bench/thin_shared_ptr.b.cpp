@@ -0,0 +1,111 @@
+// Benchmarks for an index of handles to millions of small objects, held as
+// ksl::thin_shared_ptr against ksl::shared_ptr and std::shared_ptr: the
+// memory the index takes, and reading the objects through it in order and
+// in random order.
+#include <bm.h>
+
+#include <thin_shared_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+/// Handle types under test, each made with its one-allocation factory.
+struct thin_strategy {
+    using handle = ksl::thin_shared_ptr<payload>;
+
+    static handle make(int value) { return ksl::make_thin_shared<payload>(value); }
+};
+
+struct shared_strategy {
+    using handle = ksl::shared_ptr<payload>;
+
+    static handle make(int value) { return ksl::make_shared<payload>(value); }
+};
+
+struct std_shared_strategy {
+    using handle = std::shared_ptr<payload>;
+
+    static handle make(int value) { return std::make_shared<payload>(value); }
+};
+
+template <typename Strategy> std::vector<typename Strategy::handle> make_index(std::size_t size) {
+    std::vector<typename Strategy::handle> index;
+    index.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        index.push_back(Strategy::make(static_cast<int>(i)));
+    }
+    return index;
+}
+
+void set_index_counters(benchmark::State &state, std::size_t handle_size) {
+    state.counters["index_bytes"] = benchmark::Counter(
+        static_cast<double>(state.range(0)) * static_cast<double>(handle_size),
+        benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// Building the index: one block per object, and the index's own storage.
+template <typename Strategy> void BM_IndexBuild(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        auto index = make_index<Strategy>(size);
+        benchmark::DoNotOptimize(index.data());
+    }
+    set_index_counters(state, sizeof(typename Strategy::handle));
+}
+
+/// Reads every object in index order. Blocks were allocated in that order,
+/// so this streams through the index and the heap alike.
+template <typename Strategy> void BM_IndexScan(benchmark::State &state) {
+    const auto index = make_index<Strategy>(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        std::int64_t sum = 0;
+        for (const auto &handle : index) {
+            sum += handle->d_value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    set_index_counters(state, sizeof(typename Strategy::handle));
+}
+
+/// Reads every object in a random order: one miss on the index and one on
+/// the object per lookup once neither fits in cache.
+template <typename Strategy> void BM_IndexChase(benchmark::State &state) {
+    const auto size = static_cast<std::size_t>(state.range(0));
+    const auto index = make_index<Strategy>(size);
+    std::vector<std::uint32_t> order(size);
+    std::iota(order.begin(), order.end(), 0u);
+    std::shuffle(order.begin(), order.end(), std::mt19937_64(42));
+
+    for (auto _ : state) {
+        std::int64_t sum = 0;
+        for (std::uint32_t position : order) {
+            sum += index[position]->d_value;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    set_index_counters(state, sizeof(typename Strategy::handle));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_IndexBuild, thin_strategy)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_IndexBuild, shared_strategy)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_IndexBuild, std_shared_strategy)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_IndexScan, thin_strategy)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(BM_IndexScan, shared_strategy)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(BM_IndexScan, std_shared_strategy)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(BM_IndexChase, thin_strategy)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(BM_IndexChase, shared_strategy)->Arg(1 << 16)->Arg(1 << 21);
+BENCHMARK_TEMPLATE(BM_IndexChase, std_shared_strategy)->Arg(1 << 16)->Arg(1 << 21);
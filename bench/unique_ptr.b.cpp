@@ -0,0 +1,104 @@
+// Benchmarks for ksl::unique_ptr against a raw owning pointer and
+// std::unique_ptr, and for promoting unique ownership to shared_ptr. The
+// unique handles should match the raw pointer case: same size, same code.
+#include <bm.h>
+
+#include <unique_ptr.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <utility>
+
+namespace {
+
+using bm::payload;
+
+/// Ways of holding one payload uniquely, with the handle type reported as
+/// the handle_bytes counter.
+struct raw_strategy {
+    using handle = payload *;
+
+    static handle make(int value) { return new payload(value); }
+    static void destroy(handle &ptr) { delete ptr; }
+    static handle pass(handle ptr) { return ptr; }
+};
+
+struct ksl_strategy {
+    using handle = ksl::unique_ptr<payload>;
+
+    static handle make(int value) { return ksl::make_unique<payload>(value); }
+    static void destroy(handle &ptr) { ptr.reset(); }
+    static handle pass(handle ptr) { return ptr; }
+};
+
+struct std_strategy {
+    using handle = std::unique_ptr<payload>;
+
+    static handle make(int value) { return std::make_unique<payload>(value); }
+    static void destroy(handle &ptr) { ptr.reset(); }
+    static handle pass(handle ptr) { return ptr; }
+};
+
+template <typename Strategy> void BM_UniqueCreate(benchmark::State &state) {
+    for (auto _ : state) {
+        auto ptr = Strategy::make(1);
+        benchmark::DoNotOptimize(ptr);
+        Strategy::destroy(ptr);
+    }
+    state.counters["handle_bytes"] = sizeof(typename Strategy::handle);
+}
+
+/// Hands ownership down calls the optimizer cannot see through. A handle
+/// with a destructor is passed by address under the Itanium ABI, std's as
+/// much as ours, so this is the one place a raw pointer can still win.
+template <typename Strategy> [[gnu::noinline]] auto hand_over(typename Strategy::handle ptr) {
+    benchmark::DoNotOptimize(ptr);
+    return Strategy::pass(std::move(ptr));
+}
+
+template <typename Strategy> void BM_UniqueHandOver(benchmark::State &state) {
+    auto ptr = Strategy::make(1);
+    for (auto _ : state) {
+        ptr = hand_over<Strategy>(std::move(ptr));
+        ptr = hand_over<Strategy>(std::move(ptr));
+        benchmark::DoNotOptimize(ptr->d_value);
+    }
+    Strategy::destroy(ptr);
+    state.counters["handle_bytes"] = sizeof(typename Strategy::handle);
+}
+
+/// Building unique and sharing at the handoff point costs one extra
+/// allocation for the control block, compared with make_shared.
+void BM_PromoteUniqueToShared(benchmark::State &state) {
+    for (auto _ : state) {
+        ksl::shared_ptr<payload> shared(ksl::make_unique<payload>(1));
+        benchmark::DoNotOptimize(shared);
+    }
+}
+
+void BM_PromoteStdUniqueToShared(benchmark::State &state) {
+    for (auto _ : state) {
+        std::shared_ptr<payload> shared(std::make_unique<payload>(1));
+        benchmark::DoNotOptimize(shared);
+    }
+}
+
+void BM_MakeSharedDirectly(benchmark::State &state) {
+    for (auto _ : state) {
+        auto shared = ksl::make_shared<payload>(1);
+        benchmark::DoNotOptimize(shared);
+    }
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_UniqueCreate, raw_strategy);
+BENCHMARK_TEMPLATE(BM_UniqueCreate, ksl_strategy);
+BENCHMARK_TEMPLATE(BM_UniqueCreate, std_strategy);
+BENCHMARK_TEMPLATE(BM_UniqueHandOver, raw_strategy);
+BENCHMARK_TEMPLATE(BM_UniqueHandOver, ksl_strategy);
+BENCHMARK_TEMPLATE(BM_UniqueHandOver, std_strategy);
+BENCHMARK(BM_PromoteUniqueToShared);
+BENCHMARK(BM_PromoteStdUniqueToShared);
+BENCHMARK(BM_MakeSharedDirectly);
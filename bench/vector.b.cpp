@@ -0,0 +1,88 @@
+// Benchmarks for growing vectors of millions of handles: ksl::vector
+// relocates ksl::shared_ptrs with memcpy, where std::vector runs a move
+// constructor and a destructor for each.
+#include <bm.h>
+
+#include <vector.h>
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+/// Containers under test, all holding handles to one shared object.
+struct ksl_vector_strategy {
+    using handle = ksl::shared_ptr<payload>;
+    using container = ksl::vector<handle>;
+
+    static handle make() { return ksl::make_shared<payload>(1); }
+};
+
+struct std_vector_strategy {
+    using handle = ksl::shared_ptr<payload>;
+    using container = std::vector<handle>;
+
+    static handle make() { return ksl::make_shared<payload>(1); }
+};
+
+struct std_vector_std_ptr_strategy {
+    using handle = std::shared_ptr<payload>;
+    using container = std::vector<handle>;
+
+    static handle make() { return std::make_shared<payload>(1); }
+};
+
+/// Fills a vector from empty, with every doubling of its storage on the
+/// way. Copying the handles in and destroying them is the same work for
+/// every container; only the relocation differs.
+template <typename Strategy> void BM_GrowByPushBack(benchmark::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const auto source = Strategy::make();
+    for (auto _ : state) {
+        typename Strategy::container handles;
+        for (std::size_t i = 0; i < count; ++i) {
+            handles.push_back(source);
+        }
+        benchmark::DoNotOptimize(handles.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/// One reallocation of a full vector, timed on its own.
+template <typename Strategy> void BM_Reallocate(benchmark::State &state) {
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const auto source = Strategy::make();
+    for (auto _ : state) {
+        state.PauseTiming();
+        typename Strategy::container handles;
+        handles.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            handles.push_back(source);
+        }
+        state.ResumeTiming();
+
+        handles.reserve(2 * count);
+        benchmark::DoNotOptimize(handles.data());
+
+        state.PauseTiming();
+        handles = typename Strategy::container();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_GrowByPushBack, ksl_vector_strategy)->Arg(1 << 20)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_GrowByPushBack, std_vector_strategy)->Arg(1 << 20)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_GrowByPushBack, std_vector_std_ptr_strategy)->Arg(1 << 20)->Arg(1 << 22);
+BENCHMARK_TEMPLATE(BM_Reallocate, ksl_vector_strategy)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_Reallocate, std_vector_strategy)->Arg(1 << 12)->Arg(1 << 16)->Arg(1 << 20);
+BENCHMARK_TEMPLATE(BM_Reallocate, std_vector_std_ptr_strategy)
+    ->Arg(1 << 12)
+    ->Arg(1 << 16)
+    ->Arg(1 << 20);
@@ -0,0 +1,102 @@
+// Benchmarks for ksl::weak_cache against one mutex around one map, under
+// Zipfian key popularity: a few hot keys take most lookups, so with a
+// single lock every thread queues on it, while the sharded cache only
+// shares a shard's lock (in shared mode) between readers of the same keys.
+#include <bm.h>
+
+#include <weak_cache.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using bm::payload;
+
+constexpr int k_keys = 1 << 14;
+/// Keys drawn in advance per thread, so the generator stays off the
+/// measured path.
+constexpr std::size_t k_draws = 1 << 16;
+/// Zipf exponent: close to 1, as commonly seen for cache traffic.
+constexpr double k_skew = 0.99;
+
+/// k_draws keys where key k, 0 being the hottest, has a probability
+/// proportional to 1 / (k + 1)^k_skew.
+std::vector<int> zipf_keys(std::uint64_t seed) {
+    std::vector<double> cdf(k_keys);
+    double sum = 0.0;
+    for (int k = 0; k < k_keys; ++k) {
+        sum += 1.0 / std::pow(static_cast<double>(k + 1), k_skew);
+        cdf[static_cast<std::size_t>(k)] = sum;
+    }
+
+    std::mt19937_64 engine(seed);
+    std::uniform_real_distribution<double> uniform(0.0, sum);
+    std::vector<int> keys(k_draws);
+    for (int &key : keys) {
+        const auto it = std::lower_bound(cdf.begin(), cdf.end(), uniform(engine));
+        key = static_cast<int>(std::min<std::ptrdiff_t>(it - cdf.begin(), k_keys - 1));
+    }
+    return keys;
+}
+
+/// Caches under test, each with get_or_create(key, factory).
+using sharded_cache = ksl::weak_cache<int, payload>;
+
+class single_mutex_cache {
+    std::mutex d_mutex;
+    std::unordered_map<int, ksl::weak_ptr<payload>> d_entries;
+
+  public:
+    template <typename Factory>
+    ksl::shared_ptr<payload> get_or_create(int key, Factory &&factory) {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        ksl::weak_ptr<payload> &entry = d_entries[key];
+        ksl::shared_ptr<payload> value = entry.lock();
+        if (!value) {
+            value = factory();
+            entry = value;
+        }
+        return value;
+    }
+};
+
+/// Zipfian lookups of a cache whose hottest k_keys >> HeldShift values are
+/// owned elsewhere for the whole run. With HeldShift 0 every lookup hits;
+/// with more, lookups of the cold keys make a value that expires at once.
+template <typename Cache, int HeldShift> void BM_ZipfLookup(benchmark::State &state) {
+    static Cache s_cache;
+    static const std::vector<ksl::shared_ptr<payload>> s_owners = [] {
+        std::vector<ksl::shared_ptr<payload>> owners;
+        for (int key = 0; key < (k_keys >> HeldShift); ++key) {
+            owners.push_back(
+                s_cache.get_or_create(key, [key] { return ksl::make_shared<payload>(key); }));
+        }
+        return owners;
+    }();
+
+    const std::vector<int> keys = zipf_keys(static_cast<std::uint64_t>(state.thread_index()));
+    std::size_t next = 0;
+    for (auto _ : state) {
+        const int key = keys[next];
+        next = (next + 1) % k_draws;
+        ksl::shared_ptr<payload> value =
+            s_cache.get_or_create(key, [key] { return ksl::make_shared<payload>(key); });
+        benchmark::DoNotOptimize(value);
+    }
+    benchmark::DoNotOptimize(s_owners.data());
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_ZipfLookup, sharded_cache, 0)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_ZipfLookup, single_mutex_cache, 0)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_ZipfLookup, sharded_cache, 3)->ThreadRange(1, bm::max_threads());
+BENCHMARK_TEMPLATE(BM_ZipfLookup, single_mutex_cache, 3)->ThreadRange(1, bm::max_threads());
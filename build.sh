@@ -17,18 +17,23 @@ while [[ $# -gt 0 ]]; do
             BUILD_TYPE="Release"
             shift
             ;;
+        --memory-trace)
+            # Builds groups/memory with KSL_MEMORY_TRACE lifetime tracing
+            CMAKE_ARGS+=("-DENABLE_MEMORY_TRACE=ON")
+            shift
+            ;;
         --action=*)
             IFS=',' read -r -a ACTIONS <<< "${1#--action=}"
             shift
             ;;
         -D*)
-            IFS=',' read -r -a CMAKE_ARGS <<< "${1#-D}"
-            # echo "-D option detected, adding to CMake args: $1"
+            # -Dthread,undefined selects the sanitizers applied by CMake
+            CMAKE_ARGS+=("-DSANITIZERS=${1#-D}")
             shift
             ;;
         *)
             echo "❌ Unknown option: $1"
-            echo "Usage: $0 [--debug|--release] [--action=clean,build,ctest] options: [-Dundefined,address,leak,thread]"
+            echo "Usage: $0 [--debug|--release] [--memory-trace] [--action=clean,build,ctest,bench] options: [-Dundefined,address,leak,thread]"
             exit 1
             ;;
     esac
@@ -65,9 +70,19 @@ for ACTION in "${ACTIONS[@]}"; do
             cd - > /dev/null
             echo "✅ Tests run completed"
             ;;
+        bench)
+            if [[ ! -x "$BUILD_DIR/bench/bench.tsk" ]]; then
+                echo "⚠️ Benchmark binary not found. Please build first"
+                exit 1
+            fi
+            BENCH_OUT="$BUILD_DIR/bench.json"
+            echo "⏱️ Running benchmarks in $BUILD_DIR, JSON results in $BENCH_OUT..."
+            "$BUILD_DIR/bench/bench.tsk" --benchmark_out="$BENCH_OUT" --benchmark_out_format=json
+            echo "✅ Benchmark run completed"
+            ;;
         *)
             echo "❌ Unknown action: $ACTION"
-            echo "Allowed actions: build, clean, ctest"
+            echo "Allowed actions: build, clean, ctest, bench"
             exit 1
             ;;
     esac
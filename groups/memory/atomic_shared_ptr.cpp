@@ -0,0 +1 @@
+#include <atomic_shared_ptr.h>
\ No newline at end of file
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <shared_ptr.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// ATOMIC SHARED POINTER DEFINITION
+// ============================================================================
+
+/// A shared_ptr slot that can be loaded, stored, exchanged and compared
+/// from many threads at once, for publishing snapshots to readers.
+///
+/// The control block pointer and a lock bit share one atomic word; the lock
+/// bit is the low bit, which is always clear in a control block address.
+/// It guards the element pointer and the reference taken by a load. The
+/// bit is only ever held for a few instructions: a load holds it for one
+/// read and a relaxed increment, and the references dropped by store,
+/// exchange and compare_exchange are released after it is cleared.
+template <typename T> class atomic_shared_ptr {
+    static constexpr std::uintptr_t k_lock_bit = 1;
+
+    mutable std::atomic<std::uintptr_t> d_cb;
+    typename shared_ptr<T>::Element_Type *d_ptr;
+
+    /// Spins until the lock bit is acquired and returns the unlocked word.
+    std::uintptr_t lock() const noexcept;
+
+    /// Publishes `word` with the lock bit clear.
+    void unlock(std::uintptr_t word) const noexcept {
+        d_cb.store(word, std::memory_order_release);
+    }
+
+    static std::uintptr_t to_word(control_block_base *cb) noexcept {
+        return reinterpret_cast<std::uintptr_t>(cb);
+    }
+
+    static control_block_base *to_cb(std::uintptr_t word) noexcept {
+        return reinterpret_cast<control_block_base *>(word & ~k_lock_bit);
+    }
+
+  public:
+    using Value_Type = shared_ptr<T>;
+
+    static constexpr bool is_always_lock_free = false;
+
+  public:
+    /// CONSTRUCTORS
+    constexpr atomic_shared_ptr() noexcept : d_cb(0), d_ptr(nullptr) {}
+
+    constexpr atomic_shared_ptr(std::nullptr_t) noexcept : atomic_shared_ptr() {}
+
+    atomic_shared_ptr(shared_ptr<T> desired) noexcept;
+
+    atomic_shared_ptr(const atomic_shared_ptr &) = delete;
+    atomic_shared_ptr &operator=(const atomic_shared_ptr &) = delete;
+
+    /// DESTRUCTORS
+    ~atomic_shared_ptr();
+
+    /// ASSIGNMENT
+    void operator=(shared_ptr<T> desired) noexcept { store(std::move(desired)); }
+
+    void operator=(std::nullptr_t) noexcept { store(shared_ptr<T>()); }
+
+  public:
+    // OPERATIONS
+    /// Memory order arguments are accepted for std::atomic compatibility.
+    /// Every operation is at least acquire on the value it reads and
+    /// release on the value it publishes.
+    [[nodiscard]] bool is_lock_free() const noexcept { return false; }
+
+    [[nodiscard]] shared_ptr<T> load(std::memory_order = std::memory_order_seq_cst) const noexcept;
+
+    [[nodiscard]] operator shared_ptr<T>() const noexcept { return load(); }
+
+    void store(shared_ptr<T> desired, std::memory_order = std::memory_order_seq_cst) noexcept;
+
+    [[nodiscard]] shared_ptr<T> exchange(shared_ptr<T> desired,
+                                         std::memory_order = std::memory_order_seq_cst) noexcept;
+
+    /// Replaces the value with desired if it owns the same object and
+    /// points at the same element as expected. Otherwise expected is
+    /// updated to the current value.
+    bool compare_exchange_strong(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                 std::memory_order = std::memory_order_seq_cst,
+                                 std::memory_order = std::memory_order_seq_cst) noexcept;
+
+    /// Never fails spuriously. Provided for std::atomic compatibility.
+    bool compare_exchange_weak(shared_ptr<T> &expected, shared_ptr<T> desired,
+                               std::memory_order success = std::memory_order_seq_cst,
+                               std::memory_order failure = std::memory_order_seq_cst) noexcept {
+        return compare_exchange_strong(expected, std::move(desired), success, failure);
+    }
+};
+
+// ============================================================================
+// ATOMIC SHARED POINTER IMPLEMENTATION
+// ============================================================================
+
+template <typename T> std::uintptr_t atomic_shared_ptr<T>::lock() const noexcept {
+    std::uintptr_t word = d_cb.load(std::memory_order_relaxed);
+    for (int spins = 0;; ++spins) {
+        if ((word & k_lock_bit) == 0 &&
+            d_cb.compare_exchange_weak(word, word | k_lock_bit, std::memory_order_acquire,
+                                       std::memory_order_relaxed)) {
+            return word;
+        }
+        if (spins >= 64) {
+            std::this_thread::yield();
+        }
+        word = d_cb.load(std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+atomic_shared_ptr<T>::atomic_shared_ptr(shared_ptr<T> desired) noexcept
+    : d_cb(to_word(desired.d_cb)), d_ptr(desired.d_ptr) {
+    desired.d_cb = nullptr;
+    desired.d_ptr = nullptr;
+}
+
+template <typename T> atomic_shared_ptr<T>::~atomic_shared_ptr() {
+    // Hand the slot's reference to a shared_ptr, which drops it
+    shared_ptr<T> released(d_ptr, to_cb(d_cb.load(std::memory_order_acquire)));
+}
+
+template <typename T> shared_ptr<T> atomic_shared_ptr<T>::load(std::memory_order) const noexcept {
+    std::uintptr_t word = lock();
+    auto *ptr = d_ptr;
+    control_block_base *cb = to_cb(word);
+    if (cb) {
+        cb->increment_shared_count();
+    }
+    unlock(word);
+    return shared_ptr<T>(ptr, cb);
+}
+
+template <typename T>
+void atomic_shared_ptr<T>::store(shared_ptr<T> desired, std::memory_order order) noexcept {
+    // The previous value is released when the returned handle dies
+    (void)exchange(std::move(desired), order);
+}
+
+template <typename T>
+shared_ptr<T> atomic_shared_ptr<T>::exchange(shared_ptr<T> desired, std::memory_order) noexcept {
+    std::uintptr_t word = lock();
+    auto *old_ptr = d_ptr;
+    d_ptr = desired.d_ptr;
+    unlock(to_word(desired.d_cb));
+
+    desired.d_cb = nullptr;
+    desired.d_ptr = nullptr;
+    return shared_ptr<T>(old_ptr, to_cb(word));
+}
+
+template <typename T>
+bool atomic_shared_ptr<T>::compare_exchange_strong(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                                   std::memory_order, std::memory_order) noexcept {
+    std::uintptr_t word = lock();
+    control_block_base *cb = to_cb(word);
+    if (cb == expected.d_cb && d_ptr == expected.d_ptr) {
+        d_ptr = desired.d_ptr;
+        unlock(to_word(desired.d_cb));
+
+        desired.d_cb = nullptr;
+        desired.d_ptr = nullptr;
+        // Drop the reference the slot held on the old value
+        shared_ptr<T> released(expected.d_ptr, cb);
+        return true;
+    }
+
+    auto *ptr = d_ptr;
+    if (cb) {
+        cb->increment_shared_count();
+    }
+    unlock(word);
+    expected = shared_ptr<T>(ptr, cb);
+    return false;
+}
+
+} // namespace ksl
+
+// ============================================================================
+// STD::ATOMIC SPECIALIZATION
+// ============================================================================
+
+/// std::atomic<ksl::shared_ptr<T>>, with the same interface as the standard
+/// library's std::atomic<std::shared_ptr<T>>.
+template <typename T> struct std::atomic<ksl::shared_ptr<T>> : ksl::atomic_shared_ptr<T> {
+    using ksl::atomic_shared_ptr<T>::atomic_shared_ptr;
+    using ksl::atomic_shared_ptr<T>::operator=;
+};
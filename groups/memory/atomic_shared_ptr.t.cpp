@@ -0,0 +1,165 @@
+// Component being tested
+#include <atomic_shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class AtomicSharedPtrTest : public ::testing::Test {
+  protected:
+    struct Derived {
+        int value;
+        static std::atomic<int> destructor_count;
+
+        explicit Derived(int v = 42) : value(v) {}
+        ~Derived() { destructor_count++; }
+    };
+};
+
+std::atomic<int> AtomicSharedPtrTest::Derived::destructor_count = 0;
+
+// ============================================================================
+// CONSTRUCTORS
+// ============================================================================
+
+TEST_F(AtomicSharedPtrTest, DefaultConstructor) {
+    atomic_shared_ptr<Derived> slot;
+    EXPECT_FALSE(slot.load());
+    EXPECT_FALSE(slot.is_lock_free());
+}
+
+TEST_F(AtomicSharedPtrTest, ValueConstructorAndDestructor) {
+    Derived::destructor_count = 0;
+    {
+        shared_ptr<Derived> ptr = make_shared<Derived>(7);
+        atomic_shared_ptr<Derived> slot(ptr);
+        EXPECT_EQ(ptr.use_count(), 2);
+        EXPECT_EQ(slot.load()->value, 7);
+        EXPECT_EQ(ptr.use_count(), 2);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+// ============================================================================
+// OPERATIONS
+// ============================================================================
+
+TEST_F(AtomicSharedPtrTest, LoadTakesAReference) {
+    atomic_shared_ptr<Derived> slot(make_shared<Derived>(1));
+    shared_ptr<Derived> first = slot.load();
+    shared_ptr<Derived> second = slot;
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(first.use_count(), 3);
+}
+
+TEST_F(AtomicSharedPtrTest, StoreReleasesThePreviousValue) {
+    Derived::destructor_count = 0;
+    atomic_shared_ptr<Derived> slot(make_shared<Derived>(1));
+    slot.store(make_shared<Derived>(2));
+    EXPECT_EQ(Derived::destructor_count, 1);
+    EXPECT_EQ(slot.load()->value, 2);
+
+    slot = nullptr;
+    EXPECT_EQ(Derived::destructor_count, 2);
+    EXPECT_FALSE(slot.load());
+}
+
+TEST_F(AtomicSharedPtrTest, Exchange) {
+    atomic_shared_ptr<Derived> slot(make_shared<Derived>(1));
+    shared_ptr<Derived> old = slot.exchange(make_shared<Derived>(2));
+    EXPECT_EQ(old->value, 1);
+    EXPECT_EQ(old.use_count(), 1);
+    EXPECT_EQ(slot.load()->value, 2);
+}
+
+TEST_F(AtomicSharedPtrTest, CompareExchange) {
+    shared_ptr<Derived> first = make_shared<Derived>(1);
+    shared_ptr<Derived> second = make_shared<Derived>(2);
+    atomic_shared_ptr<Derived> slot(first);
+
+    shared_ptr<Derived> expected = second;
+    EXPECT_FALSE(slot.compare_exchange_strong(expected, second));
+    EXPECT_EQ(expected.get(), first.get());
+    EXPECT_EQ(first.use_count(), 3);
+
+    EXPECT_TRUE(slot.compare_exchange_weak(expected, second));
+    EXPECT_EQ(slot.load().get(), second.get());
+    EXPECT_EQ(first.use_count(), 2);
+    EXPECT_EQ(second.use_count(), 2);
+}
+
+TEST_F(AtomicSharedPtrTest, StdAtomicSpecialization) {
+    std::atomic<shared_ptr<Derived>> slot(make_shared<Derived>(5));
+    EXPECT_EQ(slot.load()->value, 5);
+    slot = make_shared<Derived>(6);
+    EXPECT_EQ(slot.load()->value, 6);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(AtomicSharedPtrTest, ConcurrentReadersAndWriters) {
+    // Readers must always see a live, fully constructed snapshot while
+    // writers keep replacing it.
+    constexpr int k_readers = 4;
+    constexpr int k_writes = 2000;
+    Derived::destructor_count = 0;
+    {
+        atomic_shared_ptr<Derived> slot(make_shared<Derived>(0));
+        std::atomic<bool> done{false};
+        std::latch start(k_readers + 1);
+        std::vector<std::thread> readers;
+        for (int r = 0; r < k_readers; ++r) {
+            readers.emplace_back([&] {
+                start.arrive_and_wait();
+                int last = 0;
+                while (!done.load(std::memory_order_acquire)) {
+                    shared_ptr<Derived> snapshot = slot.load();
+                    ASSERT_TRUE(snapshot);
+                    EXPECT_GE(snapshot->value, last);
+                    last = snapshot->value;
+                }
+            });
+        }
+        start.arrive_and_wait();
+        for (int i = 1; i <= k_writes; ++i) {
+            slot.store(make_shared<Derived>(i));
+        }
+        done.store(true, std::memory_order_release);
+        for (auto &reader : readers) {
+            reader.join();
+        }
+        EXPECT_EQ(slot.load()->value, k_writes);
+    }
+    EXPECT_EQ(Derived::destructor_count, k_writes + 1);
+}
+
+TEST_F(AtomicSharedPtrTest, ConcurrentCompareExchangeCounter) {
+    // Every increment is applied exactly once through a CAS loop.
+    constexpr int k_threads = 4;
+    constexpr int k_increments = 500;
+    atomic_shared_ptr<Derived> slot(make_shared<Derived>(0));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&slot] {
+            for (int i = 0; i < k_increments; ++i) {
+                shared_ptr<Derived> expected = slot.load();
+                while (!slot.compare_exchange_weak(expected,
+                                                   make_shared<Derived>(expected->value + 1))) {
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(slot.load()->value, k_threads * k_increments);
+}
+
+} // namespace ksl
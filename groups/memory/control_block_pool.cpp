@@ -0,0 +1,154 @@
+#include <control_block_pool.h>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace ksl {
+namespace {
+static_assert(control_block_pool::k_granularity <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+              "pooled blocks rely on operator new's default alignment");
+
+struct free_block {
+    free_block *d_next;
+};
+
+inline std::size_t size_class(std::size_t bytes) noexcept {
+    return (bytes + control_block_pool::k_granularity - 1) / control_block_pool::k_granularity -
+           1;
+}
+
+inline std::size_t class_bytes(std::size_t index) noexcept {
+    return (index + 1) * control_block_pool::k_granularity;
+}
+
+/// Counters are only written by the owning thread, so a relaxed
+/// load/store pair is enough and stats() can read them concurrently.
+inline void bump(std::atomic<std::size_t> &counter) noexcept {
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+struct thread_cache;
+
+/// Every live thread cache, plus the counters of threads that have exited.
+struct cache_registry {
+    std::mutex d_mutex;
+    std::vector<thread_cache *> d_caches;
+    control_block_pool_stats d_retired{};
+};
+
+cache_registry &registry() {
+    // Leaked on purpose: thread caches may unregister during static
+    // destruction, after a function-local static would be gone.
+    static cache_registry *instance = new cache_registry;
+    return *instance;
+}
+
+struct thread_cache {
+    free_block *d_heads[control_block_pool::k_size_classes] = {};
+    std::size_t d_lengths[control_block_pool::k_size_classes] = {};
+    std::atomic<std::size_t> d_hits{0};
+    std::atomic<std::size_t> d_misses{0};
+    std::atomic<std::size_t> d_recycled{0};
+    std::atomic<std::size_t> d_released{0};
+
+    thread_cache();
+    ~thread_cache();
+
+    [[nodiscard]] control_block_pool_stats stats() const noexcept {
+        return {d_hits.load(std::memory_order_relaxed), d_misses.load(std::memory_order_relaxed),
+                d_recycled.load(std::memory_order_relaxed),
+                d_released.load(std::memory_order_relaxed)};
+    }
+};
+
+enum class cache_state : unsigned char { uninitialized, alive, destroyed };
+
+thread_local cache_state t_cache_state = cache_state::uninitialized;
+thread_local thread_cache t_cache;
+
+thread_cache::thread_cache() {
+    cache_registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.d_mutex);
+    reg.d_caches.push_back(this);
+    t_cache_state = cache_state::alive;
+}
+
+thread_cache::~thread_cache() {
+    t_cache_state = cache_state::destroyed;
+    for (std::size_t index = 0; index < control_block_pool::k_size_classes; ++index) {
+        while (free_block *block = d_heads[index]) {
+            d_heads[index] = block->d_next;
+            ::operator delete(block, class_bytes(index));
+            bump(d_released);
+        }
+    }
+
+    cache_registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.d_mutex);
+    reg.d_caches.erase(std::find(reg.d_caches.begin(), reg.d_caches.end(), this));
+    control_block_pool_stats mine = stats();
+    reg.d_retired.hits += mine.hits;
+    reg.d_retired.misses += mine.misses;
+    reg.d_retired.recycled += mine.recycled;
+    reg.d_retired.released += mine.released;
+}
+
+/// Returns the calling thread's cache, or nullptr once it has been
+/// destroyed during thread exit.
+inline thread_cache *current_cache() noexcept {
+    if (t_cache_state == cache_state::destroyed) {
+        return nullptr;
+    }
+    return &t_cache;
+}
+} // namespace
+
+void *control_block_pool::allocate(std::size_t bytes) {
+    const std::size_t index = size_class(bytes);
+    thread_cache *cache = current_cache();
+    if (cache && cache->d_heads[index]) {
+        free_block *block = cache->d_heads[index];
+        cache->d_heads[index] = block->d_next;
+        --cache->d_lengths[index];
+        bump(cache->d_hits);
+        return block;
+    }
+    if (cache) {
+        bump(cache->d_misses);
+    }
+    return ::operator new(class_bytes(index));
+}
+
+void control_block_pool::deallocate(void *ptr, std::size_t bytes) noexcept {
+    const std::size_t index = size_class(bytes);
+    thread_cache *cache = current_cache();
+    if (cache && cache->d_lengths[index] < k_max_cached_blocks) {
+        free_block *block = static_cast<free_block *>(ptr);
+        block->d_next = cache->d_heads[index];
+        cache->d_heads[index] = block;
+        ++cache->d_lengths[index];
+        bump(cache->d_recycled);
+        return;
+    }
+    if (cache) {
+        bump(cache->d_released);
+    }
+    ::operator delete(ptr, class_bytes(index));
+}
+
+control_block_pool_stats control_block_pool::stats() noexcept {
+    cache_registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.d_mutex);
+    control_block_pool_stats total = reg.d_retired;
+    for (const thread_cache *cache : reg.d_caches) {
+        control_block_pool_stats theirs = cache->stats();
+        total.hits += theirs.hits;
+        total.misses += theirs.misses;
+        total.recycled += theirs.recycled;
+        total.released += theirs.released;
+    }
+    return total;
+}
+
+} // namespace ksl
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace ksl {
+
+/// Pool counters, summed over every thread that has used the pool.
+struct control_block_pool_stats {
+    /// Allocations served from a thread's free list.
+    std::size_t hits;
+    /// Allocations that had to go to the system allocator.
+    std::size_t misses;
+    /// Blocks returned to a thread's free list.
+    std::size_t recycled;
+    /// Blocks returned to the system allocator because the free list was full.
+    std::size_t released;
+};
+
+/// Thread-caching, size-classed free list for control blocks.
+///
+/// Each thread keeps one free list per 16-byte size class up to
+/// k_max_block_size. A block freed on a thread goes on that thread's list
+/// and is handed back by the next allocation of the same class, without
+/// touching the system allocator. Lists are capped at k_max_cached_blocks
+/// and are flushed back to the system allocator when the thread exits.
+class control_block_pool {
+  public:
+    static constexpr std::size_t k_granularity = 16;
+    static constexpr std::size_t k_max_block_size = 256;
+    static constexpr std::size_t k_size_classes = k_max_block_size / k_granularity;
+    static constexpr std::size_t k_max_cached_blocks = 4096;
+
+    /// Whether a block of this size and alignment can come from the pool.
+    static constexpr bool is_poolable(std::size_t bytes, std::size_t alignment) noexcept {
+        return bytes != 0 && bytes <= k_max_block_size && alignment <= k_granularity;
+    }
+
+    /// Returns a block of at least `bytes` bytes. `bytes` must be poolable.
+    static void *allocate(std::size_t bytes);
+
+    /// Returns a block obtained from allocate(bytes) to the calling
+    /// thread's free list.
+    static void deallocate(void *ptr, std::size_t bytes) noexcept;
+
+    static control_block_pool_stats stats() noexcept;
+
+    /// Global policy: when enabled, shared_ptr(T*) and reset(T*) allocate
+    /// their control block from the pool instead of the global heap.
+    static void set_enabled_by_default(bool enabled) noexcept {
+        s_enabled_by_default.store(enabled, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static bool enabled_by_default() noexcept {
+        return s_enabled_by_default.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static inline std::atomic<bool> s_enabled_by_default{false};
+};
+
+/// Allocator that routes single-object allocations through
+/// control_block_pool. Pass it to shared_ptr(T*, Deleter, Alloc) or
+/// allocate_shared to pool a control block on a per-call basis. Requests
+/// the pool cannot serve fall through to std::allocator.
+template <typename T> struct pool_allocator {
+    using value_type = T;
+
+    pool_allocator() noexcept = default;
+    template <typename U> pool_allocator(const pool_allocator<U> &) noexcept {}
+
+    [[nodiscard]] T *allocate(std::size_t n) {
+        if (n == 1 && control_block_pool::is_poolable(sizeof(T), alignof(T))) {
+            return static_cast<T *>(control_block_pool::allocate(sizeof(T)));
+        }
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        if (n == 1 && control_block_pool::is_poolable(sizeof(T), alignof(T))) {
+            control_block_pool::deallocate(ptr, sizeof(T));
+            return;
+        }
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template <typename U> bool operator==(const pool_allocator<U> &) const noexcept {
+        return true;
+    }
+};
+
+/// Tag selecting the pooled control block for a single shared_ptr(T*, ...)
+/// construction or reset, regardless of the global policy.
+struct pooled_t {
+    explicit pooled_t() = default;
+};
+inline constexpr pooled_t pooled{};
+
+} // namespace ksl
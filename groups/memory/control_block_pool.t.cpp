@@ -0,0 +1,143 @@
+// Component being tested
+#include <control_block_pool.h>
+
+#include <shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <thread>
+
+namespace ksl {
+
+class ControlBlockPoolTest : public ::testing::Test {
+  protected:
+    struct Derived {
+        int value;
+        static int destructor_count;
+
+        explicit Derived(int v = 42) : value(v) {}
+        ~Derived() { destructor_count++; }
+    };
+
+    void TearDown() override { control_block_pool::set_enabled_by_default(false); }
+};
+
+int ControlBlockPoolTest::Derived::destructor_count = 0;
+
+// ============================================================================
+// RAW POOL
+// ============================================================================
+
+TEST_F(ControlBlockPoolTest, RecyclesBlocksOfTheSameClass) {
+    control_block_pool_stats before = control_block_pool::stats();
+
+    void *first = control_block_pool::allocate(40);
+    control_block_pool::deallocate(first, 40);
+    // 40 and 48 bytes share a size class, so the block is handed back
+    void *second = control_block_pool::allocate(48);
+    EXPECT_EQ(first, second);
+    control_block_pool::deallocate(second, 48);
+
+    control_block_pool_stats after = control_block_pool::stats();
+    EXPECT_EQ(after.hits - before.hits, 1u);
+    EXPECT_EQ(after.recycled - before.recycled, 2u);
+}
+
+TEST_F(ControlBlockPoolTest, SeparatesSizeClasses) {
+    void *small = control_block_pool::allocate(16);
+    control_block_pool::deallocate(small, 16);
+
+    control_block_pool_stats before = control_block_pool::stats();
+    void *large = control_block_pool::allocate(128);
+    control_block_pool_stats after = control_block_pool::stats();
+
+    EXPECT_NE(small, large);
+    EXPECT_EQ(after.misses - before.misses, 1u);
+    control_block_pool::deallocate(large, 128);
+}
+
+TEST_F(ControlBlockPoolTest, IsPoolable) {
+    EXPECT_TRUE(control_block_pool::is_poolable(8, 8));
+    EXPECT_TRUE(control_block_pool::is_poolable(control_block_pool::k_max_block_size, 16));
+    EXPECT_FALSE(control_block_pool::is_poolable(0, 8));
+    EXPECT_FALSE(control_block_pool::is_poolable(control_block_pool::k_max_block_size + 1, 8));
+    EXPECT_FALSE(control_block_pool::is_poolable(64, 64));
+}
+
+TEST_F(ControlBlockPoolTest, ThreadExitKeepsCounters) {
+    control_block_pool_stats before = control_block_pool::stats();
+    std::thread worker([] {
+        for (int i = 0; i < 10; ++i) {
+            control_block_pool::deallocate(control_block_pool::allocate(32), 32);
+        }
+    });
+    worker.join();
+
+    control_block_pool_stats after = control_block_pool::stats();
+    EXPECT_EQ(after.misses - before.misses, 1u);
+    EXPECT_EQ(after.hits - before.hits, 9u);
+    // The worker's cached block went back to the system allocator on exit
+    EXPECT_EQ(after.released - before.released, 1u);
+}
+
+// ============================================================================
+// SHARED_PTR INTEGRATION
+// ============================================================================
+
+TEST_F(ControlBlockPoolTest, PooledTagRecyclesControlBlocks) {
+    Derived::destructor_count = 0;
+    shared_ptr<Derived>(new Derived(1), pooled);
+
+    control_block_pool_stats before = control_block_pool::stats();
+    {
+        shared_ptr<Derived> ptr(new Derived(2), pooled);
+        EXPECT_EQ(ptr->value, 2);
+        ptr.reset(new Derived(3), pooled);
+        EXPECT_EQ(ptr->value, 3);
+    }
+    control_block_pool_stats after = control_block_pool::stats();
+
+    EXPECT_EQ(Derived::destructor_count, 3);
+    EXPECT_EQ(after.misses - before.misses, 1u);
+    EXPECT_EQ(after.hits - before.hits, 1u);
+}
+
+TEST_F(ControlBlockPoolTest, PoolAllocatorWithDeleter) {
+    int deleter_count = 0;
+    auto deleter = [&deleter_count](Derived *p) {
+        deleter_count++;
+        delete p;
+    };
+
+    control_block_pool_stats before = control_block_pool::stats();
+    {
+        shared_ptr<Derived> ptr(new Derived(4), deleter, pool_allocator<Derived>());
+        weak_ptr<Derived> wptr(ptr);
+        EXPECT_EQ(ptr->value, 4);
+    }
+    control_block_pool_stats after = control_block_pool::stats();
+
+    EXPECT_EQ(deleter_count, 1);
+    EXPECT_EQ(after.recycled - before.recycled, 1u);
+}
+
+TEST_F(ControlBlockPoolTest, GlobalPolicy) {
+    control_block_pool_stats before = control_block_pool::stats();
+    { shared_ptr<Derived> ptr(new Derived(5)); }
+    control_block_pool_stats after = control_block_pool::stats();
+    EXPECT_EQ(after.recycled, before.recycled);
+
+    control_block_pool::set_enabled_by_default(true);
+    EXPECT_TRUE(control_block_pool::enabled_by_default());
+    before = control_block_pool::stats();
+    {
+        shared_ptr<Derived> ptr(new Derived(6));
+        ptr.reset(new Derived(7));
+        EXPECT_EQ(ptr->value, 7);
+    }
+    after = control_block_pool::stats();
+    EXPECT_EQ(after.recycled - before.recycled, 2u);
+}
+
+} // namespace ksl
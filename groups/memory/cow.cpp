@@ -0,0 +1 @@
+#include <cow.h>
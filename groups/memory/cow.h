@@ -0,0 +1,112 @@
+#pragma once
+
+#include <shared_ptr.h>
+
+#include <cassert>
+#include <concepts>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// COW DEFINITION
+// ============================================================================
+
+/// A T held by value with copy-on-write: copies share one object, so
+/// handing a large read-mostly value to another thread is one reference
+/// count increment, and write() makes a private copy first only if the
+/// object is shared.
+///
+/// write() checks for sharing with use_count(), whose load is acquire.
+/// Reading 1 means every other owner has released the object, and their
+/// releases (acq_rel) happen before the load, so their reads of the object
+/// are over before it is written in place. This holds only because no
+/// weak_ptr to the object can exist, lock() being the one way to go from
+/// one owner to two without a copy: the shared_ptr is never handed out,
+/// and T may not derive from enable_shared_from_this.
+///
+/// One cow object is not itself safe to use from several threads at once,
+/// any more than a T would be; each thread uses its own copy.
+template <typename T> class cow {
+    static_assert(!std::is_array_v<T> && !std::is_const_v<T>, "cow holds a mutable object");
+    static_assert(!EnablesSharedFromThis<T>,
+                  "a cow object cannot derive from enable_shared_from_this");
+    static_assert(std::is_copy_constructible_v<T>, "write() needs to copy a shared object");
+
+    shared_ptr<T> d_ptr;
+
+  public:
+    using Value_Type = T;
+
+    /// CONSTRUCTORS
+    cow()
+        requires std::default_initializable<T>
+        : d_ptr(make_shared<T>()) {}
+
+    cow(const T &value) : d_ptr(make_shared<T>(value)) {}
+    cow(T &&value) : d_ptr(make_shared<T>(std::move(value))) {}
+
+    template <typename... Args>
+    explicit cow(std::in_place_t, Args &&...args)
+        : d_ptr(make_shared<T>(std::forward<Args>(args)...)) {}
+
+    /// Copies share the object. A moved-from cow may only be assigned to
+    /// or destroyed.
+    cow(const cow &) noexcept = default;
+    cow(cow &&) noexcept = default;
+    cow &operator=(const cow &) noexcept = default;
+    cow &operator=(cow &&) noexcept = default;
+
+    ~cow() = default;
+
+    /// ACCESS
+    [[nodiscard]] const T &read() const noexcept {
+        assert(d_ptr && "Attempted to read a moved-from cow");
+        return *d_ptr;
+    }
+
+    [[nodiscard]] const T &operator*() const noexcept { return read(); }
+    [[nodiscard]] const T *operator->() const noexcept { return &read(); }
+
+    /// The object, for writing. If other copies share it, it is first
+    /// copied, and this cow moves to the copy; the others keep the
+    /// original. Writes through the reference must stop once this cow is
+    /// copied, or the copy would see them.
+    [[nodiscard]] T &write() {
+        assert(d_ptr && "Attempted to write a moved-from cow");
+        if (d_ptr.use_count() != 1) {
+            d_ptr = make_shared<T>(std::as_const(*d_ptr));
+        }
+        return *d_ptr;
+    }
+
+    /// OBSERVERS
+    /// Whether write() would modify the object in place.
+    [[nodiscard]] bool unique() const noexcept { return d_ptr.use_count() == 1; }
+
+    /// Copies sharing the object, this one included.
+    [[nodiscard]] std::size_t use_count() const noexcept { return d_ptr.use_count(); }
+
+    /// Whether both share one object. Unlike ==, this is true only of
+    /// copies of the same cow, and never reads the object.
+    [[nodiscard]] bool identical(const cow &other) const noexcept {
+        return d_ptr == other.d_ptr;
+    }
+
+    void swap(cow &other) noexcept { d_ptr.swap(other.d_ptr); }
+    friend void swap(cow &lhs, cow &rhs) noexcept { lhs.swap(rhs); }
+
+    /// Compares the values, skipping the comparison for copies sharing one
+    /// object.
+    friend bool operator==(const cow &lhs, const cow &rhs)
+        requires std::equality_comparable<T>
+    {
+        return lhs.identical(rhs) || lhs.read() == rhs.read();
+    }
+};
+
+template <typename T> struct is_trivially_relocatable<cow<T>> : std::true_type {};
+
+} // namespace ksl
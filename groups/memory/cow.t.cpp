@@ -0,0 +1,187 @@
+// Component being tested
+#include <cow.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class CowTest : public ::testing::Test {
+  protected:
+    struct Table {
+        std::vector<int> rows;
+        static std::atomic<int> copy_count;
+
+        Table() = default;
+        explicit Table(std::size_t size, int value) : rows(size, value) {}
+        Table(const Table &other) : rows(other.rows) { copy_count++; }
+        Table(Table &&) noexcept = default;
+
+        bool operator==(const Table &) const = default;
+    };
+
+    void SetUp() override { Table::copy_count = 0; }
+};
+
+std::atomic<int> CowTest::Table::copy_count = 0;
+
+// ============================================================================
+// SHARING
+// ============================================================================
+
+TEST_F(CowTest, CopiesShareTheObject) {
+    cow<Table> original(std::in_place, 1000, 7);
+    cow<Table> copy = original;
+    EXPECT_TRUE(copy.identical(original));
+    EXPECT_EQ(&copy.read(), &original.read());
+    EXPECT_EQ(original.use_count(), 2u);
+    EXPECT_FALSE(original.unique());
+    EXPECT_EQ(Table::copy_count, 0);
+    EXPECT_EQ(copy->rows.size(), 1000u);
+}
+
+TEST_F(CowTest, ConstructsFromValue) {
+    Table table(4, 1);
+    cow<Table> copied(table);
+    cow<Table> moved(std::move(table));
+    EXPECT_EQ(Table::copy_count, 1);
+    EXPECT_EQ(*copied, *moved);
+
+    cow<std::string> text;
+    EXPECT_TRUE(text->empty());
+}
+
+// ============================================================================
+// COPY ON WRITE
+// ============================================================================
+
+TEST_F(CowTest, UniqueWriteIsInPlace) {
+    cow<Table> table(std::in_place, 3, 0);
+    const Table *before = &table.read();
+    table.write().rows[0] = 5;
+    EXPECT_EQ(&table.read(), before);
+    EXPECT_EQ(Table::copy_count, 0);
+}
+
+TEST_F(CowTest, SharedWriteClonesOnce) {
+    cow<Table> original(std::in_place, 3, 0);
+    cow<Table> copy = original;
+
+    copy.write().rows[0] = 5;
+    EXPECT_EQ(Table::copy_count, 1);
+    EXPECT_FALSE(copy.identical(original));
+    EXPECT_EQ(original->rows[0], 0);
+    EXPECT_EQ(copy->rows[0], 5);
+
+    // Both are unique now, so neither copies again
+    copy.write().rows[1] = 6;
+    original.write().rows[1] = 8;
+    EXPECT_EQ(Table::copy_count, 1);
+    EXPECT_TRUE(original.unique());
+    EXPECT_TRUE(copy.unique());
+}
+
+TEST_F(CowTest, WriteAfterCopiesAreGoneIsInPlace) {
+    cow<Table> table(std::in_place, 3, 0);
+    {
+        cow<Table> copy = table;
+        EXPECT_FALSE(table.unique());
+    }
+    const Table *before = &table.read();
+    table.write().rows[2] = 1;
+    EXPECT_EQ(&table.read(), before);
+    EXPECT_EQ(Table::copy_count, 0);
+}
+
+// ============================================================================
+// VALUE SEMANTICS
+// ============================================================================
+
+TEST_F(CowTest, EqualityComparesValues) {
+    cow<Table> a(std::in_place, 2, 1);
+    cow<Table> b(std::in_place, 2, 1);
+    cow<Table> c = a;
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(a, c);
+    EXPECT_FALSE(a.identical(b));
+    c.write().rows[0] = 9;
+    EXPECT_NE(a, c);
+}
+
+TEST_F(CowTest, SwapAndMove) {
+    cow<Table> a(std::in_place, 1, 1);
+    cow<Table> b(std::in_place, 2, 2);
+    swap(a, b);
+    EXPECT_EQ(a->rows.size(), 2u);
+    EXPECT_EQ(b->rows.size(), 1u);
+
+    cow<Table> moved = std::move(a);
+    EXPECT_EQ(moved.use_count(), 1u);
+    a = b;
+    EXPECT_TRUE(a.identical(b));
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(CowTest, ReadersReleaseBeforeInPlaceWrite) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 200;
+    cow<Table> source(std::in_place, 256, 0);
+
+    for (int round = 0; round < k_rounds; ++round) {
+        std::latch start(k_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < k_threads; ++t) {
+            threads.emplace_back([&start, copy = source, round]() mutable {
+                start.arrive_and_wait();
+                for (int row : copy->rows) {
+                    EXPECT_EQ(row, round);
+                }
+            });
+        }
+        // Writes in place once every reader is done with the object, which
+        // the sanitizer checks is ordered after their reads
+        while (!source.unique()) {
+            std::this_thread::yield();
+        }
+        for (int &row : source.write().rows) {
+            row = round + 1;
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(Table::copy_count, 0);
+}
+
+TEST_F(CowTest, ConcurrentWritersCloneTheirOwnCopies) {
+    constexpr int k_threads = 4;
+    const cow<Table> source(std::in_place, 64, 0);
+    std::latch start(k_threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&start, copy = source, t]() mutable {
+            start.arrive_and_wait();
+            copy.write().rows[0] = t + 1;
+            EXPECT_EQ(copy->rows[0], t + 1);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // The source keeps the object shared, so every writer clones it
+    EXPECT_EQ(Table::copy_count, k_threads);
+    EXPECT_EQ(source->rows[0], 0);
+}
+
+} // namespace ksl
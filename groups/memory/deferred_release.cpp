@@ -0,0 +1,94 @@
+#include <deferred_release.h>
+
+namespace ksl {
+namespace {
+/// Intrusive stack of queued entries and the queue counters.
+struct queue_state {
+    std::atomic<deferred_entry *> d_head{nullptr};
+    std::atomic<std::size_t> d_enqueued{0};
+    std::atomic<std::size_t> d_reclaimed{0};
+    std::atomic<std::size_t> d_peak{0};
+    std::atomic<std::size_t> d_drains{0};
+};
+
+queue_state &queue() {
+    // Leaked on purpose: objects may be released during static destruction,
+    // after a function-local static would be gone.
+    static queue_state *instance = new queue_state;
+    return *instance;
+}
+} // namespace
+
+void deferred_queue::push(deferred_entry *entry) noexcept {
+    queue_state &state = queue();
+    entry->d_next = state.d_head.load(std::memory_order_relaxed);
+    while (!state.d_head.compare_exchange_weak(entry->d_next, entry, std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+    }
+
+    // The depth is read after the push, so it never undercounts this entry
+    const std::size_t depth = state.d_enqueued.fetch_add(1, std::memory_order_relaxed) + 1 -
+                              state.d_reclaimed.load(std::memory_order_relaxed);
+    std::size_t peak = state.d_peak.load(std::memory_order_relaxed);
+    while (depth > peak &&
+           !state.d_peak.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {
+    }
+}
+
+std::size_t deferred_queue::drain() noexcept {
+    queue_state &state = queue();
+    deferred_entry *head = state.d_head.exchange(nullptr, std::memory_order_acquire);
+    if (!head) {
+        return 0;
+    }
+
+    // The stack holds the newest entry first; reclaim in release order
+    deferred_entry *ordered = nullptr;
+    while (head) {
+        deferred_entry *next = head->d_next;
+        head->d_next = ordered;
+        ordered = head;
+        head = next;
+    }
+
+    std::size_t count = 0;
+    while (ordered) {
+        deferred_entry *next = ordered->d_next;
+        ordered->d_reclaim(ordered);
+        ordered = next;
+        ++count;
+    }
+    state.d_reclaimed.fetch_add(count, std::memory_order_relaxed);
+    state.d_drains.fetch_add(1, std::memory_order_relaxed);
+    return count;
+}
+
+deferred_stats deferred_queue::stats() noexcept {
+    queue_state &state = queue();
+    const std::size_t reclaimed = state.d_reclaimed.load(std::memory_order_relaxed);
+    const std::size_t enqueued = state.d_enqueued.load(std::memory_order_relaxed);
+    return {enqueued > reclaimed ? enqueued - reclaimed : 0,
+            state.d_peak.load(std::memory_order_relaxed), enqueued, reclaimed,
+            state.d_drains.load(std::memory_order_relaxed)};
+}
+
+deferred_reclaimer::deferred_reclaimer(std::chrono::milliseconds period)
+    : d_thread([this, period](std::stop_token stop) {
+          std::unique_lock<std::mutex> lock(d_mutex);
+          while (!d_wakeup.wait_for(lock, stop, period, [] { return false; })) {
+              if (stop.stop_requested()) {
+                  break;
+              }
+              lock.unlock();
+              deferred_queue::drain();
+              lock.lock();
+          }
+      }) {}
+
+deferred_reclaimer::~deferred_reclaimer() {
+    d_thread.request_stop();
+    d_thread.join();
+    deferred_queue::drain();
+}
+
+} // namespace ksl
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <shared_ptr.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// DEFERRED QUEUE DEFINITION
+// ============================================================================
+
+/// Link in the deferred queue. reclaim(entry) runs the work that was
+/// deferred: destroying the object and releasing its block.
+struct deferred_entry {
+    deferred_entry *d_next = nullptr;
+    void (*d_reclaim)(deferred_entry *) noexcept;
+};
+
+/// Queue counters, over the whole process.
+struct deferred_stats {
+    /// Objects queued and not yet reclaimed: the current queue depth.
+    std::size_t pending;
+    /// Deepest the queue has been.
+    std::size_t peak_pending;
+    /// Objects queued in total.
+    std::size_t enqueued;
+    /// Objects reclaimed by drain().
+    std::size_t reclaimed;
+    /// drain() calls that found work.
+    std::size_t drains;
+};
+
+/// Process-wide queue of objects whose last owner has gone, waiting to be
+/// destroyed somewhere the cost does not matter.
+///
+/// Pushing is one CAS on the queue head, whatever the size of the object
+/// graph behind the entry. drain() takes the whole queue in one exchange
+/// and reclaims it in release order, so several threads can drain at once
+/// without sharing any entry.
+class deferred_queue {
+  public:
+    static void push(deferred_entry *entry) noexcept;
+
+    /// Reclaims everything queued so far and returns how many objects that
+    /// was. Objects released by the reclaimed destructors, if they are
+    /// deferred themselves, wait for the next drain.
+    static std::size_t drain() noexcept;
+
+    static deferred_stats stats() noexcept;
+};
+
+/// Runs the deferred destructors on the calling thread, e.g. at the end of
+/// a frame or request. Returns the number of objects reclaimed.
+inline std::size_t drain_deferred() noexcept { return deferred_queue::drain(); }
+
+/// Background thread draining the deferred queue every period, for
+/// programs with no natural quiescent point. The queue is drained once more
+/// when the reclaimer is destroyed.
+class deferred_reclaimer {
+    std::mutex d_mutex;
+    std::condition_variable_any d_wakeup;
+    std::jthread d_thread;
+
+  public:
+    explicit deferred_reclaimer(std::chrono::milliseconds period = std::chrono::milliseconds(1));
+
+    deferred_reclaimer(const deferred_reclaimer &) = delete;
+    deferred_reclaimer &operator=(const deferred_reclaimer &) = delete;
+
+    ~deferred_reclaimer();
+};
+
+namespace {
+/// make_shared block whose dispose() queues the object instead of
+/// destroying it. The queue takes over the owners' weak reference, so the
+/// block outlives the owners' release and is freed by whichever of the
+/// queue and the last weak_ptr lets go of it last. weak_ptr::lock() fails
+/// from the moment the object is queued, and weak_retention counts the
+/// block only if weak_ptrs outlive the drain.
+template <typename T, typename Alloc = std::allocator<T>>
+struct control_block_deferred_impl : public control_block_base, public deferred_entry {
+    alignas(T) char d_storage[sizeof(T)];
+    [[no_unique_address]] Alloc d_alloc;
+
+    template <typename... Args>
+    control_block_deferred_impl(const Alloc &alloc, Args &&...args)
+        : deferred_entry{nullptr, &reclaim}, d_alloc(alloc) {
+        new (d_storage) T(std::forward<Args>(args)...);
+    }
+
+    bool dispose() override {
+        deferred_queue::push(this);
+        return false;
+    }
+
+    static void reclaim(deferred_entry *entry) noexcept {
+        auto *cb = static_cast<control_block_deferred_impl *>(entry);
+        reinterpret_cast<T *>(cb->d_storage)->~T();
+        cb->release_owners_weak();
+    }
+
+    void destroy() noexcept override {
+        deallocate_control_block<control_block_deferred_impl, Alloc>(this);
+    }
+    std::size_t retained_bytes() const noexcept override { return sizeof(*this); }
+};
+} // namespace
+
+// ============================================================================
+// MAKE_SHARED_DEFERRED IMPLEMENTATION
+// ============================================================================
+
+/// Like make_shared, but the release of the last owner only queues the
+/// object: its destructor, and the free of the object and block, run in the
+/// next drain_deferred() or on a deferred_reclaimer thread. Meant for large
+/// object graphs whose last owner may be a latency-critical thread.
+template <typename Y, typename... Args>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> make_shared_deferred(Args &&...args) {
+    const std::allocator<Y> alloc;
+    auto cb = allocate_control_block<control_block_deferred_impl<Y>>(alloc, alloc,
+                                                                       std::forward<Args>(args)...);
+    Y *ptr = reinterpret_cast<Y *>(cb->d_storage);
+    return shared_ptr_access::adopt<Y>(ptr, cb);
+}
+
+} // namespace ksl
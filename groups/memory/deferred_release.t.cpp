@@ -0,0 +1,206 @@
+// Component being tested
+#include <deferred_release.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class DeferredReleaseTest : public ::testing::Test {
+  protected:
+    struct Node {
+        int value;
+        shared_ptr<Node> next;
+        static std::atomic<int> destructor_count;
+
+        explicit Node(int v = 42) : value(v) {}
+        ~Node() { destructor_count++; }
+    };
+
+    void SetUp() override {
+        // Start every test from an empty queue
+        while (drain_deferred() != 0) {
+        }
+        Node::destructor_count = 0;
+    }
+
+    void TearDown() override {
+        while (drain_deferred() != 0) {
+        }
+    }
+};
+
+std::atomic<int> DeferredReleaseTest::Node::destructor_count = 0;
+
+// ============================================================================
+// DEFERRED DESTRUCTION
+// ============================================================================
+
+TEST_F(DeferredReleaseTest, DestructionWaitsForDrain) {
+    shared_ptr<Node> ptr = make_shared_deferred<Node>(1);
+    EXPECT_EQ(ptr->value, 1);
+    shared_ptr<Node> copy = ptr;
+    EXPECT_EQ(ptr.use_count(), 2);
+
+    const deferred_stats before = deferred_queue::stats();
+    ptr.reset();
+    copy.reset();
+    EXPECT_EQ(Node::destructor_count, 0);
+    deferred_stats after = deferred_queue::stats();
+    EXPECT_EQ(after.pending, 1u);
+    EXPECT_EQ(after.enqueued - before.enqueued, 1u);
+    EXPECT_GE(after.peak_pending, 1u);
+
+    EXPECT_EQ(drain_deferred(), 1u);
+    EXPECT_EQ(Node::destructor_count, 1);
+    after = deferred_queue::stats();
+    EXPECT_EQ(after.pending, 0u);
+    EXPECT_EQ(after.reclaimed - before.reclaimed, 1u);
+    EXPECT_EQ(after.drains - before.drains, 1u);
+    EXPECT_EQ(drain_deferred(), 0u);
+}
+
+TEST_F(DeferredReleaseTest, DrainsInReleaseOrder) {
+    std::vector<int> order;
+    struct Recorder {
+        std::vector<int> *d_order;
+        int d_id;
+        ~Recorder() { d_order->push_back(d_id); }
+    };
+    for (int i = 0; i < 3; ++i) {
+        make_shared_deferred<Recorder>(&order, i).reset();
+    }
+    EXPECT_EQ(drain_deferred(), 3u);
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+TEST_F(DeferredReleaseTest, WeakPtrExpiresWhenQueued) {
+    shared_ptr<Node> ptr = make_shared_deferred<Node>(2);
+    weak_ptr<Node> observer = ptr;
+    ptr.reset();
+
+    // The object is gone for its users even though it is not destroyed yet
+    EXPECT_TRUE(observer.expired());
+    EXPECT_FALSE(observer.lock());
+    EXPECT_EQ(Node::destructor_count, 0);
+
+    drain_deferred();
+    EXPECT_EQ(Node::destructor_count, 1);
+    observer.reset();
+}
+
+TEST_F(DeferredReleaseTest, WeakPtrReleasedBeforeDrain) {
+    shared_ptr<Node> ptr = make_shared_deferred<Node>(3);
+    weak_ptr<Node> observer = ptr;
+    ptr.reset();
+    observer.reset();
+    // The queue's reference keeps the block until the drain
+    EXPECT_EQ(drain_deferred(), 1u);
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+TEST_F(DeferredReleaseTest, QueuedBlocksAreNotWeakRetained) {
+    const weak_retention_stats before = weak_retention::stats();
+    { shared_ptr<Node> ptr = make_shared_deferred<Node>(4); }
+
+    // Queued, but held by the queue rather than by any weak_ptr
+    EXPECT_EQ(deferred_queue::stats().pending, 1u);
+    EXPECT_EQ(weak_retention::stats().blocks, before.blocks);
+    EXPECT_EQ(weak_retention::stats().bytes, before.bytes);
+    EXPECT_EQ(drain_deferred(), 1u);
+    EXPECT_EQ(weak_retention::stats().blocks, before.blocks);
+    EXPECT_EQ(weak_retention::stats().bytes, before.bytes);
+}
+
+TEST_F(DeferredReleaseTest, WeakPtrOutlivingTheDrainIsRetained) {
+    const weak_retention_stats before = weak_retention::stats();
+    shared_ptr<Node> ptr = make_shared_deferred<Node>(5);
+    weak_ptr<Node> observer = ptr;
+    ptr.reset();
+    EXPECT_EQ(weak_retention::stats().blocks, before.blocks);
+
+    drain_deferred();
+    EXPECT_EQ(weak_retention::stats().blocks - before.blocks, 1u);
+    observer.reset();
+    EXPECT_EQ(weak_retention::stats().blocks, before.blocks);
+    EXPECT_EQ(weak_retention::stats().bytes, before.bytes);
+}
+
+TEST_F(DeferredReleaseTest, NestedObjectsAreDeferredInTurn) {
+    shared_ptr<Node> head = make_shared_deferred<Node>(1);
+    head->next = make_shared_deferred<Node>(2);
+    head->next->next = make_shared<Node>(3);
+    head.reset();
+
+    // Each drain destroys one level; the plain make_shared tail goes with
+    // its deferred owner
+    EXPECT_EQ(drain_deferred(), 1u);
+    EXPECT_EQ(Node::destructor_count, 1);
+    EXPECT_EQ(drain_deferred(), 1u);
+    EXPECT_EQ(Node::destructor_count, 3);
+}
+
+// ============================================================================
+// BACKGROUND RECLAIMER
+// ============================================================================
+
+TEST_F(DeferredReleaseTest, ReclaimerDrainsInBackground) {
+    deferred_reclaimer reclaimer(std::chrono::milliseconds(1));
+    make_shared_deferred<Node>(4).reset();
+    for (int i = 0; i < 10000 && Node::destructor_count == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+TEST_F(DeferredReleaseTest, ReclaimerDrainsOnDestruction) {
+    {
+        deferred_reclaimer reclaimer(std::chrono::hours(1));
+        make_shared_deferred<Node>(5).reset();
+    }
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(DeferredReleaseTest, ConcurrentReleaseAndDrain) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 1000;
+    std::atomic<bool> done{false};
+    std::latch start(k_threads + 1);
+
+    std::thread drainer([&] {
+        start.arrive_and_wait();
+        while (!done.load(std::memory_order_acquire)) {
+            drain_deferred();
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&] {
+            start.arrive_and_wait();
+            for (int i = 0; i < k_rounds; ++i) {
+                shared_ptr<Node> ptr = make_shared_deferred<Node>(i);
+                weak_ptr<Node> observer = ptr;
+                ptr.reset();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    done.store(true, std::memory_order_release);
+    drainer.join();
+
+    drain_deferred();
+    EXPECT_EQ(Node::destructor_count, k_threads * k_rounds);
+    EXPECT_EQ(deferred_queue::stats().pending, 0u);
+}
+
+} // namespace ksl
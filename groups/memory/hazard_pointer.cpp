@@ -0,0 +1,240 @@
+#include <hazard_pointer.h>
+
+#include <algorithm>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+namespace {
+/// Records, orphaned retired objects and counters shared by every thread.
+struct domain_state {
+    /// Push-only list of every record ever created.
+    std::atomic<hazard_record *> d_records{nullptr};
+    std::atomic<std::size_t> d_record_count{0};
+
+    /// Retired objects left behind by threads that have exited.
+    std::mutex d_mutex;
+    std::vector<retired_object> d_orphans;
+
+    std::atomic<std::size_t> d_retired{0};
+    std::atomic<std::size_t> d_reclaimed{0};
+    std::atomic<std::size_t> d_scans{0};
+};
+
+domain_state &domain() {
+    // Leaked on purpose: records may be released and objects retired during
+    // static destruction, after a function-local static would be gone.
+    static domain_state *instance = new domain_state;
+    return *instance;
+}
+
+/// Finds an inactive record or creates one.
+hazard_record *claim_record() {
+    domain_state &state = domain();
+    for (hazard_record *record = state.d_records.load(std::memory_order_acquire); record;
+         record = record->d_next) {
+        bool expected = false;
+        if (!record->d_active.load(std::memory_order_relaxed) &&
+            record->d_active.compare_exchange_strong(expected, true,
+                                                     std::memory_order_acquire)) {
+            return record;
+        }
+    }
+
+    hazard_record *record = new hazard_record;
+    record->d_active.store(true, std::memory_order_relaxed);
+    hazard_record *head = state.d_records.load(std::memory_order_relaxed);
+    do {
+        record->d_next = head;
+    } while (!state.d_records.compare_exchange_weak(head, record, std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    state.d_record_count.fetch_add(1, std::memory_order_relaxed);
+    return record;
+}
+
+inline void unclaim_record(hazard_record *record) noexcept {
+    record->d_active.store(false, std::memory_order_release);
+}
+
+/// Reclaims every object in retired that no record holds, and keeps the
+/// others.
+void scan(std::vector<retired_object> &retired) {
+    domain_state &state = domain();
+    state.d_scans.fetch_add(1, std::memory_order_relaxed);
+
+    std::vector<const void *> hazards;
+    for (hazard_record *record = state.d_records.load(std::memory_order_acquire); record;
+         record = record->d_next) {
+        if (const void *ptr = record->d_pointer.load(std::memory_order_seq_cst)) {
+            hazards.push_back(ptr);
+        }
+    }
+    std::sort(hazards.begin(), hazards.end());
+
+    auto held = std::partition(retired.begin(), retired.end(), [&](const retired_object &obj) {
+        return std::binary_search(hazards.begin(), hazards.end(), obj.d_key);
+    });
+    // Reclaiming can retire more objects, so take the batch out first
+    std::vector<retired_object> batch(held, retired.end());
+    retired.erase(held, retired.end());
+    for (const retired_object &obj : batch) {
+        obj.d_reclaim(obj.d_object);
+    }
+    state.d_reclaimed.fetch_add(batch.size(), std::memory_order_relaxed);
+}
+
+/// Whether any record holds key, without allocating.
+bool is_protected(const void *key) noexcept {
+    for (hazard_record *record = domain().d_records.load(std::memory_order_acquire); record;
+         record = record->d_next) {
+        if (record->d_pointer.load(std::memory_order_seq_cst) == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Reclaims object once no record holds it, waiting for its readers if
+/// need be. Used when object cannot be kept on a retired list, so that it
+/// is reclaimed late rather than leaked.
+void reclaim_when_unprotected(const retired_object &object) noexcept {
+    while (is_protected(object.d_key)) {
+        std::this_thread::yield();
+    }
+    object.d_reclaim(object.d_object);
+    domain().d_reclaimed.fetch_add(1, std::memory_order_relaxed);
+}
+
+/// Moves the orphans, if any and if nobody else is taking them, to retired.
+void adopt_orphans(std::vector<retired_object> &retired) {
+    domain_state &state = domain();
+    std::unique_lock<std::mutex> lock(state.d_mutex, std::try_to_lock);
+    if (lock.owns_lock() && !state.d_orphans.empty()) {
+        retired.insert(retired.end(), state.d_orphans.begin(), state.d_orphans.end());
+        state.d_orphans.clear();
+    }
+}
+
+void orphan(std::vector<retired_object> &retired) {
+    if (retired.empty()) {
+        return;
+    }
+    domain_state &state = domain();
+    std::lock_guard<std::mutex> lock(state.d_mutex);
+    state.d_orphans.insert(state.d_orphans.end(), retired.begin(), retired.end());
+    retired.clear();
+}
+
+struct thread_state {
+    static constexpr std::size_t k_cached_records = 8;
+
+    /// Records kept active for this thread's next guards.
+    hazard_record *d_records[k_cached_records] = {};
+    std::size_t d_cached = 0;
+    std::vector<retired_object> d_retired;
+
+    thread_state();
+    ~thread_state();
+
+    [[nodiscard]] std::size_t threshold() const noexcept {
+        return std::max(hazard_domain::k_scan_threshold,
+                        2 * domain().d_record_count.load(std::memory_order_relaxed));
+    }
+};
+
+enum class state_flag : unsigned char { uninitialized, alive, destroyed };
+
+thread_local state_flag t_state_flag = state_flag::uninitialized;
+thread_local thread_state t_state;
+
+thread_state::thread_state() { t_state_flag = state_flag::alive; }
+
+thread_state::~thread_state() {
+    t_state_flag = state_flag::destroyed;
+    for (std::size_t i = 0; i < d_cached; ++i) {
+        unclaim_record(d_records[i]);
+    }
+    if (!d_retired.empty()) {
+        scan(d_retired);
+    }
+    orphan(d_retired);
+}
+
+/// Returns the calling thread's state, or nullptr once it has been
+/// destroyed during thread exit.
+inline thread_state *current_state() noexcept {
+    if (t_state_flag == state_flag::destroyed) {
+        return nullptr;
+    }
+    return &t_state;
+}
+} // namespace
+
+hazard_record *hazard_domain::acquire() {
+    thread_state *state = current_state();
+    if (state && state->d_cached > 0) {
+        return state->d_records[--state->d_cached];
+    }
+    return claim_record();
+}
+
+void hazard_domain::release(hazard_record *record) noexcept {
+    record->d_pointer.store(nullptr, std::memory_order_release);
+    thread_state *state = current_state();
+    if (state && state->d_cached < thread_state::k_cached_records) {
+        state->d_records[state->d_cached++] = record;
+        return;
+    }
+    unclaim_record(record);
+}
+
+void hazard_domain::retire(retired_object object) {
+    domain_state &shared = domain();
+    shared.d_retired.fetch_add(1, std::memory_order_relaxed);
+    thread_state *state = current_state();
+    if (!state) {
+        // The thread is exiting: reclaim now, or leave it to another thread
+        if (!is_protected(object.d_key)) {
+            object.d_reclaim(object.d_object);
+            shared.d_reclaimed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        try {
+            std::lock_guard<std::mutex> lock(shared.d_mutex);
+            shared.d_orphans.push_back(object);
+        } catch (const std::bad_alloc &) {
+            reclaim_when_unprotected(object);
+        }
+        return;
+    }
+    try {
+        state->d_retired.push_back(object);
+    } catch (const std::bad_alloc &) {
+        reclaim_when_unprotected(object);
+        return;
+    }
+    if (state->d_retired.size() >= state->threshold()) {
+        adopt_orphans(state->d_retired);
+        scan(state->d_retired);
+    }
+}
+
+void hazard_domain::reclaim() {
+    thread_state *state = current_state();
+    if (!state) {
+        return;
+    }
+    adopt_orphans(state->d_retired);
+    scan(state->d_retired);
+}
+
+hazard_stats hazard_domain::stats() noexcept {
+    domain_state &state = domain();
+    return {state.d_retired.load(std::memory_order_relaxed),
+            state.d_reclaimed.load(std::memory_order_relaxed),
+            state.d_scans.load(std::memory_order_relaxed)};
+}
+
+} // namespace ksl
\ No newline at end of file
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <shared_ptr.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// HAZARD DOMAIN DEFINITION
+// ============================================================================
+
+/// Slot in which one reader publishes the pointer it is about to use.
+/// Records are owned by the domain and are never freed, only reused.
+struct hazard_record {
+    std::atomic<const void *> d_pointer{nullptr};
+    std::atomic<bool> d_active{false};
+    hazard_record *d_next = nullptr;
+};
+
+/// Object handed to the domain by retire(): reclaim(object) is called once
+/// no hazard record holds key.
+struct retired_object {
+    const void *d_key;
+    void *d_object;
+    void (*d_reclaim)(void *) noexcept;
+};
+
+/// Domain counters, summed over every thread.
+struct hazard_stats {
+    /// Objects passed to retire().
+    std::size_t retired;
+    /// Retired objects that have been reclaimed.
+    std::size_t reclaimed;
+    /// Scans of the hazard records.
+    std::size_t scans;
+};
+
+/// Process-wide hazard pointer domain.
+///
+/// Readers protect a pointer loaded from a std::atomic<T*> with a
+/// protected_ptr, which publishes it in a hazard record, without touching
+/// the object or its reference counts. Writers unlink an object, with a
+/// seq_cst store or exchange, and retire it. Retired objects are kept on a
+/// per-thread list, and once the list reaches the scan threshold the
+/// records are scanned and every object no reader holds is reclaimed in
+/// one batch. Objects still on a list when their thread exits are adopted
+/// by the next scan on any thread.
+class hazard_domain {
+  public:
+    /// Minimum length of a thread's retired list before it is scanned. The
+    /// actual threshold also grows with the number of records, so a scan
+    /// always reclaims at least half the list.
+    static constexpr std::size_t k_scan_threshold = 64;
+
+    /// Returns an active record for the calling thread, reusing one from
+    /// the thread's cache when possible.
+    static hazard_record *acquire();
+
+    /// Clears the record and gives it back.
+    static void release(hazard_record *record) noexcept;
+
+    static void retire(retired_object object);
+
+    /// Scans now, reclaiming every retired object no reader holds. Used to
+    /// bound memory at quiescent points and by tests.
+    static void reclaim();
+
+    static hazard_stats stats() noexcept;
+};
+
+// ============================================================================
+// PROTECTED POINTER DEFINITION
+// ============================================================================
+
+/// Non-owning guard keeping the object it protects from being reclaimed.
+/// Unlike shared_ptr, protecting an object writes only to the guard's own
+/// record, so readers of one object never contend on a cache line.
+///
+/// A guard owns one hazard record for its lifetime and can protect
+/// successive pointers with it. It must stay on the thread that created it.
+template <typename T> class protected_ptr {
+    hazard_record *d_record;
+    T *d_ptr;
+
+  public:
+    using Value_Type = T;
+
+  public:
+    /// CONSTRUCTORS
+    protected_ptr() : d_record(hazard_domain::acquire()), d_ptr(nullptr) {}
+
+    /// Protects the current value of src.
+    explicit protected_ptr(const std::atomic<T *> &src) : protected_ptr() { protect(src); }
+
+    protected_ptr(const protected_ptr &) = delete;
+    protected_ptr &operator=(const protected_ptr &) = delete;
+
+    /// DESTRUCTORS
+    ~protected_ptr() { hazard_domain::release(d_record); }
+
+  public:
+    // MODIFIERS
+    /// Loads src and publishes it until the load is stable, then returns
+    /// the protected pointer. It stays valid until the next protect() or
+    /// reset(), even if src is changed and the object retired meanwhile.
+    T *protect(const std::atomic<T *> &src) noexcept;
+
+    /// Stops protecting the current object.
+    inline void reset() noexcept {
+        d_record->d_pointer.store(nullptr, std::memory_order_release);
+        d_ptr = nullptr;
+    }
+
+  public:
+    // ACCESSORS
+    [[nodiscard]] inline T *get() const noexcept { return d_ptr; }
+
+    [[nodiscard]] T &operator*() const noexcept {
+        assert(d_ptr != nullptr && "Attempted to dereference a null protected_ptr");
+        return *(get());
+    }
+
+    [[nodiscard]] T *operator->() const noexcept { return get(); }
+
+    [[nodiscard]] operator bool() const noexcept { return get() != nullptr; };
+};
+
+// ============================================================================
+// PROTECTED POINTER IMPLEMENTATION
+// ============================================================================
+
+template <typename T> T *protected_ptr<T>::protect(const std::atomic<T *> &src) noexcept {
+    T *ptr = src.load(std::memory_order_relaxed);
+    for (;;) {
+        // The publication must be ordered before the re-load: if src still
+        // holds ptr then, the writer's unlink comes later and its scan
+        // will see this record.
+        d_record->d_pointer.store(ptr, std::memory_order_seq_cst);
+        T *current = src.load(std::memory_order_seq_cst);
+        if (current == ptr) {
+            d_ptr = ptr;
+            return ptr;
+        }
+        ptr = current;
+    }
+}
+
+// ============================================================================
+// RETIRE IMPLEMENTATION
+// ============================================================================
+
+/// Deletes ptr once no protected_ptr holds it. ptr must already be
+/// unreachable for new readers. If the retired list cannot grow, ptr is
+/// deleted as soon as its readers let go, waiting for them.
+template <typename T> void retire(T *ptr) {
+    if (!ptr) {
+        return;
+    }
+    hazard_domain::retire(
+        {ptr, ptr, [](void *object) noexcept { delete static_cast<T *>(object); }});
+}
+
+/// Drops ptr's reference once no protected_ptr holds ptr.get(). This is the
+/// writer side for objects owned by shared_ptr and published as a raw
+/// pointer: readers protect the raw pointer, and the writer retires its
+/// handle instead of releasing it. Like retire(T*), it waits for readers
+/// rather than losing the reference if the retired list cannot grow.
+template <typename T> void retire(shared_ptr<T> ptr) {
+    const void *key = ptr.get();
+    control_block_base *cb = shared_ptr_access::detach(ptr);
+    if (!cb) {
+        return;
+    }
+    hazard_domain::retire({key, cb, [](void *object) noexcept {
+                               static_cast<control_block_base *>(object)->release_shared();
+                           }});
+}
+
+} // namespace ksl
@@ -0,0 +1,264 @@
+// Component being tested
+#include <hazard_pointer.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <latch>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+/// Allocations the calling thread makes before its next operator new
+/// throws std::bad_alloc, or -1 for none.
+thread_local int t_allocations_before_failure = -1;
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (t_allocations_before_failure >= 0 && t_allocations_before_failure-- == 0) {
+        throw std::bad_alloc();
+    }
+    if (void *ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace ksl {
+
+/// Makes the calling thread's next operator new throw, for a scope.
+class failing_allocation_scope {
+  public:
+    failing_allocation_scope() noexcept { t_allocations_before_failure = 0; }
+
+    failing_allocation_scope(const failing_allocation_scope &) = delete;
+    failing_allocation_scope &operator=(const failing_allocation_scope &) = delete;
+
+    ~failing_allocation_scope() { t_allocations_before_failure = -1; }
+};
+
+class HazardPointerTest : public ::testing::Test {
+  protected:
+    struct Node {
+        int value;
+        static std::atomic<int> destructor_count;
+
+        explicit Node(int v = 42) : value(v) {}
+        ~Node() { destructor_count++; }
+    };
+
+    void SetUp() override {
+        // Start every test from an empty retired list
+        hazard_domain::reclaim();
+        Node::destructor_count = 0;
+    }
+};
+
+std::atomic<int> HazardPointerTest::Node::destructor_count = 0;
+
+// ============================================================================
+// PROTECTED_PTR
+// ============================================================================
+
+TEST_F(HazardPointerTest, ProtectReturnsTheCurrentValue) {
+    Node node(3);
+    std::atomic<Node *> slot{&node};
+
+    protected_ptr<Node> guard(slot);
+    EXPECT_EQ(guard.get(), &node);
+    EXPECT_EQ(guard->value, 3);
+    EXPECT_EQ((*guard).value, 3);
+    static_assert(std::is_same_v<protected_ptr<Node>::Value_Type, Node>);
+
+    guard.reset();
+    EXPECT_FALSE(guard);
+
+    std::atomic<Node *> empty{nullptr};
+    EXPECT_EQ(guard.protect(empty), nullptr);
+}
+
+TEST_F(HazardPointerTest, RetiredObjectIsKeptWhileProtected) {
+    std::atomic<Node *> slot{new Node(1)};
+    protected_ptr<Node> guard(slot);
+
+    retire(slot.exchange(new Node(2)));
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, 0);
+    EXPECT_EQ(guard->value, 1);
+
+    guard.reset();
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, 1);
+
+    retire(slot.exchange(nullptr));
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, 2);
+}
+
+TEST_F(HazardPointerTest, GuardCanProtectSuccessiveObjects) {
+    std::atomic<Node *> first{new Node(1)};
+    std::atomic<Node *> second{new Node(2)};
+    protected_ptr<Node> guard(first);
+    EXPECT_EQ(guard.protect(second)->value, 2);
+
+    // Only the object currently protected is held back
+    retire(first.exchange(nullptr));
+    retire(second.exchange(nullptr));
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, 1);
+
+    guard.reset();
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, 2);
+}
+
+// ============================================================================
+// RETIRING SHARED_PTR
+// ============================================================================
+
+TEST_F(HazardPointerTest, RetireSharedPtrDropsTheReferenceWhenUnprotected) {
+    shared_ptr<Node> owner = make_shared<Node>(5);
+    weak_ptr<Node> observer(owner);
+    std::atomic<Node *> slot{owner.get()};
+
+    protected_ptr<Node> guard(slot);
+    // Reading through the guard does not take a reference
+    EXPECT_EQ(owner.use_count(), 1);
+
+    slot.store(nullptr);
+    retire(std::move(owner));
+    EXPECT_FALSE(owner);
+    hazard_domain::reclaim();
+    EXPECT_FALSE(observer.expired());
+    EXPECT_EQ(guard->value, 5);
+
+    guard.reset();
+    hazard_domain::reclaim();
+    EXPECT_TRUE(observer.expired());
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+TEST_F(HazardPointerTest, RetireSharedPtrWithOtherOwners) {
+    shared_ptr<Node> owner = make_shared<Node>(6);
+    shared_ptr<Node> other = owner;
+    retire(std::move(owner));
+    hazard_domain::reclaim();
+    EXPECT_EQ(other.use_count(), 1);
+    EXPECT_EQ(Node::destructor_count, 0);
+}
+
+TEST_F(HazardPointerTest, RetireWithoutMemoryReleasesAtOnce) {
+    shared_ptr<Node> owner = make_shared<Node>(8);
+    weak_ptr<Node> observer(owner);
+    std::thread worker([&owner] {
+        // A new thread's retired list has no room yet
+        hazard_domain::reclaim();
+        failing_allocation_scope failing;
+        retire(std::move(owner));
+    });
+    worker.join();
+    EXPECT_TRUE(observer.expired());
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+TEST_F(HazardPointerTest, RetireWithoutMemoryWaitsForReaders) {
+    std::atomic<Node *> slot{new Node(9)};
+    protected_ptr<Node> guard(slot);
+    std::thread worker([&slot] {
+        hazard_domain::reclaim();
+        failing_allocation_scope failing;
+        retire(slot.exchange(nullptr));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(Node::destructor_count, 0);
+    EXPECT_EQ(guard->value, 9);
+    guard.reset();
+    worker.join();
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+// ============================================================================
+// BATCHING
+// ============================================================================
+
+TEST_F(HazardPointerTest, ReclaimsInBatches) {
+    const hazard_stats before = hazard_domain::stats();
+    for (std::size_t i = 1; i < hazard_domain::k_scan_threshold; ++i) {
+        retire(new Node);
+    }
+    hazard_stats after = hazard_domain::stats();
+    EXPECT_EQ(after.retired - before.retired, hazard_domain::k_scan_threshold - 1);
+    EXPECT_EQ(after.reclaimed, before.reclaimed);
+    EXPECT_EQ(Node::destructor_count, 0);
+
+    retire(new Node);
+    after = hazard_domain::stats();
+    EXPECT_EQ(after.reclaimed - before.reclaimed, hazard_domain::k_scan_threshold);
+    EXPECT_EQ(after.scans - before.scans, 1u);
+    EXPECT_EQ(Node::destructor_count, static_cast<int>(hazard_domain::k_scan_threshold));
+}
+
+TEST_F(HazardPointerTest, ThreadExitOrphansHeldObjects) {
+    std::atomic<Node *> slot{new Node(7)};
+    protected_ptr<Node> guard(slot);
+
+    std::thread worker([&slot] { retire(slot.exchange(nullptr)); });
+    worker.join();
+    EXPECT_EQ(Node::destructor_count, 0);
+
+    // The exited thread's object is adopted and reclaimed by this one
+    guard.reset();
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(HazardPointerTest, ConcurrentReadersAndWriter) {
+    // Readers must always see a live, fully constructed object while the
+    // writer keeps replacing and retiring it.
+    constexpr int k_readers = 4;
+    constexpr int k_writes = 2000;
+    std::atomic<Node *> slot{new Node(0)};
+    std::atomic<bool> done{false};
+    std::latch start(k_readers + 1);
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < k_readers; ++r) {
+        readers.emplace_back([&] {
+            start.arrive_and_wait();
+            protected_ptr<Node> guard;
+            int last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                Node *node = guard.protect(slot);
+                ASSERT_NE(node, nullptr);
+                EXPECT_GE(node->value, last);
+                last = node->value;
+            }
+        });
+    }
+    start.arrive_and_wait();
+    for (int i = 1; i <= k_writes; ++i) {
+        retire(slot.exchange(new Node(i)));
+    }
+    done.store(true, std::memory_order_release);
+    for (auto &reader : readers) {
+        reader.join();
+    }
+
+    retire(slot.exchange(nullptr));
+    hazard_domain::reclaim();
+    EXPECT_EQ(Node::destructor_count, k_writes + 1);
+}
+
+} // namespace ksl
@@ -0,0 +1 @@
+#include <intrusive_ptr.h>
\ No newline at end of file
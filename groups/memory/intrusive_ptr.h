@@ -0,0 +1,221 @@
+#pragma once
+
+#include <relocate.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// REFERENCE COUNTER POLICIES
+// ============================================================================
+
+/// Atomic count, for objects shared between threads. Uses the same orders
+/// as control_block_base: increments are relaxed, since a new reference is
+/// always made from an existing one, and the decrement is acq_rel so the
+/// thread that deletes the object sees every other owner's writes.
+struct thread_safe_counter {
+    using Type = std::atomic<std::size_t>;
+
+    static void increment(Type &count) noexcept { count.fetch_add(1, std::memory_order_relaxed); }
+
+    /// Returns the count after the decrement.
+    [[nodiscard]] static std::size_t decrement(Type &count) noexcept {
+        return count.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    }
+
+    [[nodiscard]] static std::size_t load(const Type &count) noexcept {
+        return count.load(std::memory_order_acquire);
+    }
+};
+
+/// Plain count, for objects that never leave one thread.
+struct thread_unsafe_counter {
+    using Type = std::size_t;
+
+    static void increment(Type &count) noexcept { ++count; }
+
+    [[nodiscard]] static std::size_t decrement(Type &count) noexcept { return --count; }
+
+    [[nodiscard]] static std::size_t load(const Type &count) noexcept { return count; }
+};
+
+// ============================================================================
+// INTRUSIVE REFERENCE COUNTER DEFINITION
+// ============================================================================
+
+/// CRTP base embedding the reference count in T itself:
+///
+///     struct message : ksl::intrusive_ref_counter<message> { ... };
+///
+/// The count starts at zero; the first intrusive_ptr takes it to one. When
+/// the last one is released the object is deleted through T, so it must
+/// have been allocated with new (or make_intrusive). Copying an object does
+/// not copy its count.
+template <typename T, typename Policy = thread_safe_counter> class intrusive_ref_counter {
+    mutable typename Policy::Type d_ref_count;
+
+  protected:
+    constexpr intrusive_ref_counter() noexcept : d_ref_count(0) {}
+
+    intrusive_ref_counter(const intrusive_ref_counter &) noexcept : d_ref_count(0) {}
+
+    intrusive_ref_counter &operator=(const intrusive_ref_counter &) noexcept { return *this; }
+
+    ~intrusive_ref_counter() = default;
+
+  public:
+    // OBSERVERS
+    [[nodiscard]] std::size_t use_count() const noexcept { return Policy::load(d_ref_count); }
+
+  public:
+    // Friend
+    /// Hooks found by argument-dependent lookup from intrusive_ptr. Types
+    /// that keep their own count can provide these two instead.
+    friend void intrusive_ptr_add_ref(const intrusive_ref_counter *ptr) noexcept {
+        Policy::increment(ptr->d_ref_count);
+    }
+
+    friend void intrusive_ptr_release(const intrusive_ref_counter *ptr) noexcept {
+        if (Policy::decrement(ptr->d_ref_count) == 0) {
+            delete static_cast<const T *>(ptr);
+        }
+    }
+};
+
+// ============================================================================
+// INTRUSIVE POINTER DEFINITION
+// ============================================================================
+
+/// A single-pointer handle to an object that counts its own references, by
+/// deriving from intrusive_ref_counter or by providing
+/// intrusive_ptr_add_ref / intrusive_ptr_release. There is no control
+/// block, so there is no weak_ptr either.
+template <typename T> class intrusive_ptr {
+    T *d_ptr;
+
+    template <typename Y> friend class intrusive_ptr;
+
+  public:
+    using Value_Type = T;
+
+  public:
+    /// CONSTRUCTORS
+    constexpr intrusive_ptr() noexcept : d_ptr(nullptr) {}
+
+    constexpr intrusive_ptr(std::nullptr_t) noexcept : d_ptr(nullptr) {}
+
+    /// Takes a reference to ptr. With add_ref false, adopts a reference
+    /// the caller already holds, for instance one given up by detach().
+    explicit intrusive_ptr(T *ptr, bool add_ref = true) noexcept;
+
+    intrusive_ptr(const intrusive_ptr &rhs) noexcept;
+
+    template <typename Y>
+        requires std::is_convertible_v<Y *, T *>
+    intrusive_ptr(const intrusive_ptr<Y> &rhs) noexcept;
+
+    intrusive_ptr(intrusive_ptr &&rhs) noexcept : d_ptr(std::exchange(rhs.d_ptr, nullptr)) {}
+
+    template <typename Y>
+        requires std::is_convertible_v<Y *, T *>
+    intrusive_ptr(intrusive_ptr<Y> &&rhs) noexcept : d_ptr(std::exchange(rhs.d_ptr, nullptr)) {}
+
+    /// DESTRUCTORS
+    ~intrusive_ptr();
+
+    /// ASSIGNMENT
+    intrusive_ptr &operator=(const intrusive_ptr &rhs) noexcept {
+        intrusive_ptr(rhs).swap(*this);
+        return *this;
+    }
+
+    intrusive_ptr &operator=(intrusive_ptr &&rhs) noexcept {
+        intrusive_ptr(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+  public:
+    // ACCESSORS
+    [[nodiscard]] inline T *get() const noexcept { return d_ptr; }
+
+    [[nodiscard]] T &operator*() const noexcept {
+        assert(d_ptr != nullptr && "Attempted to dereference a null intrusive_ptr");
+        return *(get());
+    }
+
+    [[nodiscard]] T *operator->() const noexcept { return get(); }
+
+    [[nodiscard]] operator bool() const noexcept { return get() != nullptr; };
+
+  public:
+    // OBSERVERS
+    /// Requires T to provide use_count(), as intrusive_ref_counter does.
+    [[nodiscard]] inline std::size_t use_count() const noexcept {
+        if (d_ptr) {
+            return d_ptr->use_count();
+        }
+        return 0;
+    }
+
+  public:
+    // MODIFIERS
+    inline void reset() noexcept { intrusive_ptr().swap(*this); }
+
+    inline void reset(T *ptr, bool add_ref = true) noexcept {
+        intrusive_ptr(ptr, add_ref).swap(*this);
+    }
+
+    /// Gives up the reference without releasing it and returns the pointer.
+    [[nodiscard]] inline T *detach() noexcept { return std::exchange(d_ptr, nullptr); }
+
+    inline void swap(intrusive_ptr &ptr) noexcept { std::swap(d_ptr, ptr.d_ptr); }
+};
+
+// ============================================================================
+// INTRUSIVE POINTER IMPLEMENTATION
+// ============================================================================
+
+template <typename T> intrusive_ptr<T>::intrusive_ptr(T *ptr, bool add_ref) noexcept : d_ptr(ptr) {
+    if (d_ptr && add_ref) {
+        intrusive_ptr_add_ref(d_ptr);
+    }
+}
+
+template <typename T>
+intrusive_ptr<T>::intrusive_ptr(const intrusive_ptr &rhs) noexcept : d_ptr(rhs.d_ptr) {
+    if (d_ptr) {
+        intrusive_ptr_add_ref(d_ptr);
+    }
+}
+
+template <typename T>
+template <typename Y>
+    requires std::is_convertible_v<Y *, T *>
+intrusive_ptr<T>::intrusive_ptr(const intrusive_ptr<Y> &rhs) noexcept : d_ptr(rhs.d_ptr) {
+    if (d_ptr) {
+        intrusive_ptr_add_ref(d_ptr);
+    }
+}
+
+template <typename T> intrusive_ptr<T>::~intrusive_ptr() {
+    if (d_ptr) {
+        intrusive_ptr_release(d_ptr);
+    }
+}
+
+// ============================================================================
+// MAKE_INTRUSIVE IMPLEMENTATION
+// ============================================================================
+
+template <typename T, typename... Args> intrusive_ptr<T> make_intrusive(Args &&...args) {
+    return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T> struct is_trivially_relocatable<intrusive_ptr<T>> : std::true_type {};
+
+} // namespace ksl
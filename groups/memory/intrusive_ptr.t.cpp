@@ -0,0 +1,191 @@
+// Component being tested
+#include <intrusive_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class IntrusivePtrTest : public ::testing::Test {
+  protected:
+    struct Base : intrusive_ref_counter<Base> {
+        int value;
+        static int destructor_count;
+
+        explicit Base(int v = 42) : value(v) {}
+        virtual ~Base() { destructor_count++; }
+    };
+
+    struct Derived : Base {
+        explicit Derived(int v = 42) : Base(v) {}
+    };
+
+    struct Local : intrusive_ref_counter<Local, thread_unsafe_counter> {
+        int value = 7;
+    };
+};
+
+int IntrusivePtrTest::Base::destructor_count = 0;
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+TEST_F(IntrusivePtrTest, SinglePointerHandle) {
+    static_assert(sizeof(intrusive_ptr<Base>) == sizeof(Base *));
+    static_assert(std::is_same_v<intrusive_ptr<Base>::Value_Type, Base>);
+}
+
+// ============================================================================
+// CONSTRUCTORS
+// ============================================================================
+
+TEST_F(IntrusivePtrTest, DefaultAndNullptrConstructors) {
+    intrusive_ptr<Base> empty;
+    intrusive_ptr<Base> null(nullptr);
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(null.get(), nullptr);
+    EXPECT_EQ(empty.use_count(), 0u);
+}
+
+TEST_F(IntrusivePtrTest, RawPointerConstructor) {
+    Base::destructor_count = 0;
+    {
+        Base *raw = new Base(3);
+        intrusive_ptr<Base> ptr(raw);
+        EXPECT_EQ(ptr.get(), raw);
+        EXPECT_EQ(ptr->value, 3);
+        EXPECT_EQ((*ptr).value, 3);
+        EXPECT_EQ(ptr.use_count(), 1u);
+
+        // A second handle made from the raw pointer shares the count
+        intrusive_ptr<Base> again(raw);
+        EXPECT_EQ(ptr.use_count(), 2u);
+    }
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+TEST_F(IntrusivePtrTest, CopyAndMove) {
+    Base::destructor_count = 0;
+    {
+        intrusive_ptr<Base> ptr = make_intrusive<Base>(1);
+        intrusive_ptr<Base> copy(ptr);
+        EXPECT_EQ(ptr.use_count(), 2u);
+
+        intrusive_ptr<Base> moved(std::move(copy));
+        EXPECT_FALSE(copy);
+        EXPECT_EQ(moved.use_count(), 2u);
+
+        copy = moved;
+        EXPECT_EQ(ptr.use_count(), 3u);
+        copy = std::move(moved);
+        EXPECT_FALSE(moved);
+        EXPECT_EQ(ptr.use_count(), 2u);
+
+        copy = copy;
+        EXPECT_EQ(ptr.use_count(), 2u);
+    }
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+TEST_F(IntrusivePtrTest, ConvertingConstructors) {
+    Base::destructor_count = 0;
+    {
+        intrusive_ptr<Derived> derived = make_intrusive<Derived>(5);
+        intrusive_ptr<Base> base(derived);
+        EXPECT_EQ(base->value, 5);
+        EXPECT_EQ(derived.use_count(), 2u);
+
+        intrusive_ptr<Base> moved(std::move(derived));
+        EXPECT_FALSE(derived);
+        EXPECT_EQ(base.use_count(), 2u);
+    }
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+// ============================================================================
+// MODIFIERS
+// ============================================================================
+
+TEST_F(IntrusivePtrTest, ResetAndSwap) {
+    Base::destructor_count = 0;
+    intrusive_ptr<Base> ptr = make_intrusive<Base>(1);
+    ptr.reset(new Base(2));
+    EXPECT_EQ(Base::destructor_count, 1);
+    EXPECT_EQ(ptr->value, 2);
+
+    intrusive_ptr<Base> other = make_intrusive<Base>(3);
+    ptr.swap(other);
+    EXPECT_EQ(ptr->value, 3);
+    EXPECT_EQ(other->value, 2);
+
+    ptr.reset();
+    other.reset();
+    EXPECT_EQ(Base::destructor_count, 3);
+}
+
+TEST_F(IntrusivePtrTest, DetachAndAdopt) {
+    Base::destructor_count = 0;
+    intrusive_ptr<Base> ptr = make_intrusive<Base>(4);
+    Base *raw = ptr.detach();
+    EXPECT_FALSE(ptr);
+    EXPECT_EQ(raw->use_count(), 1u);
+    EXPECT_EQ(Base::destructor_count, 0);
+
+    ptr.reset(raw, false);
+    EXPECT_EQ(ptr.use_count(), 1u);
+    ptr.reset();
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+TEST_F(IntrusivePtrTest, CopyingTheObjectDoesNotCopyTheCount) {
+    intrusive_ptr<Base> ptr = make_intrusive<Base>(6);
+    intrusive_ptr<Base> copy(new Base(*ptr));
+    EXPECT_EQ(copy->value, 6);
+    EXPECT_EQ(ptr.use_count(), 1u);
+    EXPECT_EQ(copy.use_count(), 1u);
+
+    *copy = *ptr;
+    EXPECT_EQ(copy.use_count(), 1u);
+}
+
+TEST_F(IntrusivePtrTest, ThreadUnsafePolicy) {
+    intrusive_ptr<Local> ptr = make_intrusive<Local>();
+    intrusive_ptr<Local> copy(ptr);
+    EXPECT_EQ(ptr.use_count(), 2u);
+    copy.reset();
+    EXPECT_EQ(ptr.use_count(), 1u);
+    EXPECT_EQ(ptr->value, 7);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(IntrusivePtrTest, ConcurrentCopyAndRelease) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 2000;
+    Base::destructor_count = 0;
+    {
+        intrusive_ptr<Base> ptr = make_intrusive<Base>(1);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < k_threads; ++t) {
+            threads.emplace_back([ptr] {
+                for (int i = 0; i < k_rounds; ++i) {
+                    intrusive_ptr<Base> copy(ptr);
+                    EXPECT_EQ(copy->value, 1);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(ptr.use_count(), 1u);
+    }
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+} // namespace ksl
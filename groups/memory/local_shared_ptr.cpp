@@ -0,0 +1 @@
+#include <local_shared_ptr.h>
\ No newline at end of file
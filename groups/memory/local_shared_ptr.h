@@ -0,0 +1,454 @@
+#pragma once
+
+#include <shared_ptr.h>
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace ksl {
+namespace {
+/// Single-threaded counterpart of control_block_base. The counts are plain
+/// integers, so a copy is an ordinary increment instead of a locked RMW.
+/// Blocks and every handle pointing at them must stay on one thread.
+///
+/// Like control_block_base, a block starts with one shared reference and
+/// the shared owners collectively hold one weak reference.
+struct local_control_block_base {
+    size_t d_shared_count{1};
+    size_t d_weak_count{1};
+
+    inline void increment_shared_count() noexcept { ++d_shared_count; }
+
+    /// Takes a shared reference unless the object has already expired.
+    /// Returns false if the shared count was zero.
+    [[nodiscard]] inline bool increment_shared_count_if_not_zero() noexcept {
+        if (d_shared_count == 0) {
+            return false;
+        }
+        ++d_shared_count;
+        return true;
+    }
+
+    /// Drops a shared reference, disposing of the object and dropping the
+    /// owners' weak reference if it was the last one.
+    inline void release_shared() noexcept {
+        if (--d_shared_count == 0) {
+            dispose();
+            release_weak();
+        }
+    }
+
+    [[nodiscard]] inline size_t shared_count() const noexcept { return d_shared_count; }
+
+    inline void increment_weak_count() noexcept { ++d_weak_count; }
+
+    /// Drops a weak reference, deleting the block if it was the last one.
+    inline void release_weak() noexcept {
+        if (--d_weak_count == 0) {
+            delete this;
+        }
+    }
+
+    /// Number of weak references, including the one held by the shared
+    /// owners while the object is alive.
+    [[nodiscard]] inline size_t weak_count() const noexcept { return d_weak_count; }
+
+    virtual void dispose() = 0;
+    virtual ~local_control_block_base() = default;
+};
+
+template <typename T, typename Deleter = std::default_delete<T>>
+struct local_control_block_impl : public local_control_block_base {
+    T *d_ptr;
+    Deleter d_deleter;
+
+    local_control_block_impl(T *ptr, Deleter deleter) : d_ptr(ptr), d_deleter(deleter) {}
+    void dispose() override { d_deleter(d_ptr); }
+};
+
+template <typename T>
+struct local_control_block_make_shared_impl : public local_control_block_base {
+    alignas(T) char d_storage[sizeof(T)];
+
+    template <typename... Args> local_control_block_make_shared_impl(Args &&...args) {
+        new (d_storage) T(std::forward<Args>(args)...);
+    }
+
+    void dispose() override { reinterpret_cast<T *>(d_storage)->~T(); }
+};
+} // namespace
+
+// ============================================================================
+// LOCAL SHARED POINTERS DEFINITION
+// ============================================================================
+
+template <typename T> class local_weak_ptr;
+
+/// Non-atomic shared_ptr for ownership that never crosses a thread. The
+/// interface mirrors ksl::shared_ptr.
+template <typename T> class local_shared_ptr {
+    T *d_ptr;
+    local_control_block_base *d_cb;
+
+    inline void release() {
+        if (!d_cb) {
+            return;
+        }
+
+        d_cb->release_shared();
+        d_cb = nullptr;
+        d_ptr = nullptr;
+    }
+
+  public:
+    using Value_Type = T;
+
+  public:
+    // Constructor
+    /// Default constructor that contains no managed object and zero
+    /// shared references
+    constexpr local_shared_ptr() noexcept;
+
+    constexpr local_shared_ptr(std::nullptr_t) noexcept;
+
+    /// Creates a local_shared_ptr that manages the given raw pointer.
+    explicit local_shared_ptr(T *ptr);
+
+    /// Creates a local_shared_ptr that manages the given raw pointer and
+    /// a deleter to manage the clean up of the raw pointer
+    template <typename Deleter>
+        requires CallableDeleter<T, Deleter>
+    explicit local_shared_ptr(T *ptr, Deleter deleter);
+
+    // Create a local_shared_ptr from a local_weak_ptr
+    explicit local_shared_ptr(const local_weak_ptr<T> &ptr);
+
+    // Copy constructor
+    local_shared_ptr(const local_shared_ptr<T> &rhs) noexcept;
+
+    /// Alias copy constructor
+    template <typename Y>
+    local_shared_ptr(const local_shared_ptr<Y> &ptr, T *element_type) noexcept;
+
+    // Move constructor
+    local_shared_ptr(local_shared_ptr<T> &&rhs) noexcept;
+
+    /// Alias move constructor
+    template <typename Y> local_shared_ptr(local_shared_ptr<Y> &&ptr, T *element_type) noexcept;
+
+    // Copy assignment
+    /// Assignment operator that deletes the current managed object and
+    /// takes ownership of the given local_shared_ptr's managed object.
+    local_shared_ptr<T> &operator=(const local_shared_ptr<T> &rhs);
+
+    // Move assignment
+    local_shared_ptr<T> &operator=(local_shared_ptr<T> &&rhs);
+
+    // Desctructor
+    /// Destroys the managed object if this is the last local_shared_ptr
+    /// owning it.
+    ~local_shared_ptr();
+
+  private:
+    // A private constructor for internal use by local_weak_ptr &&
+    // make_local_shared. Adopts a shared reference the caller has already
+    // taken on cb.
+    local_shared_ptr(T *ptr, local_control_block_base *cb) noexcept;
+
+  public:
+    // ACCESSORS
+    [[nodiscard]] inline T *get() const noexcept { return d_ptr; }
+
+    [[nodiscard]] T &operator*() const noexcept {
+        assert(d_ptr != nullptr && "Attempted to dereference a null local_shared_ptr");
+        return *(get());
+    }
+
+    [[nodiscard]] T *operator->() const noexcept { return get(); }
+
+    [[nodiscard]] operator bool() const noexcept { return get() != nullptr; };
+
+  public:
+    // OBSERVERS
+    [[nodiscard]] inline std::size_t use_count() const noexcept {
+        if (d_cb) {
+            return d_cb->shared_count();
+        }
+        return 0;
+    }
+
+  public:
+    inline void reset() { release(); }
+
+    inline void reset(T *ptr) { local_shared_ptr<T>(ptr).swap(*this); }
+
+    template <typename Deleter> inline void reset(T *ptr, Deleter deleter) {
+        local_shared_ptr<T>(ptr, deleter).swap(*this);
+    }
+
+    inline void swap(local_shared_ptr &ptr) noexcept {
+        std::swap(this->d_ptr, ptr.d_ptr);
+        std::swap(this->d_cb, ptr.d_cb);
+    }
+
+  public:
+    // Friend
+    friend class local_weak_ptr<T>;
+
+    template <typename Y> friend class local_shared_ptr;
+
+    template <typename Y, typename... Args>
+    friend local_shared_ptr<Y> make_local_shared(Args &&...args);
+};
+
+// ============================================================================
+// LOCAL WEAK POINTERS DEFINITION
+// ============================================================================
+template <typename T> class local_weak_ptr {
+    T *d_ptr;
+    local_control_block_base *d_cb;
+
+  private:
+    inline void release() {
+        if (!d_cb) {
+            return;
+        }
+        d_cb->release_weak();
+        d_cb = nullptr;
+        d_ptr = nullptr;
+    }
+
+  public:
+    using Value_Type = T;
+
+  public:
+    /// CONSTRUCTORS
+    constexpr local_weak_ptr() noexcept;
+
+    local_weak_ptr(const local_weak_ptr<T> &ptr) noexcept;
+
+    local_weak_ptr(const local_shared_ptr<T> &ptr) noexcept;
+
+    local_weak_ptr(local_weak_ptr<T> &&ptr) noexcept;
+
+    /// DESTRUCTORS
+    ~local_weak_ptr() noexcept;
+
+    /// ASSIGNMENT
+    local_weak_ptr<T> &operator=(const local_weak_ptr<T> &rhs) noexcept;
+
+    local_weak_ptr<T> &operator=(const local_shared_ptr<T> &rhs) noexcept;
+
+    local_weak_ptr<T> &operator=(local_weak_ptr<T> &&rhs) noexcept;
+
+  public:
+    /// MODIFIERS
+    inline void reset() noexcept { release(); }
+
+    inline void swap(local_weak_ptr<T> &ptr) noexcept;
+
+  public:
+    // OBSERVERS
+    [[nodiscard]] inline std::size_t use_count() const noexcept {
+        if (d_cb) {
+            return d_cb->shared_count();
+        }
+        return 0;
+    }
+
+    [[nodiscard]] inline bool expired() const noexcept {
+        return d_cb == nullptr || d_cb->shared_count() == 0;
+    }
+
+    [[nodiscard]] inline local_shared_ptr<T> lock() const noexcept {
+        if (d_cb && d_cb->increment_shared_count_if_not_zero()) {
+            return local_shared_ptr<T>(this->d_ptr, this->d_cb);
+        }
+        return local_shared_ptr<T>();
+    }
+
+  public:
+    // Friend
+    friend class local_shared_ptr<T>;
+};
+
+// ============================================================================
+// LOCAL SHARED POINTERS IMPLEMENTATION
+// ============================================================================
+
+template <typename T>
+constexpr local_shared_ptr<T>::local_shared_ptr() noexcept : d_ptr(nullptr), d_cb(nullptr) {}
+
+template <typename T>
+constexpr local_shared_ptr<T>::local_shared_ptr(std::nullptr_t) noexcept
+    : d_ptr(nullptr), d_cb(nullptr) {}
+
+template <typename T>
+local_shared_ptr<T>::local_shared_ptr(T *ptr)
+    : d_ptr(ptr), d_cb(new local_control_block_impl<T, std::default_delete<T>>{
+                      ptr, std::default_delete<T>()}) {}
+
+template <typename T>
+template <typename Deleter>
+    requires CallableDeleter<T, Deleter>
+local_shared_ptr<T>::local_shared_ptr(T *ptr, Deleter deleter)
+    : d_ptr(ptr), d_cb(new local_control_block_impl<T, Deleter>{ptr, deleter}) {}
+
+template <typename T> local_shared_ptr<T>::local_shared_ptr(const local_weak_ptr<T> &wptr) {
+    if (wptr.d_cb && wptr.d_cb->increment_shared_count_if_not_zero()) {
+        this->d_ptr = wptr.d_ptr;
+        this->d_cb = wptr.d_cb;
+    } else {
+        this->d_ptr = nullptr;
+        this->d_cb = nullptr;
+    }
+}
+
+template <typename T> local_shared_ptr<T>::~local_shared_ptr() { release(); }
+
+template <typename T>
+local_shared_ptr<T>::local_shared_ptr(const local_shared_ptr<T> &rhs) noexcept
+    : d_ptr(rhs.d_ptr), d_cb(rhs.d_cb) {
+    if (d_cb) {
+        d_cb->increment_shared_count();
+    }
+}
+
+/// Alias constructor
+template <typename T>
+template <typename Y>
+local_shared_ptr<T>::local_shared_ptr(const local_shared_ptr<Y> &ptr, T *element_type) noexcept
+    : d_ptr(element_type), d_cb(ptr.d_cb) {
+    if (d_cb) {
+        d_cb->increment_shared_count();
+    }
+}
+
+template <typename T>
+local_shared_ptr<T>::local_shared_ptr(local_shared_ptr<T> &&rhs) noexcept
+    : d_ptr(nullptr), d_cb(nullptr) {
+    std::swap(this->d_cb, rhs.d_cb);
+    std::swap(this->d_ptr, rhs.d_ptr);
+}
+
+/// Alias constructor
+template <typename T>
+template <typename Y>
+local_shared_ptr<T>::local_shared_ptr(local_shared_ptr<Y> &&ptr, T *element_type) noexcept
+    : d_ptr(element_type), d_cb(nullptr) {
+    std::swap(d_cb, ptr.d_cb);
+    ptr.d_ptr = nullptr;
+}
+
+template <typename T>
+local_shared_ptr<T> &local_shared_ptr<T>::operator=(const local_shared_ptr<T> &rhs) {
+    if (this != &rhs) {
+        release();
+        this->d_cb = rhs.d_cb;
+        this->d_ptr = rhs.d_ptr;
+        if (this->d_cb) {
+            this->d_cb->increment_shared_count();
+        }
+    }
+    return *this;
+}
+
+template <typename T>
+local_shared_ptr<T> &local_shared_ptr<T>::operator=(local_shared_ptr<T> &&rhs) {
+    if (this != &rhs) {
+        release();
+        std::swap(this->d_cb, rhs.d_cb);
+        std::swap(this->d_ptr, rhs.d_ptr);
+    }
+    return *this;
+}
+
+template <typename T>
+local_shared_ptr<T>::local_shared_ptr(T *ptr, local_control_block_base *cb) noexcept
+    : d_ptr(ptr), d_cb(cb) {}
+
+// ============================================================================
+// LOCAL WEAK POINTERS IMPLEMENTATION
+// ============================================================================
+
+template <typename T>
+constexpr local_weak_ptr<T>::local_weak_ptr() noexcept : d_ptr(nullptr), d_cb(nullptr) {}
+
+template <typename T>
+local_weak_ptr<T>::local_weak_ptr(const local_weak_ptr<T> &ptr) noexcept
+    : d_ptr(ptr.d_ptr), d_cb(ptr.d_cb) {
+    if (d_cb) {
+        d_cb->increment_weak_count();
+    }
+}
+
+template <typename T>
+local_weak_ptr<T>::local_weak_ptr(const local_shared_ptr<T> &ptr) noexcept
+    : d_ptr(ptr.d_ptr), d_cb(ptr.d_cb) {
+    if (d_cb) {
+        d_cb->increment_weak_count();
+    }
+}
+
+template <typename T>
+local_weak_ptr<T>::local_weak_ptr(local_weak_ptr<T> &&ptr) noexcept
+    : d_ptr(nullptr), d_cb(nullptr) {
+    std::swap(d_ptr, ptr.d_ptr);
+    std::swap(d_cb, ptr.d_cb);
+}
+
+template <typename T> local_weak_ptr<T>::~local_weak_ptr() noexcept { release(); }
+
+template <typename T>
+local_weak_ptr<T> &local_weak_ptr<T>::operator=(const local_weak_ptr<T> &rhs) noexcept {
+    if (this != &rhs) {
+        release();
+        this->d_ptr = rhs.d_ptr;
+        this->d_cb = rhs.d_cb;
+        if (this->d_cb) {
+            d_cb->increment_weak_count();
+        }
+    }
+    return *this;
+}
+
+template <typename T>
+local_weak_ptr<T> &local_weak_ptr<T>::operator=(const local_shared_ptr<T> &rhs) noexcept {
+    release();
+    this->d_ptr = rhs.d_ptr;
+    this->d_cb = rhs.d_cb;
+    if (this->d_cb) {
+        d_cb->increment_weak_count();
+    }
+    return *this;
+}
+
+template <typename T>
+local_weak_ptr<T> &local_weak_ptr<T>::operator=(local_weak_ptr<T> &&rhs) noexcept {
+    release();
+    std::swap(this->d_ptr, rhs.d_ptr);
+    std::swap(this->d_cb, rhs.d_cb);
+    return *this;
+}
+
+template <typename T> void local_weak_ptr<T>::swap(local_weak_ptr<T> &ptr) noexcept {
+    std::swap(this->d_ptr, ptr.d_ptr);
+    std::swap(this->d_cb, ptr.d_cb);
+}
+
+// ============================================================================
+// MAKE_LOCAL_SHARED IMPLEMENTATION
+// ============================================================================
+
+template <typename Y, typename... Args> local_shared_ptr<Y> make_local_shared(Args &&...args) {
+    auto cb = new local_control_block_make_shared_impl<Y>{std::forward<Args>(args)...};
+    Y *ptr = reinterpret_cast<Y *>(cb->d_storage);
+    return local_shared_ptr<Y>(ptr, cb);
+}
+
+template <typename T> struct is_trivially_relocatable<local_shared_ptr<T>> : std::true_type {};
+template <typename T> struct is_trivially_relocatable<local_weak_ptr<T>> : std::true_type {};
+
+} // namespace ksl
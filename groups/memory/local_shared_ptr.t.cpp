@@ -0,0 +1,254 @@
+// Component being tested
+#include <local_shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+namespace ksl {
+
+class LocalSharedPtrTest : public ::testing::Test {
+  protected:
+    struct Derived {
+        int value;
+        static int destructor_count;
+
+        explicit Derived(int v = 42) : value(v) {}
+        ~Derived() { destructor_count++; }
+    };
+};
+
+int LocalSharedPtrTest::Derived::destructor_count = 0;
+
+// ============================================================================
+// CONSTRUCTORS
+// ============================================================================
+
+TEST_F(LocalSharedPtrTest, DefaultAndNullptrConstructor) {
+    local_shared_ptr<int> ptr1;
+    local_shared_ptr<int> ptr2(nullptr);
+    EXPECT_EQ(ptr1.get(), nullptr);
+    EXPECT_EQ(ptr1.use_count(), 0);
+    EXPECT_FALSE(ptr1);
+    EXPECT_EQ(ptr2.get(), nullptr);
+    EXPECT_EQ(ptr2.use_count(), 0);
+    EXPECT_FALSE(ptr2);
+}
+
+TEST_F(LocalSharedPtrTest, RawPointerConstructor) {
+    Derived::destructor_count = 0;
+    {
+        Derived *raw = new Derived(42);
+        local_shared_ptr<Derived> ptr(raw);
+        EXPECT_EQ(ptr.get(), raw);
+        EXPECT_EQ(ptr->value, 42);
+        EXPECT_EQ(ptr.use_count(), 1);
+        EXPECT_TRUE(ptr);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(LocalSharedPtrTest, RawPointerConstructorWithDeleter) {
+    Derived::destructor_count = 0;
+    int deleter_count = 0;
+    {
+        auto deleter = [&deleter_count](Derived *p) {
+            deleter_count++;
+            delete p;
+        };
+        local_shared_ptr<Derived> ptr(new Derived(100), deleter);
+        EXPECT_EQ(ptr->value, 100);
+        EXPECT_EQ(ptr.use_count(), 1);
+    }
+    EXPECT_EQ(deleter_count, 1);
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(LocalSharedPtrTest, CopyAndMoveConstructor) {
+    Derived::destructor_count = 0;
+    {
+        local_shared_ptr<Derived> ptr1(new Derived(42));
+        local_shared_ptr<Derived> ptr2(ptr1);
+        EXPECT_EQ(ptr1.get(), ptr2.get());
+        EXPECT_EQ(ptr1.use_count(), 2);
+
+        local_shared_ptr<Derived> ptr3(std::move(ptr1));
+        EXPECT_FALSE(ptr1);
+        EXPECT_EQ(ptr1.use_count(), 0);
+        EXPECT_EQ(ptr3.use_count(), 2);
+        EXPECT_EQ(ptr3->value, 42);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(LocalSharedPtrTest, AliasConstructors) {
+    struct Pair {
+        int first;
+        int second;
+    };
+
+    local_shared_ptr<Pair> owner(new Pair{1, 2});
+    int *first = &owner->first;
+    local_shared_ptr<int> alias(owner, &owner->second);
+    EXPECT_EQ(*alias, 2);
+    EXPECT_EQ(owner.use_count(), 2);
+
+    local_shared_ptr<int> moved(std::move(owner), first);
+    EXPECT_EQ(*moved, 1);
+    EXPECT_FALSE(owner);
+    EXPECT_EQ(moved.use_count(), 2);
+}
+
+// ============================================================================
+// ASSIGNMENT OPERATORS
+// ============================================================================
+
+TEST_F(LocalSharedPtrTest, CopyAssignment) {
+    Derived::destructor_count = 0;
+    {
+        local_shared_ptr<Derived> ptr1(new Derived(10));
+        local_shared_ptr<Derived> ptr2(new Derived(20));
+
+        ptr1 = ptr2;
+        EXPECT_EQ(ptr1->value, 20);
+        EXPECT_EQ(ptr1.use_count(), 2);
+        EXPECT_EQ(Derived::destructor_count, 1);
+
+        ptr1 = ptr1;
+        EXPECT_EQ(ptr1.use_count(), 2);
+    }
+    EXPECT_EQ(Derived::destructor_count, 2);
+}
+
+TEST_F(LocalSharedPtrTest, MoveAssignment) {
+    Derived::destructor_count = 0;
+    {
+        local_shared_ptr<Derived> ptr1(new Derived(11));
+        local_shared_ptr<Derived> ptr2(new Derived(22));
+
+        ptr2 = std::move(ptr1);
+        EXPECT_EQ(ptr2->value, 11);
+        EXPECT_EQ(ptr2.use_count(), 1);
+        EXPECT_FALSE(ptr1);
+        EXPECT_EQ(Derived::destructor_count, 1);
+    }
+    EXPECT_EQ(Derived::destructor_count, 2);
+}
+
+// ============================================================================
+// RESET AND SWAP
+// ============================================================================
+
+TEST_F(LocalSharedPtrTest, ResetBehaviors) {
+    Derived::destructor_count = 0;
+    int deleter_count = 0;
+    {
+        auto deleter = [&deleter_count](Derived *p) {
+            deleter_count++;
+            delete p;
+        };
+        local_shared_ptr<Derived> ptr(new Derived(5));
+        local_shared_ptr<Derived> other(ptr);
+
+        ptr.reset(new Derived(15));
+        EXPECT_EQ(ptr->value, 15);
+        EXPECT_EQ(other->value, 5);
+        EXPECT_EQ(other.use_count(), 1);
+
+        ptr.reset(new Derived(25), deleter);
+        EXPECT_EQ(ptr->value, 25);
+        EXPECT_EQ(Derived::destructor_count, 1);
+
+        ptr.reset();
+        EXPECT_FALSE(ptr);
+        EXPECT_EQ(deleter_count, 1);
+    }
+    EXPECT_EQ(Derived::destructor_count, 3);
+}
+
+TEST_F(LocalSharedPtrTest, Swap) {
+    local_shared_ptr<Derived> ptr1(new Derived(10));
+    local_shared_ptr<Derived> ptr2(new Derived(20));
+
+    ptr1.swap(ptr2);
+
+    EXPECT_EQ(ptr1->value, 20);
+    EXPECT_EQ(ptr2->value, 10);
+}
+
+// ============================================================================
+// MAKE_LOCAL_SHARED FUNCTION
+// ============================================================================
+
+TEST_F(LocalSharedPtrTest, MakeLocalShared) {
+    Derived::destructor_count = 0;
+    {
+        local_shared_ptr<Derived> ptr1 = make_local_shared<Derived>(55);
+        local_shared_ptr<Derived> ptr2(ptr1);
+        EXPECT_EQ(ptr1->value, 55);
+        EXPECT_EQ(ptr1.use_count(), 2);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+// ============================================================================
+// LOCAL_WEAK_PTR TESTS
+// ============================================================================
+
+TEST_F(LocalSharedPtrTest, WeakPtrFromSharedPtrAndLock) {
+    Derived::destructor_count = 0;
+    {
+        local_shared_ptr<Derived> sptr = make_local_shared<Derived>(42);
+        local_weak_ptr<Derived> wptr(sptr);
+
+        EXPECT_EQ(wptr.use_count(), 1);
+        EXPECT_FALSE(wptr.expired());
+
+        local_shared_ptr<Derived> sptr2 = wptr.lock();
+        EXPECT_EQ(sptr2->value, 42);
+        EXPECT_EQ(sptr.use_count(), 2);
+
+        local_shared_ptr<Derived> sptr3(wptr);
+        EXPECT_EQ(sptr.use_count(), 3);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(LocalSharedPtrTest, WeakPtrExpiration) {
+    Derived::destructor_count = 0;
+    local_weak_ptr<Derived> wptr;
+    {
+        local_shared_ptr<Derived> sptr(new Derived(50));
+        wptr = sptr;
+        local_weak_ptr<Derived> copy(wptr);
+        EXPECT_FALSE(copy.expired());
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+    EXPECT_TRUE(wptr.expired());
+    EXPECT_FALSE(wptr.lock());
+    EXPECT_FALSE(local_shared_ptr<Derived>(wptr));
+}
+
+TEST_F(LocalSharedPtrTest, WeakPtrAssignmentResetAndSwap) {
+    local_shared_ptr<Derived> sptr1(new Derived(60));
+    local_shared_ptr<Derived> sptr2(new Derived(70));
+    local_weak_ptr<Derived> wptr1(sptr1);
+    local_weak_ptr<Derived> wptr2;
+
+    wptr2 = wptr1;
+    EXPECT_EQ(wptr2.lock()->value, 60);
+
+    wptr2 = sptr2;
+    wptr1.swap(wptr2);
+    EXPECT_EQ(wptr1.lock()->value, 70);
+    EXPECT_EQ(wptr2.lock()->value, 60);
+
+    local_weak_ptr<Derived> wptr3(std::move(wptr1));
+    EXPECT_TRUE(wptr1.expired());
+    EXPECT_EQ(wptr3.lock()->value, 70);
+
+    wptr3.reset();
+    EXPECT_TRUE(wptr3.expired());
+    EXPECT_EQ(wptr3.use_count(), 0);
+}
+
+} // namespace ksl
@@ -0,0 +1,269 @@
+#include <memory_resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <memory>
+
+namespace ksl::pmr {
+namespace {
+class new_delete_resource_impl : public memory_resource {
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            return ::operator new(bytes, std::align_val_t(alignment));
+        }
+        return ::operator new(bytes);
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ::operator delete(ptr, bytes, std::align_val_t(alignment));
+            return;
+        }
+        ::operator delete(ptr, bytes);
+    }
+
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+class null_memory_resource_impl : public memory_resource {
+    void *do_allocate(std::size_t, std::size_t) override { throw std::bad_alloc(); }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+std::atomic<memory_resource *> &default_resource() noexcept {
+    static std::atomic<memory_resource *> instance{new_delete_resource()};
+    return instance;
+}
+
+inline std::size_t round_up(std::size_t value, std::size_t alignment) noexcept {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/// Most blocks per pool chunk that pool_options may ask for.
+constexpr std::size_t k_blocks_per_chunk_limit = std::size_t{1} << 16;
+} // namespace
+
+memory_resource *new_delete_resource() noexcept {
+    // Leaked on purpose: containers may free through the resource during
+    // static destruction, after a function-local static would be gone.
+    static memory_resource *instance = new new_delete_resource_impl;
+    return instance;
+}
+
+memory_resource *null_memory_resource() noexcept {
+    // Leaked on purpose, as for new_delete_resource
+    static memory_resource *instance = new null_memory_resource_impl;
+    return instance;
+}
+
+memory_resource *get_default_resource() noexcept {
+    return default_resource().load(std::memory_order_acquire);
+}
+
+memory_resource *set_default_resource(memory_resource *resource) noexcept {
+    if (!resource) {
+        resource = new_delete_resource();
+    }
+    return default_resource().exchange(resource, std::memory_order_acq_rel);
+}
+
+// ============================================================================
+// MONOTONIC BUFFER RESOURCE IMPLEMENTATION
+// ============================================================================
+
+monotonic_buffer_resource::monotonic_buffer_resource(std::size_t initial_size,
+                                                     memory_resource *upstream) noexcept
+    : d_upstream(upstream), d_initial_buffer(nullptr), d_initial_size(0),
+      d_first_chunk_size(std::max<std::size_t>(initial_size, 1) + sizeof(chunk)),
+      d_next_chunk_size(d_first_chunk_size), d_chunks(nullptr), d_current(nullptr), d_space(0) {
+    assert(upstream != nullptr && "monotonic_buffer_resource needs an upstream resource");
+}
+
+monotonic_buffer_resource::monotonic_buffer_resource(void *buffer, std::size_t size,
+                                                     memory_resource *upstream) noexcept
+    : d_upstream(upstream), d_initial_buffer(buffer), d_initial_size(size),
+      d_first_chunk_size(std::max(size, k_initial_chunk_size) * k_growth_factor + sizeof(chunk)),
+      d_next_chunk_size(d_first_chunk_size), d_chunks(nullptr),
+      d_current(static_cast<char *>(buffer)), d_space(size) {
+    assert(upstream != nullptr && "monotonic_buffer_resource needs an upstream resource");
+}
+
+void monotonic_buffer_resource::release() noexcept {
+    while (chunk *current = d_chunks) {
+        d_chunks = current->d_next;
+        d_upstream->deallocate(current, current->d_bytes, alignof(std::max_align_t));
+    }
+    d_current = static_cast<char *>(d_initial_buffer);
+    d_space = d_initial_size;
+    d_next_chunk_size = d_first_chunk_size;
+}
+
+void *monotonic_buffer_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    // Every allocation gets its own address, even an empty one
+    bytes = std::max<std::size_t>(bytes, 1);
+    void *ptr = d_current;
+    if (std::align(alignment, bytes, ptr, d_space)) {
+        d_current = static_cast<char *>(ptr) + bytes;
+        d_space -= bytes;
+        return ptr;
+    }
+
+    // The current chunk is full: the next one fits this request whatever
+    // its alignment, and the one after is larger again
+    const std::size_t needed = sizeof(chunk) + bytes + alignment;
+    const std::size_t chunk_bytes = std::max(d_next_chunk_size, needed);
+    void *memory = d_upstream->allocate(chunk_bytes, alignof(std::max_align_t));
+    d_chunks = ::new (memory) chunk{d_chunks, chunk_bytes};
+    if (chunk_bytes <= std::numeric_limits<std::size_t>::max() / k_growth_factor) {
+        d_next_chunk_size = chunk_bytes * k_growth_factor;
+    }
+
+    ptr = static_cast<char *>(memory) + sizeof(chunk);
+    d_space = chunk_bytes - sizeof(chunk);
+    std::align(alignment, bytes, ptr, d_space);
+    d_current = static_cast<char *>(ptr) + bytes;
+    d_space -= bytes;
+    return ptr;
+}
+
+// ============================================================================
+// POOL RESOURCES IMPLEMENTATION
+// ============================================================================
+
+unsynchronized_pool_resource::unsynchronized_pool_resource(const pool_options &options,
+                                                           memory_resource *upstream) noexcept
+    : d_upstream(upstream), d_options(options), d_pool_count(0), d_oversized(nullptr) {
+    assert(upstream != nullptr && "unsynchronized_pool_resource needs an upstream resource");
+    if (d_options.max_blocks_per_chunk == 0) {
+        d_options.max_blocks_per_chunk = k_default_max_blocks_per_chunk;
+    }
+    d_options.max_blocks_per_chunk =
+        std::min(d_options.max_blocks_per_chunk, k_blocks_per_chunk_limit);
+
+    if (d_options.largest_required_pool_block == 0) {
+        d_options.largest_required_pool_block = k_default_largest_block;
+    }
+    d_options.largest_required_pool_block = std::bit_ceil(std::clamp(
+        d_options.largest_required_pool_block, k_min_block_size, k_max_pool_block));
+
+    d_pool_count = pool_index(d_options.largest_required_pool_block, 1) + 1;
+    for (std::size_t index = 0; index < d_pool_count; ++index) {
+        d_pools[index].d_next_blocks =
+            std::min(k_initial_blocks_per_chunk, d_options.max_blocks_per_chunk);
+    }
+}
+
+void unsynchronized_pool_resource::release() noexcept {
+    for (std::size_t index = 0; index < d_pool_count; ++index) {
+        pool &current = d_pools[index];
+        const std::size_t block_size = k_min_block_size << index;
+        while (chunk *trailer = current.d_chunks) {
+            current.d_chunks = trailer->d_next;
+            char *base = reinterpret_cast<char *>(trailer) - (trailer->d_bytes - sizeof(chunk));
+            d_upstream->deallocate(base, trailer->d_bytes, std::max(block_size, alignof(chunk)));
+        }
+        current = pool{};
+        current.d_next_blocks =
+            std::min(k_initial_blocks_per_chunk, d_options.max_blocks_per_chunk);
+    }
+    while (oversized *header = d_oversized) {
+        d_oversized = header->d_next;
+        const std::size_t offset = round_up(sizeof(oversized), header->d_alignment);
+        d_upstream->deallocate(reinterpret_cast<char *>(header + 1) - offset,
+                               offset + header->d_bytes,
+                               std::max(header->d_alignment, alignof(oversized)));
+    }
+}
+
+std::size_t unsynchronized_pool_resource::pool_index(std::size_t bytes,
+                                                     std::size_t alignment) const noexcept {
+    const std::size_t size = std::max({bytes, alignment, k_min_block_size});
+    if (size > d_options.largest_required_pool_block) {
+        return d_pool_count;
+    }
+    return static_cast<std::size_t>(std::bit_width(size - 1)) -
+           static_cast<std::size_t>(std::countr_zero(k_min_block_size));
+}
+
+void unsynchronized_pool_resource::refill(pool &target, std::size_t block_size) {
+    const std::size_t blocks = target.d_next_blocks;
+    const std::size_t chunk_bytes = blocks * block_size + sizeof(chunk);
+    char *base = static_cast<char *>(
+        d_upstream->allocate(chunk_bytes, std::max(block_size, alignof(chunk))));
+    target.d_chunks = ::new (base + blocks * block_size) chunk{target.d_chunks, chunk_bytes};
+    target.d_bump = base;
+    target.d_bump_end = base + blocks * block_size;
+    target.d_next_blocks = std::min(blocks * 2, d_options.max_blocks_per_chunk);
+}
+
+void *unsynchronized_pool_resource::allocate_oversized(std::size_t bytes, std::size_t alignment) {
+    const std::size_t offset = round_up(sizeof(oversized), alignment);
+    char *base = static_cast<char *>(
+        d_upstream->allocate(offset + bytes, std::max(alignment, alignof(oversized))));
+    auto *header = ::new (base + offset - sizeof(oversized))
+        oversized{nullptr, d_oversized, bytes, alignment};
+    if (d_oversized) {
+        d_oversized->d_prev = header;
+    }
+    d_oversized = header;
+    return base + offset;
+}
+
+void unsynchronized_pool_resource::deallocate_oversized(void *ptr, std::size_t bytes,
+                                                        std::size_t alignment) noexcept {
+    auto *header = static_cast<oversized *>(ptr) - 1;
+    assert(header->d_bytes == bytes && header->d_alignment == alignment &&
+           "deallocate must be given the size and alignment of the allocation");
+    if (header->d_prev) {
+        header->d_prev->d_next = header->d_next;
+    } else {
+        d_oversized = header->d_next;
+    }
+    if (header->d_next) {
+        header->d_next->d_prev = header->d_prev;
+    }
+    const std::size_t offset = round_up(sizeof(oversized), alignment);
+    d_upstream->deallocate(static_cast<char *>(ptr) - offset, offset + bytes,
+                           std::max(alignment, alignof(oversized)));
+}
+
+void *unsynchronized_pool_resource::do_allocate(std::size_t bytes, std::size_t alignment) {
+    const std::size_t index = pool_index(bytes, alignment);
+    if (index == d_pool_count) {
+        return allocate_oversized(bytes, alignment);
+    }
+
+    pool &target = d_pools[index];
+    if (free_block *block = target.d_free) {
+        target.d_free = block->d_next;
+        return block;
+    }
+    const std::size_t block_size = k_min_block_size << index;
+    if (target.d_bump == target.d_bump_end) {
+        refill(target, block_size);
+    }
+    void *block = target.d_bump;
+    target.d_bump += block_size;
+    return block;
+}
+
+void unsynchronized_pool_resource::do_deallocate(void *ptr, std::size_t bytes,
+                                                 std::size_t alignment) {
+    const std::size_t index = pool_index(bytes, alignment);
+    if (index == d_pool_count) {
+        deallocate_oversized(ptr, bytes, alignment);
+        return;
+    }
+    pool &target = d_pools[index];
+    target.d_free = ::new (ptr) free_block{target.d_free};
+}
+
+} // namespace ksl::pmr
@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <new>
+
+namespace ksl::pmr {
+
+// ============================================================================
+// MEMORY RESOURCE DEFINITION
+// ============================================================================
+
+/// Source of raw memory behind polymorphic_allocator. Derived resources
+/// implement the three do_ hooks; callers use allocate, deallocate and
+/// is_equal. Memory must be returned to the resource it came from, with the
+/// same size and alignment.
+class memory_resource {
+    static constexpr std::size_t k_max_align = alignof(std::max_align_t);
+
+  public:
+    virtual ~memory_resource() = default;
+
+    [[nodiscard]] void *allocate(std::size_t bytes, std::size_t alignment = k_max_align) {
+        return do_allocate(bytes, alignment);
+    }
+
+    void deallocate(void *ptr, std::size_t bytes, std::size_t alignment = k_max_align) {
+        do_deallocate(ptr, bytes, alignment);
+    }
+
+    /// Whether memory from one resource can be returned to the other.
+    [[nodiscard]] bool is_equal(const memory_resource &other) const noexcept {
+        return this == &other || do_is_equal(other);
+    }
+
+  private:
+    virtual void *do_allocate(std::size_t bytes, std::size_t alignment) = 0;
+    virtual void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) = 0;
+    [[nodiscard]] virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+};
+
+[[nodiscard]] inline bool operator==(const memory_resource &lhs,
+                                     const memory_resource &rhs) noexcept {
+    return lhs.is_equal(rhs);
+}
+
+/// The global operator new and delete.
+[[nodiscard]] memory_resource *new_delete_resource() noexcept;
+
+/// Throws std::bad_alloc from every allocation, e.g. as the upstream of a
+/// monotonic_buffer_resource that must never leave its initial buffer.
+[[nodiscard]] memory_resource *null_memory_resource() noexcept;
+
+/// The resource used by default-constructed allocators and resources,
+/// new_delete_resource() unless set_default_resource says otherwise.
+[[nodiscard]] memory_resource *get_default_resource() noexcept;
+
+/// Replaces the default resource, or restores new_delete_resource() for
+/// nullptr, and returns the previous one.
+memory_resource *set_default_resource(memory_resource *resource) noexcept;
+
+// ============================================================================
+// MONOTONIC BUFFER RESOURCE DEFINITION
+// ============================================================================
+
+/// Bump allocator over a chain of chunks taken from upstream, each twice as
+/// large as the previous one. Deallocation does nothing; release(), or the
+/// destructor, hands every chunk back at once, whatever was allocated from
+/// them.
+///
+/// Meant for request-scoped object graphs: allocate_shared everything with
+/// a polymorphic_allocator over one resource, drop the handles at the end
+/// of the request, and release the resource. Objects are still destroyed
+/// by their owners; the resource must outlive every handle allocated from
+/// it, including weak_ptrs.
+class monotonic_buffer_resource : public memory_resource {
+    struct chunk {
+        chunk *d_next;
+        std::size_t d_bytes;
+    };
+
+    memory_resource *d_upstream;
+    void *d_initial_buffer;
+    std::size_t d_initial_size;
+    std::size_t d_first_chunk_size;
+    std::size_t d_next_chunk_size;
+    chunk *d_chunks;
+    char *d_current;
+    std::size_t d_space;
+
+  public:
+    static constexpr std::size_t k_initial_chunk_size = 1024;
+    static constexpr std::size_t k_growth_factor = 2;
+
+    explicit monotonic_buffer_resource(memory_resource *upstream = get_default_resource()) noexcept
+        : monotonic_buffer_resource(k_initial_chunk_size, upstream) {}
+
+    /// The first chunk taken from upstream holds at least initial_size bytes.
+    explicit monotonic_buffer_resource(std::size_t initial_size,
+                                       memory_resource *upstream = get_default_resource()) noexcept;
+
+    /// Serves allocations from buffer first, and goes to upstream once it is
+    /// full. The buffer is not owned.
+    monotonic_buffer_resource(void *buffer, std::size_t size,
+                              memory_resource *upstream = get_default_resource()) noexcept;
+
+    monotonic_buffer_resource(const monotonic_buffer_resource &) = delete;
+    monotonic_buffer_resource &operator=(const monotonic_buffer_resource &) = delete;
+
+    ~monotonic_buffer_resource() override { release(); }
+
+    /// Returns every chunk to upstream and starts over from the initial
+    /// buffer, if any. Costs one upstream deallocation per chunk, not per
+    /// allocation.
+    void release() noexcept;
+
+    [[nodiscard]] memory_resource *upstream_resource() const noexcept { return d_upstream; }
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *, std::size_t, std::size_t) override {}
+    [[nodiscard]] bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// ============================================================================
+// POOL RESOURCES DEFINITION
+// ============================================================================
+
+/// Tuning for the pool resources. Zero picks the default; other values are
+/// rounded to the nearest supported one.
+struct pool_options {
+    /// Most blocks carved from one upstream chunk. Chunks start small and
+    /// double up to this.
+    std::size_t max_blocks_per_chunk = 0;
+    /// Largest allocation served from a pool; anything bigger goes straight
+    /// to upstream.
+    std::size_t largest_required_pool_block = 0;
+};
+
+/// Size-classed pools, one per power of two from k_min_block_size up to
+/// the largest pool block. Every class has its own free list, so a freed
+/// block is reused by the next allocation of the same class without going
+/// upstream. Blocks are naturally aligned to their class size. Not
+/// thread-safe; see synchronized_pool_resource.
+class unsynchronized_pool_resource : public memory_resource {
+  public:
+    static constexpr std::size_t k_min_block_size = 8;
+    static constexpr std::size_t k_max_pool_block = std::size_t{1} << 20;
+    static constexpr std::size_t k_default_largest_block = 4096;
+    static constexpr std::size_t k_default_max_blocks_per_chunk = 1024;
+    static constexpr std::size_t k_initial_blocks_per_chunk = 16;
+
+  private:
+    static constexpr std::size_t k_max_pools = 18; // 8 bytes to k_max_pool_block
+
+    struct free_block {
+        free_block *d_next;
+    };
+
+    /// Trailer at the end of every chunk, after its blocks, so the blocks
+    /// keep the chunk's alignment.
+    struct chunk {
+        chunk *d_next;
+        std::size_t d_bytes;
+    };
+
+    /// Header in front of an allocation too large for the pools, linking
+    /// it so release() can free it.
+    struct oversized {
+        oversized *d_prev;
+        oversized *d_next;
+        std::size_t d_bytes;
+        std::size_t d_alignment;
+    };
+
+    struct pool {
+        free_block *d_free = nullptr;
+        chunk *d_chunks = nullptr;
+        char *d_bump = nullptr;
+        char *d_bump_end = nullptr;
+        std::size_t d_next_blocks = k_initial_blocks_per_chunk;
+    };
+
+    memory_resource *d_upstream;
+    pool_options d_options;
+    pool d_pools[k_max_pools];
+    std::size_t d_pool_count;
+    oversized *d_oversized;
+
+  public:
+    explicit unsynchronized_pool_resource(
+        memory_resource *upstream = get_default_resource()) noexcept
+        : unsynchronized_pool_resource(pool_options(), upstream) {}
+
+    explicit unsynchronized_pool_resource(
+        const pool_options &options, memory_resource *upstream = get_default_resource()) noexcept;
+
+    unsynchronized_pool_resource(const unsynchronized_pool_resource &) = delete;
+    unsynchronized_pool_resource &operator=(const unsynchronized_pool_resource &) = delete;
+
+    ~unsynchronized_pool_resource() override { release(); }
+
+    /// Returns every chunk and oversized allocation to upstream, including
+    /// blocks still in use.
+    void release() noexcept;
+
+    [[nodiscard]] memory_resource *upstream_resource() const noexcept { return d_upstream; }
+
+    /// The options in effect, with defaults and rounding applied.
+    [[nodiscard]] pool_options options() const noexcept { return d_options; }
+
+  private:
+    [[nodiscard]] std::size_t pool_index(std::size_t bytes, std::size_t alignment) const noexcept;
+    void *allocate_oversized(std::size_t bytes, std::size_t alignment);
+    void deallocate_oversized(void *ptr, std::size_t bytes, std::size_t alignment) noexcept;
+    void refill(pool &target, std::size_t block_size);
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override;
+    [[nodiscard]] bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/// unsynchronized_pool_resource behind a mutex, for a resource shared by
+/// several threads.
+class synchronized_pool_resource : public memory_resource {
+    std::mutex d_mutex;
+    unsynchronized_pool_resource d_pools;
+
+  public:
+    explicit synchronized_pool_resource(memory_resource *upstream = get_default_resource()) noexcept
+        : d_pools(upstream) {}
+
+    explicit synchronized_pool_resource(const pool_options &options,
+                                        memory_resource *upstream = get_default_resource()) noexcept
+        : d_pools(options, upstream) {}
+
+    void release() noexcept {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_pools.release();
+    }
+
+    [[nodiscard]] memory_resource *upstream_resource() const noexcept {
+        return d_pools.upstream_resource();
+    }
+
+    [[nodiscard]] pool_options options() const noexcept { return d_pools.options(); }
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        return d_pools.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_pools.deallocate(ptr, bytes, alignment);
+    }
+
+    [[nodiscard]] bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// ============================================================================
+// POLYMORPHIC ALLOCATOR DEFINITION
+// ============================================================================
+
+/// Allocator forwarding to a memory_resource, so one allocator type can be
+/// backed by any resource at run time. Pass it to allocate_shared or
+/// shared_ptr(T*, Deleter, Alloc); the control block keeps a copy, which is
+/// one pointer.
+///
+/// Like std::pmr's, it is not assignable and is not propagated by
+/// containers: a copy-constructed container gets the default resource.
+template <typename T = std::byte> class polymorphic_allocator {
+    memory_resource *d_resource;
+
+  public:
+    using value_type = T;
+
+    polymorphic_allocator() noexcept : d_resource(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource *resource) noexcept : d_resource(resource) {
+        assert(resource != nullptr && "polymorphic_allocator needs a resource");
+    }
+
+    polymorphic_allocator(const polymorphic_allocator &) = default;
+
+    template <typename U>
+    polymorphic_allocator(const polymorphic_allocator<U> &rhs) noexcept
+        : d_resource(rhs.resource()) {}
+
+    polymorphic_allocator &operator=(const polymorphic_allocator &) = delete;
+
+    [[nodiscard]] T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(d_resource->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        d_resource->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    [[nodiscard]] memory_resource *resource() const noexcept { return d_resource; }
+
+    [[nodiscard]] polymorphic_allocator select_on_container_copy_construction() const noexcept {
+        return polymorphic_allocator();
+    }
+
+    template <typename U>
+    [[nodiscard]] bool operator==(const polymorphic_allocator<U> &rhs) const noexcept {
+        return *d_resource == *rhs.resource();
+    }
+};
+
+} // namespace ksl::pmr
@@ -0,0 +1,337 @@
+// Component being tested
+#include <memory_resource.h>
+
+#include <shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace ksl::pmr {
+
+class MemoryResourceTest : public ::testing::Test {
+  protected:
+    struct Node {
+        int value;
+        shared_ptr<Node> next;
+        static int destructor_count;
+
+        explicit Node(int v = 42) : value(v) {}
+        ~Node() { destructor_count++; }
+    };
+
+    /// Upstream resource counting what goes through it and checking every
+    /// deallocation against its allocation.
+    class counting_resource : public memory_resource {
+        std::map<void *, std::pair<std::size_t, std::size_t>> d_live;
+
+      public:
+        std::size_t d_allocations = 0;
+        std::size_t d_deallocations = 0;
+
+        [[nodiscard]] std::size_t live() const noexcept { return d_live.size(); }
+
+      private:
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+            void *ptr = new_delete_resource()->allocate(bytes, alignment);
+            d_live.emplace(ptr, std::make_pair(bytes, alignment));
+            d_allocations++;
+            return ptr;
+        }
+
+        void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+            auto it = d_live.find(ptr);
+            ASSERT_NE(it, d_live.end());
+            EXPECT_EQ(it->second.first, bytes);
+            EXPECT_EQ(it->second.second, alignment);
+            d_live.erase(it);
+            d_deallocations++;
+            new_delete_resource()->deallocate(ptr, bytes, alignment);
+        }
+
+        bool do_is_equal(const memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    void SetUp() override { Node::destructor_count = 0; }
+
+    static bool is_aligned(const void *ptr, std::size_t alignment) {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+};
+
+int MemoryResourceTest::Node::destructor_count = 0;
+
+// ============================================================================
+// GLOBAL RESOURCES
+// ============================================================================
+
+TEST_F(MemoryResourceTest, NewDeleteResource) {
+    memory_resource *resource = new_delete_resource();
+    EXPECT_EQ(resource, new_delete_resource());
+
+    void *ptr = resource->allocate(24);
+    EXPECT_TRUE(is_aligned(ptr, alignof(std::max_align_t)));
+    resource->deallocate(ptr, 24);
+
+    void *aligned = resource->allocate(64, 256);
+    EXPECT_TRUE(is_aligned(aligned, 256));
+    resource->deallocate(aligned, 64, 256);
+}
+
+TEST_F(MemoryResourceTest, NullResourceThrows) {
+    EXPECT_THROW((void)null_memory_resource()->allocate(8), std::bad_alloc);
+    EXPECT_FALSE(*null_memory_resource() == *new_delete_resource());
+}
+
+TEST_F(MemoryResourceTest, DefaultResource) {
+    EXPECT_EQ(get_default_resource(), new_delete_resource());
+    counting_resource counting;
+    EXPECT_EQ(set_default_resource(&counting), new_delete_resource());
+    EXPECT_EQ(polymorphic_allocator<int>().resource(), &counting);
+    EXPECT_EQ(set_default_resource(nullptr), &counting);
+    EXPECT_EQ(get_default_resource(), new_delete_resource());
+}
+
+// ============================================================================
+// MONOTONIC BUFFER RESOURCE
+// ============================================================================
+
+TEST_F(MemoryResourceTest, MonotonicUsesInitialBufferFirst) {
+    alignas(std::max_align_t) char buffer[256];
+    counting_resource upstream;
+    monotonic_buffer_resource resource(buffer, sizeof(buffer), &upstream);
+
+    void *first = resource.allocate(16, 8);
+    void *second = resource.allocate(8, 8);
+    EXPECT_GE(static_cast<char *>(first), buffer);
+    EXPECT_LT(static_cast<char *>(second), buffer + sizeof(buffer));
+    EXPECT_EQ(static_cast<char *>(second), static_cast<char *>(first) + 16);
+    EXPECT_EQ(upstream.d_allocations, 0u);
+
+    // Past the buffer, chunks come from upstream
+    (void)resource.allocate(512, 8);
+    EXPECT_EQ(upstream.d_allocations, 1u);
+}
+
+TEST_F(MemoryResourceTest, MonotonicRespectsAlignment) {
+    monotonic_buffer_resource resource;
+    for (std::size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        (void)resource.allocate(1, 1);
+        void *ptr = resource.allocate(3, alignment);
+        EXPECT_TRUE(is_aligned(ptr, alignment)) << alignment;
+    }
+    void *a = resource.allocate(0, 1);
+    void *b = resource.allocate(0, 1);
+    EXPECT_NE(a, b);
+}
+
+TEST_F(MemoryResourceTest, MonotonicChunksGrowAndReleaseAtOnce) {
+    counting_resource upstream;
+    {
+        monotonic_buffer_resource resource(&upstream);
+        for (int i = 0; i < 1000; ++i) {
+            void *ptr = resource.allocate(64, 8);
+            resource.deallocate(ptr, 64, 8);
+        }
+        // Geometric growth: 64000 bytes in a handful of chunks
+        EXPECT_LE(upstream.d_allocations, 8u);
+        EXPECT_EQ(upstream.d_deallocations, 0u);
+
+        resource.release();
+        EXPECT_EQ(upstream.live(), 0u);
+        const std::size_t before = upstream.d_allocations;
+        (void)resource.allocate(64, 8);
+        EXPECT_EQ(upstream.d_allocations, before + 1);
+    }
+    EXPECT_EQ(upstream.live(), 0u);
+}
+
+TEST_F(MemoryResourceTest, MonotonicOverNullResource) {
+    char buffer[64];
+    monotonic_buffer_resource resource(buffer, sizeof(buffer), null_memory_resource());
+    (void)resource.allocate(48, 1);
+    EXPECT_THROW((void)resource.allocate(48, 1), std::bad_alloc);
+}
+
+// ============================================================================
+// POOL RESOURCES
+// ============================================================================
+
+TEST_F(MemoryResourceTest, PoolOptionsAreNormalized) {
+    unsynchronized_pool_resource defaults;
+    EXPECT_EQ(defaults.options().largest_required_pool_block,
+              unsynchronized_pool_resource::k_default_largest_block);
+    EXPECT_EQ(defaults.options().max_blocks_per_chunk,
+              unsynchronized_pool_resource::k_default_max_blocks_per_chunk);
+
+    unsynchronized_pool_resource rounded(pool_options{10, 100});
+    EXPECT_EQ(rounded.options().largest_required_pool_block, 128u);
+    EXPECT_EQ(rounded.options().max_blocks_per_chunk, 10u);
+
+    unsynchronized_pool_resource clamped(pool_options{0, std::size_t{1} << 30});
+    EXPECT_EQ(clamped.options().largest_required_pool_block,
+              unsynchronized_pool_resource::k_max_pool_block);
+}
+
+TEST_F(MemoryResourceTest, PoolReusesFreedBlocks) {
+    counting_resource upstream;
+    unsynchronized_pool_resource resource(&upstream);
+
+    void *first = resource.allocate(40, 8);
+    resource.deallocate(first, 40, 8);
+    void *second = resource.allocate(48, 8);
+    // 40 and 48 bytes share the 64-byte class
+    EXPECT_EQ(first, second);
+    EXPECT_TRUE(is_aligned(second, 64));
+    EXPECT_EQ(upstream.d_allocations, 1u);
+    resource.deallocate(second, 48, 8);
+}
+
+TEST_F(MemoryResourceTest, PoolChunksGrowUpToTheLimit) {
+    counting_resource upstream;
+    unsynchronized_pool_resource resource(pool_options{64, 0}, &upstream);
+
+    // 16 + 32 + 64 + 64 blocks
+    std::vector<void *> blocks;
+    for (int i = 0; i < 176; ++i) {
+        blocks.push_back(resource.allocate(16, 8));
+    }
+    EXPECT_EQ(upstream.d_allocations, 4u);
+    std::set<void *> distinct(blocks.begin(), blocks.end());
+    EXPECT_EQ(distinct.size(), blocks.size());
+    for (void *block : blocks) {
+        resource.deallocate(block, 16, 8);
+    }
+    EXPECT_EQ(upstream.d_deallocations, 0u);
+}
+
+TEST_F(MemoryResourceTest, PoolSendsOversizedUpstream) {
+    counting_resource upstream;
+    unsynchronized_pool_resource resource(pool_options{0, 256}, &upstream);
+
+    void *large = resource.allocate(1000, 8);
+    void *aligned = resource.allocate(16, 512);
+    EXPECT_TRUE(is_aligned(aligned, 512));
+    EXPECT_EQ(upstream.d_allocations, 2u);
+    resource.deallocate(large, 1000, 8);
+    EXPECT_EQ(upstream.d_deallocations, 1u);
+
+    // release() frees the oversized allocation still in use too
+    resource.release();
+    EXPECT_EQ(upstream.live(), 0u);
+}
+
+TEST_F(MemoryResourceTest, PoolReleaseReturnsEverything) {
+    counting_resource upstream;
+    {
+        unsynchronized_pool_resource resource(&upstream);
+        for (std::size_t bytes = 1; bytes <= 8192; bytes *= 3) {
+            (void)resource.allocate(bytes, 8);
+        }
+        EXPECT_GT(upstream.live(), 0u);
+    }
+    EXPECT_EQ(upstream.live(), 0u);
+}
+
+TEST_F(MemoryResourceTest, SynchronizedPoolAcrossThreads) {
+    counting_resource upstream;
+    synchronized_pool_resource resource(&upstream);
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 2000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&resource, t] {
+            std::vector<void *> blocks;
+            for (int i = 0; i < k_rounds; ++i) {
+                const std::size_t bytes = 8u << ((i + t) % 6);
+                blocks.push_back(resource.allocate(bytes, 8));
+                if (i % 3 == 0) {
+                    resource.deallocate(blocks.back(), bytes, 8);
+                    blocks.pop_back();
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    resource.release();
+    EXPECT_EQ(upstream.live(), 0u);
+}
+
+// ============================================================================
+// POLYMORPHIC ALLOCATOR
+// ============================================================================
+
+TEST_F(MemoryResourceTest, PolymorphicAllocatorForwardsToResource) {
+    counting_resource upstream;
+    polymorphic_allocator<double> alloc(&upstream);
+    polymorphic_allocator<char> rebound(alloc);
+    EXPECT_EQ(rebound.resource(), &upstream);
+    EXPECT_TRUE(alloc == rebound);
+    EXPECT_FALSE(alloc == polymorphic_allocator<double>());
+
+    double *values = alloc.allocate(4);
+    EXPECT_TRUE(is_aligned(values, alignof(double)));
+    alloc.deallocate(values, 4);
+    EXPECT_EQ(upstream.d_allocations, 1u);
+    EXPECT_EQ(upstream.live(), 0u);
+
+    std::list<int, polymorphic_allocator<int>> list(&upstream);
+    list.push_back(1);
+    list.push_back(2);
+    EXPECT_EQ(upstream.live(), 2u);
+}
+
+TEST_F(MemoryResourceTest, AllocateSharedFromResource) {
+    counting_resource upstream;
+    unsynchronized_pool_resource pool(&upstream);
+    {
+        polymorphic_allocator<Node> alloc(&pool);
+        shared_ptr<Node> node = allocate_shared<Node>(alloc, 1);
+        weak_ptr<Node> observer = node;
+        shared_ptr<int[]> array = allocate_shared<int[]>(polymorphic_allocator<int>(&pool), 16);
+        shared_ptr<Node> adopted(new Node(2), std::default_delete<Node>(), alloc);
+        EXPECT_EQ(node->value, 1);
+        EXPECT_EQ(array[15], 0);
+        EXPECT_GT(upstream.live(), 0u);
+
+        node.reset();
+        EXPECT_EQ(Node::destructor_count, 1);
+        EXPECT_TRUE(observer.expired());
+    }
+    EXPECT_EQ(Node::destructor_count, 2);
+    pool.release();
+    EXPECT_EQ(upstream.live(), 0u);
+}
+
+TEST_F(MemoryResourceTest, RequestScopedGraph) {
+    counting_resource upstream;
+    monotonic_buffer_resource request(&upstream);
+    {
+        polymorphic_allocator<Node> alloc(&request);
+        shared_ptr<Node> head = allocate_shared<Node>(alloc, 0);
+        Node *tail = head.get();
+        for (int i = 1; i < 100; ++i) {
+            tail->next = allocate_shared<Node>(alloc, i);
+            tail = tail->next.get();
+        }
+    }
+    // Handles are gone and the objects destroyed; the memory goes back in
+    // a few chunk frees
+    EXPECT_EQ(Node::destructor_count, 100);
+    EXPECT_LE(upstream.live(), 8u);
+    request.release();
+    EXPECT_EQ(upstream.live(), 0u);
+}
+
+} // namespace ksl::pmr
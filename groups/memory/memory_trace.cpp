@@ -0,0 +1,133 @@
+#include <memory_trace.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define KSL_MEMORY_TRACE_BACKTRACE 1
+#endif
+
+namespace ksl {
+namespace {
+struct block_record {
+    std::size_t d_serial;
+    const std::atomic<std::size_t> *d_shared_count;
+    const std::atomic<std::size_t> *d_weak_count;
+    std::vector<void *> d_frames;
+};
+
+/// Every live block, and the totals of blocks created and destroyed.
+struct block_registry {
+    std::mutex d_mutex;
+    std::unordered_map<const void *, block_record> d_blocks;
+    std::size_t d_created = 0;
+    std::size_t d_destroyed = 0;
+};
+
+block_registry &registry() {
+    // Leaked on purpose: blocks may be destroyed during static destruction,
+    // after a function-local static would be gone.
+    static block_registry *instance = new block_registry;
+    return *instance;
+}
+
+/// Call stack of the caller's caller, without the tracing frames.
+std::vector<void *> capture_frames() {
+#ifdef KSL_MEMORY_TRACE_BACKTRACE
+    constexpr int k_skipped = 2;
+    void *frames[memory_trace::k_max_frames + k_skipped];
+    const int depth = ::backtrace(frames, static_cast<int>(std::size(frames)));
+    if (depth <= k_skipped) {
+        return {};
+    }
+    return std::vector<void *>(frames + k_skipped, frames + depth);
+#else
+    return {};
+#endif
+}
+} // namespace
+
+void memory_trace::block_created(const void *block, const std::atomic<std::size_t> *shared_count,
+                                 const std::atomic<std::size_t> *weak_count) noexcept {
+    block_registry &reg = registry();
+    try {
+        std::vector<void *> frames = capture_frames();
+        std::lock_guard<std::mutex> lock(reg.d_mutex);
+        reg.d_blocks.insert_or_assign(
+            block, block_record{reg.d_created, shared_count, weak_count, std::move(frames)});
+        reg.d_created++;
+    } catch (...) {
+        // Out of memory: the block goes untraced rather than failing the
+        // allocation it belongs to
+    }
+}
+
+void memory_trace::block_destroyed(const void *block) noexcept {
+    block_registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.d_mutex);
+    if (reg.d_blocks.erase(block) != 0) {
+        reg.d_destroyed++;
+    }
+}
+
+memory_trace_snapshot memory_trace::snapshot() {
+    memory_trace_snapshot result{};
+    result.copies = s_copies.load(std::memory_order_relaxed);
+    result.moves = s_moves.load(std::memory_order_relaxed);
+    result.locks = s_locks.load(std::memory_order_relaxed);
+    result.failed_locks = s_failed_locks.load(std::memory_order_relaxed);
+
+    block_registry &reg = registry();
+    {
+        // Blocks unregister under the mutex before they are freed, so the
+        // counters of every registered block can be read here
+        std::lock_guard<std::mutex> lock(reg.d_mutex);
+        result.created = reg.d_created;
+        result.destroyed = reg.d_destroyed;
+        result.live.reserve(reg.d_blocks.size());
+        for (const auto &[block, record] : reg.d_blocks) {
+            result.live.push_back({block, record.d_serial,
+                                   record.d_shared_count->load(std::memory_order_relaxed),
+                                   record.d_weak_count->load(std::memory_order_relaxed),
+                                   record.d_frames});
+        }
+    }
+    std::sort(result.live.begin(), result.live.end(),
+              [](const traced_block &a, const traced_block &b) { return a.serial < b.serial; });
+    return result;
+}
+
+void memory_trace::dump(std::ostream &os) {
+    const memory_trace_snapshot snap = snapshot();
+    os << "ksl memory trace: " << snap.live.size() << " live blocks, " << snap.created
+       << " created, " << snap.destroyed << " destroyed, " << snap.copies << " copies, "
+       << snap.moves << " moves, " << snap.locks << " locks (" << snap.failed_locks
+       << " failed)\n";
+    for (const traced_block &block : snap.live) {
+        os << "block #" << block.serial << " at " << block.block
+           << " shared=" << block.shared_count << " weak=" << block.weak_count << '\n';
+#ifdef KSL_MEMORY_TRACE_BACKTRACE
+        const int depth = static_cast<int>(block.frames.size());
+        if (depth == 0) {
+            continue;
+        }
+        std::unique_ptr<char *, decltype(&std::free)> symbols(
+            ::backtrace_symbols(block.frames.data(), depth), &std::free);
+        for (int i = 0; i < depth; ++i) {
+            os << "    " << (symbols ? symbols.get()[i] : "?") << '\n';
+        }
+#else
+        for (void *frame : block.frames) {
+            os << "    " << frame << '\n';
+        }
+#endif
+    }
+}
+
+} // namespace ksl
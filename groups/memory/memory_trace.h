@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+namespace ksl {
+
+/// A control block alive when a memory_trace::snapshot() was taken.
+struct traced_block {
+    /// Address of the control block.
+    const void *block;
+    /// Creation order over the whole process, so two snapshots can be
+    /// diffed and long-lived blocks told apart from churn.
+    std::size_t serial;
+    std::size_t shared_count;
+    /// Includes the reference held by the shared owners while the object is
+    /// alive, as control_block_base::weak_count() does.
+    std::size_t weak_count;
+    /// Return addresses of the call stack that created the block,
+    /// innermost first.
+    std::vector<void *> frames;
+};
+
+/// Counters since the start of the process, plus the live blocks ordered
+/// by serial.
+struct memory_trace_snapshot {
+    std::size_t created;
+    std::size_t destroyed;
+    /// Shared references taken from an existing one: copies, conversions
+    /// and aliases.
+    std::size_t copies;
+    std::size_t moves;
+    /// weak_ptr::lock() and shared_ptr(weak_ptr) calls, and how many of
+    /// them found the object expired.
+    std::size_t locks;
+    std::size_t failed_locks;
+    std::vector<traced_block> live;
+};
+
+/// Lifetime tracing for shared_ptr control blocks, compiled in when
+/// KSL_MEMORY_TRACE is defined (the ENABLE_MEMORY_TRACE CMake option).
+///
+/// Traced builds register every block with its allocation call stack, and
+/// count copies, moves and locks. The hooks are macros, which expand to
+/// nothing otherwise: untraced builds run the exact same code as before,
+/// and snapshot() reports nothing.
+///
+/// A live block whose shared count never drops, or a group of them created
+/// at the same site, is where to look for a cycle that should have gone
+/// through a weak_ptr.
+class memory_trace {
+  public:
+#ifdef KSL_MEMORY_TRACE
+    static constexpr bool k_enabled = true;
+#else
+    static constexpr bool k_enabled = false;
+#endif
+
+    /// Deepest allocation call stack kept per block.
+    static constexpr std::size_t k_max_frames = 32;
+
+    /// Registers a block whose counters live at shared_count and
+    /// weak_count, for as long as the block does.
+    static void block_created(const void *block, const std::atomic<std::size_t> *shared_count,
+                              const std::atomic<std::size_t> *weak_count) noexcept;
+
+    static void block_destroyed(const void *block) noexcept;
+
+    static void count_copy() noexcept { s_copies.fetch_add(1, std::memory_order_relaxed); }
+
+    static void count_copies(std::size_t count) noexcept {
+        s_copies.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    static void count_move() noexcept { s_moves.fetch_add(1, std::memory_order_relaxed); }
+
+    static void count_lock(bool succeeded) noexcept {
+        s_locks.fetch_add(1, std::memory_order_relaxed);
+        if (!succeeded) {
+            s_failed_locks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] static memory_trace_snapshot snapshot();
+
+    /// Writes the counters and every live block, with its allocation call
+    /// stack symbolized where the platform allows, to os.
+    static void dump(std::ostream &os);
+
+  private:
+    static inline std::atomic<std::size_t> s_copies{0};
+    static inline std::atomic<std::size_t> s_moves{0};
+    static inline std::atomic<std::size_t> s_locks{0};
+    static inline std::atomic<std::size_t> s_failed_locks{0};
+};
+
+} // namespace ksl
+
+#ifdef KSL_MEMORY_TRACE
+#define KSL_MEMORY_TRACE_BLOCK_CREATED(block, shared_count, weak_count)                        \
+    ::ksl::memory_trace::block_created(block, shared_count, weak_count)
+#define KSL_MEMORY_TRACE_BLOCK_DESTROYED(block) ::ksl::memory_trace::block_destroyed(block)
+#define KSL_MEMORY_TRACE_COPY() ::ksl::memory_trace::count_copy()
+#define KSL_MEMORY_TRACE_COPIES(count) ::ksl::memory_trace::count_copies(count)
+#define KSL_MEMORY_TRACE_MOVE() ::ksl::memory_trace::count_move()
+#define KSL_MEMORY_TRACE_LOCK(succeeded) ::ksl::memory_trace::count_lock(succeeded)
+#else
+#define KSL_MEMORY_TRACE_BLOCK_CREATED(block, shared_count, weak_count) ((void)0)
+#define KSL_MEMORY_TRACE_BLOCK_DESTROYED(block) ((void)0)
+#define KSL_MEMORY_TRACE_COPY() ((void)0)
+#define KSL_MEMORY_TRACE_COPIES(count) ((void)(count))
+#define KSL_MEMORY_TRACE_MOVE() ((void)0)
+#define KSL_MEMORY_TRACE_LOCK(succeeded) ((void)0)
+#endif
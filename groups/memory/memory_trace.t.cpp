@@ -0,0 +1,183 @@
+// Component being tested
+#include <memory_trace.h>
+
+#include <shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class MemoryTraceTest : public ::testing::Test {
+  protected:
+    struct Node {
+        int value;
+        shared_ptr<Node> next;
+
+        explicit Node(int v = 42) : value(v) {}
+    };
+
+    void SetUp() override {
+        if (!memory_trace::k_enabled) {
+            GTEST_SKIP() << "built without KSL_MEMORY_TRACE";
+        }
+    }
+
+    static const traced_block *find(const memory_trace_snapshot &snap, const void *block) {
+        auto it = std::find_if(snap.live.begin(), snap.live.end(),
+                               [block](const traced_block &b) { return b.block == block; });
+        return it == snap.live.end() ? nullptr : &*it;
+    }
+
+    /// The control block of ptr, without changing its counts.
+    template <typename T> static const void *block_of(shared_ptr<T> &ptr) {
+        T *object = ptr.get();
+        control_block_base *cb = shared_ptr_access::detach(ptr);
+        ptr = shared_ptr_access::adopt<T>(object, cb);
+        return cb;
+    }
+};
+
+// ============================================================================
+// UNTRACED BUILDS
+// ============================================================================
+
+TEST(MemoryTraceDisabledTest, SnapshotIsEmpty) {
+    if (memory_trace::k_enabled) {
+        GTEST_SKIP() << "built with KSL_MEMORY_TRACE";
+    }
+    shared_ptr<int> ptr = make_shared<int>(1);
+    shared_ptr<int> copy = ptr;
+    const memory_trace_snapshot snap = memory_trace::snapshot();
+    EXPECT_EQ(snap.created, 0u);
+    EXPECT_EQ(snap.copies, 0u);
+    EXPECT_TRUE(snap.live.empty());
+}
+
+// ============================================================================
+// LIVE BLOCKS
+// ============================================================================
+
+TEST_F(MemoryTraceTest, TracksLiveBlocks) {
+    const memory_trace_snapshot before = memory_trace::snapshot();
+
+    shared_ptr<Node> ptr = make_shared<Node>(1);
+    weak_ptr<Node> observer = ptr;
+    const void *block = block_of(ptr);
+
+    memory_trace_snapshot snap = memory_trace::snapshot();
+    EXPECT_EQ(snap.created - before.created, 1u);
+    const traced_block *traced = find(snap, block);
+    ASSERT_NE(traced, nullptr);
+    EXPECT_EQ(traced->shared_count, 1u);
+    EXPECT_EQ(traced->weak_count, 2u);
+    EXPECT_FALSE(traced->frames.empty());
+    EXPECT_LE(traced->frames.size(), memory_trace::k_max_frames);
+
+    // The block outlives the object while the weak_ptr holds it
+    ptr.reset();
+    snap = memory_trace::snapshot();
+    ASSERT_NE(find(snap, block), nullptr);
+    EXPECT_EQ(find(snap, block)->shared_count, 0u);
+
+    observer.reset();
+    snap = memory_trace::snapshot();
+    EXPECT_EQ(find(snap, block), nullptr);
+    EXPECT_EQ(snap.destroyed - before.destroyed, 1u);
+}
+
+TEST_F(MemoryTraceTest, CycleStaysLive) {
+    // Two nodes owning each other: the leak the trace is there to find
+    const memory_trace_snapshot before = memory_trace::snapshot();
+    weak_ptr<Node> observer;
+    {
+        shared_ptr<Node> first = make_shared<Node>(1);
+        shared_ptr<Node> second = make_shared<Node>(2);
+        first->next = second;
+        second->next = first;
+        observer = first;
+    }
+    memory_trace_snapshot after = memory_trace::snapshot();
+    EXPECT_EQ(after.created - before.created, 2u);
+    EXPECT_EQ(after.destroyed, before.destroyed);
+    ASSERT_GE(after.live.size(), 2u);
+    EXPECT_EQ(after.live[after.live.size() - 1].shared_count, 1u);
+    EXPECT_EQ(after.live[after.live.size() - 2].shared_count, 1u);
+
+    // Breaking the cycle releases both
+    observer.lock()->next.reset();
+    observer.reset();
+    after = memory_trace::snapshot();
+    EXPECT_EQ(after.destroyed - before.destroyed, 2u);
+}
+
+// ============================================================================
+// OPERATION COUNTS
+// ============================================================================
+
+TEST_F(MemoryTraceTest, CountsCopiesMovesAndLocks) {
+    const memory_trace_snapshot before = memory_trace::snapshot();
+
+    shared_ptr<Node> ptr = make_shared<Node>(1);
+    shared_ptr<Node> copy(ptr);
+    shared_ptr<Node> moved(std::move(copy));
+    copy = moved;
+    moved = std::move(copy);
+
+    weak_ptr<Node> observer = ptr;
+    EXPECT_TRUE(observer.lock());
+    ptr.reset();
+    moved.reset();
+    EXPECT_FALSE(observer.lock());
+
+    const memory_trace_snapshot after = memory_trace::snapshot();
+    EXPECT_EQ(after.copies - before.copies, 2u);
+    EXPECT_EQ(after.moves - before.moves, 2u);
+    EXPECT_EQ(after.locks - before.locks, 2u);
+    EXPECT_EQ(after.failed_locks - before.failed_locks, 1u);
+}
+
+TEST_F(MemoryTraceTest, ConcurrentCreationAndRelease) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 500;
+    const memory_trace_snapshot before = memory_trace::snapshot();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < k_rounds; ++i) {
+                shared_ptr<Node> ptr = make_shared<Node>(i);
+                shared_ptr<Node> copy(ptr);
+                (void)memory_trace::snapshot();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    const memory_trace_snapshot after = memory_trace::snapshot();
+    EXPECT_EQ(after.created - before.created, std::size_t{k_threads * k_rounds});
+    EXPECT_EQ(after.destroyed - before.destroyed, std::size_t{k_threads * k_rounds});
+    EXPECT_EQ(after.copies - before.copies, std::size_t{k_threads * k_rounds});
+}
+
+// ============================================================================
+// DUMP
+// ============================================================================
+
+TEST_F(MemoryTraceTest, DumpListsLiveBlocks) {
+    shared_ptr<Node> ptr = make_shared<Node>(1);
+    std::ostringstream os;
+    memory_trace::dump(os);
+    const std::string out = os.str();
+    EXPECT_EQ(out.rfind("ksl memory trace: ", 0), 0u);
+    EXPECT_NE(out.find("shared=1 weak=1"), std::string::npos);
+}
+
+} // namespace ksl
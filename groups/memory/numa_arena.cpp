@@ -0,0 +1,305 @@
+#include <numa_arena.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ksl {
+namespace {
+
+/// Highest node in a sysfs node list such as "0" or "0-1,3", plus one.
+int parse_node_count(const std::string &list) noexcept {
+    int highest = 0;
+    int value = 0;
+    bool in_number = false;
+    for (char c : list) {
+        if (c >= '0' && c <= '9') {
+            value = std::min(value * 10 + (c - '0'), numa_arena::k_max_nodes);
+            in_number = true;
+        } else if (in_number) {
+            highest = std::max(highest, value);
+            value = 0;
+            in_number = false;
+        }
+    }
+    if (in_number) {
+        highest = std::max(highest, value);
+    }
+    return std::clamp(highest + 1, 1, numa_arena::k_max_nodes);
+}
+
+int detect_node_count() {
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string list;
+    if (!std::getline(online, list)) {
+        return 1;
+    }
+    return parse_node_count(list);
+}
+
+/// Node of every CPU, from each node's sysfs cpulist such as "0-3,8-11".
+/// CPUs no node lists are on node 0, and so is everything if the lists
+/// cannot be parsed.
+std::vector<int> detect_cpu_nodes(int node_count) {
+    std::vector<int> nodes;
+    for (int node = 0; node < node_count; ++node) {
+        std::ifstream list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string range;
+        while (std::getline(list, range, ',')) {
+            std::size_t first = 0;
+            std::size_t last = 0;
+            if (!numa_arena::parse_cpu_range(range, first, last)) {
+                continue;
+            }
+            if (nodes.size() <= last) {
+                nodes.resize(last + 1, 0);
+            }
+            std::fill(nodes.begin() + static_cast<std::ptrdiff_t>(first),
+                      nodes.begin() + static_cast<std::ptrdiff_t>(last) + 1, node);
+        }
+    }
+    return nodes;
+}
+
+// ============================================================================
+// NODE MEMORY
+// ============================================================================
+
+/// Maps memory for the pools of one node's arena, binding every mapping to
+/// the node. Allocations are whole pages, so it is only asked for chunks
+/// and for allocations too large for the pools. Only used under the
+/// arena's mutex.
+class node_memory_resource : public pmr::memory_resource {
+    int d_node;
+    std::size_t d_mapped = 0;
+    std::size_t d_unbound = 0;
+
+  public:
+    explicit node_memory_resource(int node) noexcept : d_node(node) {}
+
+    [[nodiscard]] std::size_t mapped_bytes() const noexcept { return d_mapped; }
+    [[nodiscard]] std::size_t unbound_bytes() const noexcept { return d_unbound; }
+
+  private:
+#if defined(__linux__)
+    static std::size_t page_size() noexcept {
+        static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    static std::size_t mapping_length(std::size_t bytes) noexcept {
+        return (bytes + page_size() - 1) / page_size() * page_size();
+    }
+
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        assert(alignment <= page_size() && "numa_arena aligns to at most a page");
+        const std::size_t length = mapping_length(bytes);
+        void *ptr = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        // Binding before the first touch places every page as it faults in
+        std::uint64_t mask = std::uint64_t{1} << d_node;
+        if (::syscall(SYS_mbind, ptr, length, MPOL_PREFERRED, &mask, numa_arena::k_max_nodes + 1,
+                      0) != 0) {
+            d_unbound += length;
+        }
+        d_mapped += length;
+        return ptr;
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+        assert(alignment <= page_size() && "numa_arena aligns to at most a page");
+        const std::size_t length = mapping_length(bytes);
+        ::munmap(ptr, length);
+        d_mapped -= length;
+    }
+#else
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        void *ptr = ::operator new(bytes, std::align_val_t(alignment));
+        d_mapped += bytes;
+        d_unbound += bytes;
+        return ptr;
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+        ::operator delete(ptr, bytes, std::align_val_t(alignment));
+        d_mapped -= bytes;
+        d_unbound -= bytes;
+    }
+#endif
+
+    [[nodiscard]] bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// ============================================================================
+// ARENAS
+// ============================================================================
+
+/// Chunks of up to this many blocks keep the number of mappings low: with
+/// the 64-byte class of a small make_shared block, chunks grow to 1 MiB.
+constexpr std::size_t k_max_blocks_per_chunk = std::size_t{1} << 14;
+
+class arena : public pmr::memory_resource {
+    int d_node;
+    std::mutex d_mutex;
+    node_memory_resource d_memory;
+    pmr::unsynchronized_pool_resource d_pools;
+    numa_node_stats d_stats{};
+
+  public:
+    explicit arena(int node) noexcept
+        : d_node(node), d_memory(node),
+          d_pools(pmr::pool_options{k_max_blocks_per_chunk, 0}, &d_memory) {}
+
+    [[nodiscard]] numa_node_stats stats() noexcept {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        numa_node_stats result = d_stats;
+        result.mapped_bytes = d_memory.mapped_bytes();
+        result.unbound_bytes = d_memory.unbound_bytes();
+        return result;
+    }
+
+  private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override {
+        const bool remote = numa_arena::current_node() != d_node;
+        std::lock_guard<std::mutex> lock(d_mutex);
+        void *ptr = d_pools.allocate(bytes, alignment);
+        d_stats.allocations++;
+        d_stats.remote_allocations += remote ? 1 : 0;
+        d_stats.live_bytes += bytes;
+        return ptr;
+    }
+
+    void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) override {
+        const bool remote = numa_arena::current_node() != d_node;
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_pools.deallocate(ptr, bytes, alignment);
+        d_stats.remote_deallocations += remote ? 1 : 0;
+        d_stats.live_bytes -= bytes;
+    }
+
+    [[nodiscard]] bool do_is_equal(const memory_resource &other) const noexcept override {
+        return this == &other;
+    }
+};
+
+// ============================================================================
+// TOPOLOGY
+// ============================================================================
+
+/// What sysfs says about the nodes, and an arena for each.
+struct topology {
+    int d_node_count;
+    std::vector<int> d_cpu_nodes;
+    std::vector<std::unique_ptr<arena>> d_arenas;
+
+    topology() : d_node_count(detect_node_count()), d_cpu_nodes(detect_cpu_nodes(d_node_count)) {
+        for (int node = 0; node < d_node_count; ++node) {
+            d_arenas.push_back(std::make_unique<arena>(node));
+        }
+    }
+};
+
+topology &nodes() {
+    // Leaked on purpose: blocks may be freed during static destruction,
+    // after a function-local static would be gone.
+    static topology *instance = new topology;
+    return *instance;
+}
+
+/// Builds the topology during static initialization, where running out of
+/// memory fails the program at startup, so the noexcept accessors only
+/// ever read it. A static initializer elsewhere that reaches them first
+/// builds it there instead.
+[[maybe_unused]] const topology &s_nodes = nodes();
+
+} // namespace
+
+// ============================================================================
+// NUMA ARENA
+// ============================================================================
+
+bool numa_arena::parse_cpu_range(std::string_view range, std::size_t &first,
+                                 std::size_t &last) noexcept {
+    constexpr std::string_view k_whitespace = " \t\n";
+    const std::size_t begin = range.find_first_not_of(k_whitespace);
+    if (begin == std::string_view::npos) {
+        return false;
+    }
+    range = range.substr(begin, range.find_last_not_of(k_whitespace) - begin + 1);
+
+    const char *end = range.data() + range.size();
+    const std::from_chars_result parsed = std::from_chars(range.data(), end, first);
+    if (parsed.ec != std::errc()) {
+        return false;
+    }
+    last = first;
+    if (parsed.ptr != end) {
+        if (*parsed.ptr != '-') {
+            return false;
+        }
+        const std::from_chars_result upper = std::from_chars(parsed.ptr + 1, end, last);
+        if (upper.ec != std::errc() || upper.ptr != end) {
+            return false;
+        }
+    }
+    return first <= last && last < k_max_cpus;
+}
+
+int numa_arena::node_count() noexcept { return nodes().d_node_count; }
+
+int numa_arena::current_node() noexcept {
+#if defined(__linux__)
+    // The arenas call this on every allocation and deallocation, and
+    // sched_getcpu with a lookup takes about half as long as getcpu's node
+    const std::vector<int> &cpu_nodes = nodes().d_cpu_nodes;
+    const int cpu = ::sched_getcpu();
+    if (cpu >= 0 && static_cast<std::size_t>(cpu) < cpu_nodes.size()) {
+        return cpu_nodes[static_cast<std::size_t>(cpu)];
+    }
+#endif
+    return 0;
+}
+
+int numa_arena::node_of(const void *ptr) noexcept {
+#if defined(__linux__)
+    int node = k_no_node;
+    if (::syscall(SYS_get_mempolicy, &node, nullptr, 0, const_cast<void *>(ptr),
+                  MPOL_F_NODE | MPOL_F_ADDR) == 0) {
+        return node;
+    }
+    return k_no_node;
+#else
+    (void)ptr;
+    return k_no_node;
+#endif
+}
+
+pmr::memory_resource *numa_arena::resource(int node) {
+    assert(node >= 0 && node < node_count() && "No such node");
+    return nodes().d_arenas[static_cast<std::size_t>(node)].get();
+}
+
+numa_node_stats numa_arena::stats(int node) noexcept {
+    assert(node >= 0 && node < node_count() && "No such node");
+    return nodes().d_arenas[static_cast<std::size_t>(node)]->stats();
+}
+
+} // namespace ksl
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <memory_resource.h>
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <string_view>
+
+namespace ksl {
+
+/// Placement counters of one node's arena.
+struct numa_node_stats {
+    /// Allocations served by the arena.
+    std::size_t allocations;
+    /// Of those, allocations made by a thread running on another node.
+    std::size_t remote_allocations;
+    /// Deallocations made by a thread running on another node.
+    std::size_t remote_deallocations;
+    /// Bytes handed out and not returned yet.
+    std::size_t live_bytes;
+    /// Bytes mapped from the system for the arena.
+    std::size_t mapped_bytes;
+    /// Mapped bytes the kernel would not bind to the node, which its
+    /// default policy places instead.
+    std::size_t unbound_bytes;
+};
+
+/// One memory arena per NUMA node, for objects that should live next to
+/// the threads that use them instead of wherever the allocating thread's
+/// malloc arena happens to be.
+///
+/// Each arena maps its memory with mmap and binds it to its node with
+/// mbind(MPOL_PREFERRED): pages land on the node while it has free memory,
+/// and elsewhere rather than failing when it runs out. On top of that
+/// memory, allocations are served by an unsynchronized_pool_resource
+/// behind the arena's mutex, so sizes are rounded up to a power of two and
+/// freed blocks are reused by the next allocation of their class from any
+/// thread. The arenas, and the topology they are made from, are built
+/// during static initialization and live for the whole process.
+///
+/// A thread can also set a preferred node: make_shared and allocate_shared
+/// with std::allocator then allocate from that node's arena.
+class numa_arena {
+  public:
+    static constexpr int k_no_node = -1;
+    static constexpr int k_max_nodes = 64;
+    /// CPUs above this, the kernel's own limit, are taken as malformed.
+    static constexpr std::size_t k_max_cpus = 8192;
+
+    /// Nodes from 0 to the highest online one, 1 on a system without NUMA.
+    [[nodiscard]] static int node_count() noexcept;
+
+    /// Node of the CPU the calling thread runs on at the moment.
+    [[nodiscard]] static int current_node() noexcept;
+
+    /// Node holding the page at ptr, faulting it in first, or k_no_node if
+    /// the kernel does not say.
+    [[nodiscard]] static int node_of(const void *ptr) noexcept;
+
+    /// The arena of node, which must be below node_count().
+    [[nodiscard]] static pmr::memory_resource *resource(int node);
+
+    [[nodiscard]] static numa_node_stats stats(int node) noexcept;
+
+    /// Parses one range of a sysfs cpulist such as "0-3,8-11", e.g. "8-11"
+    /// or "3", into first and last, ignoring surrounding whitespace. Returns
+    /// false, without throwing, for an empty range, which is what a node
+    /// without CPUs lists, for a malformed one, and for CPUs from
+    /// k_max_cpus up.
+    [[nodiscard]] static bool parse_cpu_range(std::string_view range, std::size_t &first,
+                                              std::size_t &last) noexcept;
+
+    /// THREAD POLICY
+    /// Sends the calling thread's make_shared and allocate_shared with
+    /// std::allocator to node's arena, or back to the global heap for
+    /// k_no_node. Blocks keep the node they were allocated on, whatever
+    /// the policy is when they are freed.
+    static void set_preferred_node(int node) noexcept {
+        assert((node == k_no_node || (node >= 0 && node < node_count())) && "No such node");
+        t_preferred_node = node;
+    }
+
+    [[nodiscard]] static int preferred_node() noexcept { return t_preferred_node; }
+
+  private:
+    static inline thread_local int t_preferred_node = k_no_node;
+};
+
+/// Sets the calling thread's preferred node for a scope, and restores the
+/// previous one when it ends.
+class preferred_node_scope {
+    int d_previous;
+
+  public:
+    explicit preferred_node_scope(int node) noexcept : d_previous(numa_arena::preferred_node()) {
+        numa_arena::set_preferred_node(node);
+    }
+
+    preferred_node_scope(const preferred_node_scope &) = delete;
+    preferred_node_scope &operator=(const preferred_node_scope &) = delete;
+
+    ~preferred_node_scope() { numa_arena::set_preferred_node(d_previous); }
+};
+
+/// Allocator over one node's arena. Pass it to allocate_shared, or to
+/// shared_ptr(T*, Deleter, Alloc) for the control block; the block keeps a
+/// copy, which holds the node.
+template <typename T> class numa_allocator {
+    int d_node;
+
+  public:
+    using value_type = T;
+
+    /// The calling thread's preferred node, or the one it runs on if it
+    /// has none.
+    numa_allocator() noexcept
+        : d_node(numa_arena::preferred_node() != numa_arena::k_no_node
+                     ? numa_arena::preferred_node()
+                     : numa_arena::current_node()) {}
+
+    explicit numa_allocator(int node) noexcept : d_node(node) {
+        assert(node >= 0 && node < numa_arena::node_count() && "No such node");
+    }
+
+    template <typename U>
+    numa_allocator(const numa_allocator<U> &rhs) noexcept : d_node(rhs.node()) {}
+
+    [[nodiscard]] T *allocate(std::size_t n) {
+        if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(numa_arena::resource(d_node)->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        numa_arena::resource(d_node)->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    [[nodiscard]] int node() const noexcept { return d_node; }
+
+    template <typename U>
+    [[nodiscard]] bool operator==(const numa_allocator<U> &rhs) const noexcept {
+        return d_node == rhs.node();
+    }
+};
+
+} // namespace ksl
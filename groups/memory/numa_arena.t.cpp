@@ -0,0 +1,210 @@
+// Component being tested
+#include <numa_arena.h>
+
+#include <shared_ptr.h>
+#include <thin_shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class NumaArenaTest : public ::testing::Test {
+  protected:
+    struct Node {
+        int value;
+
+        explicit Node(int v = 5) : value(v) {}
+    };
+
+    struct Large {
+        std::array<std::byte, 2 * k_make_shared_inline_limit> bytes{};
+    };
+
+    /// Every test runs on the last node, which is node 0 without NUMA.
+    static int node() { return numa_arena::node_count() - 1; }
+
+    static std::size_t allocations() { return numa_arena::stats(node()).allocations; }
+};
+
+// ============================================================================
+// NODES
+// ============================================================================
+
+TEST_F(NumaArenaTest, KnowsTheNodes) {
+    EXPECT_GE(numa_arena::node_count(), 1);
+    EXPECT_LE(numa_arena::node_count(), numa_arena::k_max_nodes);
+
+    const int current = numa_arena::current_node();
+    EXPECT_GE(current, 0);
+    EXPECT_LT(current, numa_arena::node_count());
+}
+
+TEST_F(NumaArenaTest, ParsesCpuRanges) {
+    std::size_t first = 99;
+    std::size_t last = 99;
+    EXPECT_TRUE(numa_arena::parse_cpu_range("3", first, last));
+    EXPECT_EQ(first, 3u);
+    EXPECT_EQ(last, 3u);
+    EXPECT_TRUE(numa_arena::parse_cpu_range("8-11\n", first, last));
+    EXPECT_EQ(first, 8u);
+    EXPECT_EQ(last, 11u);
+}
+
+TEST_F(NumaArenaTest, RejectsEmptyAndMalformedCpuRanges) {
+    std::size_t first = 0;
+    std::size_t last = 0;
+    // The cpulist of a node without CPUs, such as a CXL or HBM node
+    EXPECT_FALSE(numa_arena::parse_cpu_range("\n", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range(" \t", first, last));
+
+    EXPECT_FALSE(numa_arena::parse_cpu_range("x", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("-3", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("3-", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("3-x", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("5-2", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("0-99999999999", first, last));
+    EXPECT_FALSE(numa_arena::parse_cpu_range("99999999999999999999999", first, last));
+}
+
+TEST_F(NumaArenaTest, MakeSharedOnNode) {
+    const numa_node_stats before = numa_arena::stats(node());
+    {
+        auto ptr = make_shared_on_node<Node>(node(), 9);
+        EXPECT_EQ(ptr->value, 9);
+
+        const numa_node_stats during = numa_arena::stats(node());
+        EXPECT_EQ(during.allocations, before.allocations + 1);
+        EXPECT_GT(during.live_bytes, before.live_bytes);
+        EXPECT_GT(during.mapped_bytes, 0u);
+        if (during.unbound_bytes == 0) {
+            EXPECT_EQ(numa_arena::node_of(ptr.get()), node());
+        }
+    }
+    EXPECT_EQ(numa_arena::stats(node()).live_bytes, before.live_bytes);
+}
+
+TEST_F(NumaArenaTest, MakeSharedOnNodeArray) {
+    const std::size_t before = allocations();
+    auto values = make_shared_on_node<int[]>(node(), 100);
+    EXPECT_EQ(allocations(), before + 1);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(values[i], 0);
+    }
+}
+
+TEST_F(NumaArenaTest, FreedBlocksAreReused) {
+    const Node *first = make_shared_on_node<Node>(node()).get();
+    auto second = make_shared_on_node<Node>(node());
+    EXPECT_EQ(second.get(), first);
+}
+
+// ============================================================================
+// THREAD POLICY
+// ============================================================================
+
+TEST_F(NumaArenaTest, PreferredNodeScope) {
+    EXPECT_EQ(numa_arena::preferred_node(), numa_arena::k_no_node);
+    {
+        preferred_node_scope outer(node());
+        EXPECT_EQ(numa_arena::preferred_node(), node());
+        {
+            preferred_node_scope inner(numa_arena::k_no_node);
+            EXPECT_EQ(numa_arena::preferred_node(), numa_arena::k_no_node);
+        }
+        EXPECT_EQ(numa_arena::preferred_node(), node());
+    }
+    EXPECT_EQ(numa_arena::preferred_node(), numa_arena::k_no_node);
+}
+
+TEST_F(NumaArenaTest, PreferredNodeRedirectsMakeShared) {
+    const std::size_t before = allocations();
+    shared_ptr<Node> placed;
+    {
+        preferred_node_scope scope(node());
+        placed = make_shared<Node>(3);
+        auto overwritten = make_shared_for_overwrite<Node>();
+        auto padded = make_shared<Node>(padded_layout);
+        auto array = make_shared<int[4]>();
+        auto allocated = ksl::allocate_shared<Node>(std::allocator<Node>());
+        EXPECT_EQ(allocations(), before + 5);
+    }
+    EXPECT_EQ(placed->value, 3);
+
+    // Without the policy, make_shared is back on the global heap
+    auto unplaced = make_shared<Node>();
+    EXPECT_EQ(allocations(), before + 5);
+    placed.reset();
+    EXPECT_EQ(numa_arena::stats(node()).allocations, before + 5);
+}
+
+TEST_F(NumaArenaTest, PreferredNodeKeepsOtherAllocators) {
+    const std::size_t before = allocations();
+    preferred_node_scope scope(node());
+    auto pooled = ksl::allocate_shared<Node>(pool_allocator<Node>());
+    EXPECT_EQ(allocations(), before);
+}
+
+TEST_F(NumaArenaTest, SplitObjectsAreOnTheNodeToo) {
+    const std::size_t before = allocations();
+    preferred_node_scope scope(node());
+    auto large = make_shared<Large>();
+    EXPECT_EQ(allocations(), before + 2);
+}
+
+TEST_F(NumaArenaTest, ThinSharedFollowsThePolicy) {
+    const std::size_t before = allocations();
+    preferred_node_scope scope(node());
+    auto thin = make_thin_shared<Node>(4);
+    EXPECT_EQ(allocations(), before + 1);
+    EXPECT_TRUE(thin_shared_ptr<Node>::can_hold(shared_ptr<Node>(thin)));
+}
+
+TEST_F(NumaArenaTest, AllocatorDefaultsToThePreferredNode) {
+    EXPECT_EQ(numa_allocator<int>().node(), numa_arena::current_node());
+    preferred_node_scope scope(node());
+    EXPECT_EQ(numa_allocator<int>().node(), node());
+    EXPECT_EQ(numa_allocator<int>(), numa_allocator<double>(node()));
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(NumaArenaTest, ThreadsShareAnArena) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 2000;
+    const std::size_t live_before = numa_arena::stats(node()).live_bytes;
+    std::latch start(k_threads);
+
+    std::vector<std::thread> threads;
+    std::vector<shared_ptr<Node>> handed_over(k_threads);
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&start, &handed_over, t] {
+            preferred_node_scope scope(node());
+            start.arrive_and_wait();
+            for (int i = 0; i < k_rounds; ++i) {
+                auto ptr = make_shared<Node>(i);
+                EXPECT_EQ(ptr->value, i);
+            }
+            handed_over[static_cast<std::size_t>(t)] = make_shared<Node>(t);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    // Blocks made on other threads are freed here, back to their arena
+    EXPECT_GT(numa_arena::stats(node()).live_bytes, live_before);
+    handed_over.clear();
+    EXPECT_EQ(numa_arena::stats(node()).live_bytes, live_before);
+}
+
+} // namespace ksl
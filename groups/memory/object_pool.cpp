@@ -0,0 +1 @@
+#include <object_pool.h>
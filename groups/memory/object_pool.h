@@ -0,0 +1,231 @@
+#pragma once
+
+#include <scalable_shared_ptr.h>
+#include <shared_ptr.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+/// Pool counters. in_use and high_water_mark are exact; the others are
+/// summed shard by shard, so they may be slightly out of step with each
+/// other while the pool is in use.
+struct object_pool_stats {
+    /// acquire() calls served from a free list.
+    std::size_t hits;
+    /// acquire() calls that had to construct a new object.
+    std::size_t misses;
+    /// Objects handed out and not yet back in the pool.
+    std::size_t in_use;
+    /// Most objects in use at once.
+    std::size_t high_water_mark;
+    /// Objects waiting on the free lists.
+    std::size_t cached;
+
+    [[nodiscard]] double hit_rate() const noexcept {
+        const std::size_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+/// Reset hook that leaves a returned object as it is.
+struct no_reset {
+    template <typename T> void operator()(T &) const noexcept {}
+};
+
+namespace {
+template <typename T, typename Reset> struct object_pool_state;
+
+/// The object and its counters in one allocation, which goes back to the
+/// pool as a unit. dispose() only runs the reset hook; the object stays
+/// constructed until the pool lets go of the block for good.
+template <typename T, typename Reset>
+struct control_block_object_pool_impl : public control_block_base {
+    T d_object;
+    object_pool_state<T, Reset> *d_state;
+    control_block_object_pool_impl *d_next = nullptr;
+
+    explicit control_block_object_pool_impl(object_pool_state<T, Reset> *state)
+        : d_object(), d_state(state) {}
+
+    bool dispose() override {
+        d_state->d_reset(d_object);
+        return true;
+    }
+    void destroy() noexcept override { d_state->recycle(this); }
+    std::size_t retained_bytes() const noexcept override { return sizeof(*this); }
+};
+
+/// State shared by an object_pool and every block it has handed out, so
+/// blocks released after the pool is gone still have somewhere to go.
+/// Freed with the last of its references: one for the pool, one per block
+/// in use.
+template <typename T, typename Reset> struct object_pool_state {
+    using block = control_block_object_pool_impl<T, Reset>;
+
+    /// Free list of the threads mapped to one scalable_shard.
+    struct alignas(scalable_shard::k_cache_line) shard {
+        std::mutex d_mutex;
+        block *d_free = nullptr;
+        std::size_t d_cached = 0;
+        std::size_t d_hits = 0;
+        std::size_t d_misses = 0;
+        bool d_closed = false;
+    };
+
+    shard d_shards[scalable_shard::k_count];
+    [[no_unique_address]] Reset d_reset;
+    std::size_t d_max_cached;
+    std::atomic<std::size_t> d_refs{1};
+    std::atomic<std::size_t> d_high_water_mark{0};
+
+    object_pool_state(Reset reset, std::size_t max_cached)
+        : d_reset(std::move(reset)), d_max_cached(max_cached) {}
+
+    /// Pops a block from the calling thread's shard, or makes a new one,
+    /// with its counts set for one new owner.
+    block *acquire() {
+        shard &local = d_shards[scalable_shard::current()];
+        block *cb = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(local.d_mutex);
+            if ((cb = local.d_free)) {
+                local.d_free = cb->d_next;
+                local.d_cached--;
+                local.d_hits++;
+            } else {
+                local.d_misses++;
+            }
+        }
+        if (cb) {
+            // Both counts reached zero before the block was recycled, and
+            // the shard's mutex orders that before this
+            cb->d_shared_count.store(1, std::memory_order_relaxed);
+            cb->d_weak_count.store(1, std::memory_order_relaxed);
+        } else {
+            cb = new block(this);
+        }
+
+        const std::size_t in_use = d_refs.fetch_add(1, std::memory_order_relaxed);
+        std::size_t peak = d_high_water_mark.load(std::memory_order_relaxed);
+        while (in_use > peak && !d_high_water_mark.compare_exchange_weak(
+                                    peak, in_use, std::memory_order_relaxed)) {
+        }
+        return cb;
+    }
+
+    /// Takes back a block no handle refers to any more, on the releasing
+    /// thread's shard, unless it is full or the pool is gone.
+    void recycle(block *cb) noexcept {
+        shard &local = d_shards[scalable_shard::current()];
+        bool kept = false;
+        {
+            std::lock_guard<std::mutex> lock(local.d_mutex);
+            if (!local.d_closed && local.d_cached < d_max_cached) {
+                cb->d_next = local.d_free;
+                local.d_free = cb;
+                local.d_cached++;
+                kept = true;
+            }
+        }
+        if (!kept) {
+            delete cb;
+        }
+        release();
+    }
+
+    /// Called by the pool's destructor: frees the cached blocks and makes
+    /// blocks still in use free themselves when they come back.
+    void close() noexcept {
+        for (shard &each : d_shards) {
+            block *cb = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(each.d_mutex);
+                each.d_closed = true;
+                cb = std::exchange(each.d_free, nullptr);
+                each.d_cached = 0;
+            }
+            while (cb) {
+                delete std::exchange(cb, cb->d_next);
+            }
+        }
+        release();
+    }
+
+    void release() noexcept {
+        if (d_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    [[nodiscard]] object_pool_stats stats() noexcept {
+        object_pool_stats result{};
+        for (shard &each : d_shards) {
+            std::lock_guard<std::mutex> lock(each.d_mutex);
+            result.hits += each.d_hits;
+            result.misses += each.d_misses;
+            result.cached += each.d_cached;
+        }
+        result.in_use = d_refs.load(std::memory_order_relaxed) - 1;
+        result.high_water_mark = d_high_water_mark.load(std::memory_order_relaxed);
+        return result;
+    }
+};
+} // namespace
+
+// ============================================================================
+// OBJECT POOL DEFINITION
+// ============================================================================
+
+/// Recycles objects handed out as shared_ptrs. When the last owner and
+/// weak_ptr of an acquired object let go, the object, still constructed,
+/// and its control block go back to a free list as one allocation, after
+/// reset(object) has run, and the next acquire() returns them without
+/// constructing or allocating anything.
+///
+/// Free lists are striped over scalable_shard's shards, so threads mostly
+/// reuse their own objects under their own uncontended lock. Each shard
+/// keeps at most max_cached objects and frees the rest.
+///
+/// Handles may outlive the pool: their objects are then destroyed as
+/// usual when released. T must be default constructible and must not
+/// derive from enable_shared_from_this, whose embedded weak_ptr would
+/// keep a recycled block alive for good.
+template <typename T, typename Reset = no_reset> class object_pool {
+    static_assert(!std::is_array_v<T>, "object_pool holds single objects");
+    static_assert(!EnablesSharedFromThis<T>,
+                  "pooled objects cannot derive from enable_shared_from_this");
+
+    using state = object_pool_state<T, Reset>;
+
+    state *d_state;
+
+  public:
+    using Value_Type = T;
+
+    /// Objects kept per shard by default.
+    static constexpr std::size_t k_default_max_cached = 1024;
+
+    explicit object_pool(Reset reset = Reset(), std::size_t max_cached = k_default_max_cached)
+        : d_state(new state(std::move(reset), max_cached)) {}
+
+    object_pool(const object_pool &) = delete;
+    object_pool &operator=(const object_pool &) = delete;
+
+    ~object_pool() { d_state->close(); }
+
+    /// A recycled object, reset on its way back into the pool, or a new
+    /// default-constructed one.
+    [[nodiscard]] shared_ptr<T> acquire() {
+        auto cb = d_state->acquire();
+        return shared_ptr_access::adopt<T>(&cb->d_object, cb);
+    }
+
+    [[nodiscard]] object_pool_stats stats() const noexcept { return d_state->stats(); }
+};
+
+} // namespace ksl
@@ -0,0 +1,196 @@
+// Component being tested
+#include <object_pool.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class ObjectPoolTest : public ::testing::Test {
+  protected:
+    struct Message {
+        int value = 0;
+        std::vector<char> payload;
+        static std::atomic<int> constructor_count;
+        static std::atomic<int> destructor_count;
+
+        Message() { constructor_count++; }
+        ~Message() { destructor_count++; }
+    };
+
+    struct ClearMessage {
+        void operator()(Message &message) const noexcept {
+            message.value = 0;
+            message.payload.clear();
+        }
+    };
+
+    void SetUp() override {
+        Message::constructor_count = 0;
+        Message::destructor_count = 0;
+    }
+};
+
+std::atomic<int> ObjectPoolTest::Message::constructor_count = 0;
+std::atomic<int> ObjectPoolTest::Message::destructor_count = 0;
+
+// ============================================================================
+// RECYCLING
+// ============================================================================
+
+TEST_F(ObjectPoolTest, ReleasedObjectIsReused) {
+    object_pool<Message> pool;
+    shared_ptr<Message> first = pool.acquire();
+    EXPECT_EQ(first.use_count(), 1);
+    Message *raw = first.get();
+    first->value = 7;
+    first.reset();
+
+    // The object went back untouched, without being destroyed
+    EXPECT_EQ(Message::destructor_count, 0);
+    shared_ptr<Message> second = pool.acquire();
+    EXPECT_EQ(second.get(), raw);
+    EXPECT_EQ(second->value, 7);
+    EXPECT_EQ(second.use_count(), 1);
+    EXPECT_EQ(Message::constructor_count, 1);
+
+    const object_pool_stats stats = pool.stats();
+    EXPECT_EQ(stats.hits, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.in_use, 1u);
+    EXPECT_EQ(stats.cached, 0u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.5);
+}
+
+TEST_F(ObjectPoolTest, ResetHookRunsOnLastRelease) {
+    object_pool<Message, ClearMessage> pool;
+    shared_ptr<Message> message = pool.acquire();
+    message->value = 3;
+    message->payload.assign(64, 'x');
+    const std::size_t capacity = message->payload.capacity();
+
+    shared_ptr<Message> copy = message;
+    message.reset();
+    EXPECT_EQ(copy->value, 3);
+    copy.reset();
+
+    shared_ptr<Message> reused = pool.acquire();
+    EXPECT_EQ(reused->value, 0);
+    EXPECT_TRUE(reused->payload.empty());
+    // The buffer is kept, which is the point of recycling it
+    EXPECT_EQ(reused->payload.capacity(), capacity);
+}
+
+TEST_F(ObjectPoolTest, WeakPtrDelaysRecycling) {
+    object_pool<Message> pool;
+    shared_ptr<Message> message = pool.acquire();
+    weak_ptr<Message> observer = message;
+    message.reset();
+
+    EXPECT_TRUE(observer.expired());
+    EXPECT_FALSE(observer.lock());
+    EXPECT_EQ(pool.stats().cached, 0u);
+    EXPECT_EQ(pool.stats().in_use, 1u);
+
+    observer.reset();
+    EXPECT_EQ(pool.stats().cached, 1u);
+    EXPECT_EQ(pool.stats().in_use, 0u);
+
+    // A recycled block makes a working weak_ptr again
+    shared_ptr<Message> reused = pool.acquire();
+    weak_ptr<Message> again = reused;
+    EXPECT_EQ(again.lock(), reused);
+}
+
+TEST_F(ObjectPoolTest, HighWaterMark) {
+    object_pool<Message> pool;
+    {
+        std::vector<shared_ptr<Message>> batch;
+        for (int i = 0; i < 5; ++i) {
+            batch.push_back(pool.acquire());
+        }
+        EXPECT_EQ(pool.stats().in_use, 5u);
+    }
+    shared_ptr<Message> one = pool.acquire();
+    const object_pool_stats stats = pool.stats();
+    EXPECT_EQ(stats.in_use, 1u);
+    EXPECT_EQ(stats.high_water_mark, 5u);
+    EXPECT_EQ(stats.cached, 4u);
+    EXPECT_EQ(Message::constructor_count, 5);
+}
+
+TEST_F(ObjectPoolTest, CacheIsCapped) {
+    object_pool<Message> pool(no_reset(), 2);
+    {
+        std::vector<shared_ptr<Message>> batch;
+        for (int i = 0; i < 5; ++i) {
+            batch.push_back(pool.acquire());
+        }
+    }
+    EXPECT_EQ(pool.stats().cached, 2u);
+    EXPECT_EQ(Message::destructor_count, 3);
+}
+
+// ============================================================================
+// POOL LIFETIME
+// ============================================================================
+
+TEST_F(ObjectPoolTest, HandlesOutliveThePool) {
+    shared_ptr<Message> survivor;
+    {
+        object_pool<Message> pool;
+        survivor = pool.acquire();
+        pool.acquire().reset();
+        EXPECT_EQ(pool.stats().cached, 1u);
+    }
+    // The cached object went with the pool; the one in use is still valid
+    EXPECT_EQ(Message::destructor_count, 1);
+    survivor->value = 1;
+    survivor.reset();
+    EXPECT_EQ(Message::destructor_count, 2);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(ObjectPoolTest, ConcurrentAcquireAndRelease) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 2000;
+    object_pool<Message, ClearMessage> pool;
+    std::latch start(k_threads);
+
+    std::vector<shared_ptr<Message>> parked(k_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&, t] {
+            start.arrive_and_wait();
+            for (int i = 0; i < k_rounds; ++i) {
+                shared_ptr<Message> message = pool.acquire();
+                EXPECT_EQ(message->value, 0);
+                message->value = i + 1;
+                // Park some objects; the last ones parked are released by
+                // the main thread, away from the shard they came from
+                if (i % 4 == 0) {
+                    parked[static_cast<std::size_t>(t)] = message;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    parked.clear();
+
+    const object_pool_stats stats = pool.stats();
+    EXPECT_EQ(stats.in_use, 0u);
+    EXPECT_EQ(stats.hits + stats.misses, std::size_t{k_threads * k_rounds});
+    EXPECT_LE(stats.high_water_mark, std::size_t{2 * k_threads});
+    EXPECT_EQ(stats.cached, stats.misses);
+}
+
+} // namespace ksl
@@ -0,0 +1 @@
+#include <relocate.h>
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+/// Whether a T can be moved to another address by copying its bytes, the
+/// original then being treated as gone without running its destructor.
+/// Otherwise relocating is a move followed by destroying the source: for
+/// a smart pointer, copying its pointers, nulling the source's and testing
+/// them again in its destructor, where copying the bytes would do.
+///
+/// True of trivially copyable types. Specialize it to true for a type
+/// whose value does not depend on its own address: no pointer into
+/// itself, and nothing outside keeping its address.
+template <typename T>
+struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+template <typename T>
+struct is_trivially_relocatable<const T> : is_trivially_relocatable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+/// Moves the objects of [first, last) into the uninitialized storage at
+/// dest and ends their lifetime, returning dest past the last one. The
+/// ranges may not overlap. Trivially relocatable objects are copied with
+/// one memcpy; others are moved, or copied if their move may throw, and
+/// destroyed. If that throws, the objects made so far are destroyed and
+/// the source is left in place: as it was if it was being copied.
+template <typename T> T *relocate(T *first, T *last, T *dest) {
+    static_assert(!std::is_const_v<T>, "cannot relocate out of const objects");
+    if constexpr (is_trivially_relocatable_v<T>) {
+        const auto count = static_cast<std::size_t>(last - first);
+        if (count != 0) {
+            std::memcpy(static_cast<void *>(dest), static_cast<const void *>(first),
+                        count * sizeof(T));
+        }
+        return dest + count;
+    } else {
+        T *end = dest;
+        try {
+            for (T *it = first; it != last; ++it, ++end) {
+                if constexpr (std::is_nothrow_move_constructible_v<T> ||
+                              !std::is_copy_constructible_v<T>) {
+                    std::construct_at(end, std::move(*it));
+                } else {
+                    std::construct_at(end, std::as_const(*it));
+                }
+            }
+        } catch (...) {
+            std::destroy(dest, end);
+            throw;
+        }
+        std::destroy(first, last);
+        return end;
+    }
+}
+
+} // namespace ksl
@@ -0,0 +1,161 @@
+// Component being tested
+#include <relocate.h>
+
+#include <cow.h>
+#include <intrusive_ptr.h>
+#include <local_shared_ptr.h>
+#include <scalable_shared_ptr.h>
+#include <shared_ptr.h>
+#include <unique_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace ksl {
+
+class RelocateTest : public ::testing::Test {
+  protected:
+    /// Counts the special members relocate() runs.
+    struct Tracked {
+        int value;
+        static int moves;
+        static int copies;
+        static int destructions;
+
+        explicit Tracked(int v) : value(v) {}
+        Tracked(Tracked &&other) noexcept : value(other.value) { moves++; }
+        Tracked(const Tracked &other) : value(other.value) { copies++; }
+        ~Tracked() { destructions++; }
+    };
+
+    /// Copyable only: its copy throws on the given call.
+    struct ThrowingCopy {
+        int value;
+        static int copies;
+        static int throw_on;
+
+        explicit ThrowingCopy(int v) : value(v) {}
+        ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+            if (++copies == throw_on) {
+                throw std::runtime_error("copy failed");
+            }
+        }
+    };
+
+    void SetUp() override {
+        Tracked::moves = 0;
+        Tracked::copies = 0;
+        Tracked::destructions = 0;
+        ThrowingCopy::copies = 0;
+        ThrowingCopy::throw_on = 0;
+    }
+};
+
+int RelocateTest::Tracked::moves = 0;
+int RelocateTest::Tracked::copies = 0;
+int RelocateTest::Tracked::destructions = 0;
+int RelocateTest::ThrowingCopy::copies = 0;
+int RelocateTest::ThrowingCopy::throw_on = 0;
+
+struct Node : intrusive_ref_counter<Node> {};
+
+// ============================================================================
+// TRAIT
+// ============================================================================
+
+TEST_F(RelocateTest, TraitDefaultsToTriviallyCopyable) {
+    static_assert(is_trivially_relocatable_v<int>);
+    static_assert(is_trivially_relocatable_v<int *>);
+    static_assert(!is_trivially_relocatable_v<std::string>);
+    static_assert(!is_trivially_relocatable_v<Tracked>);
+    static_assert(!is_trivially_relocatable_v<std::shared_ptr<int>>);
+}
+
+TEST_F(RelocateTest, HandlesOptIn) {
+    static_assert(is_trivially_relocatable_v<shared_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<const shared_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<weak_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<shared_ptr<int[]>>);
+    static_assert(is_trivially_relocatable_v<unique_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<unique_ptr<int[]>>);
+    static_assert(is_trivially_relocatable_v<intrusive_ptr<Node>>);
+    static_assert(is_trivially_relocatable_v<local_shared_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<local_weak_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<scalable_shared_ptr<int>>);
+    static_assert(is_trivially_relocatable_v<cow<std::string>>);
+}
+
+TEST_F(RelocateTest, UniquePtrFollowsItsDeleter) {
+    using function_deleter = std::function<void(int *)>;
+    static_assert(!is_trivially_relocatable_v<unique_ptr<int, function_deleter>>);
+    static_assert(is_trivially_relocatable_v<unique_ptr<int, function_deleter &>>);
+    static_assert(is_trivially_relocatable_v<unique_ptr<int, void (*)(int *)>>);
+}
+
+// ============================================================================
+// RELOCATE
+// ============================================================================
+
+TEST_F(RelocateTest, TriviallyRelocatableHandlesKeepTheirCounts) {
+    shared_ptr<int> source = make_shared<int>(3);
+    alignas(shared_ptr<int>) unsigned char from[3 * sizeof(shared_ptr<int>)];
+    alignas(shared_ptr<int>) unsigned char to[3 * sizeof(shared_ptr<int>)];
+    auto *first = reinterpret_cast<shared_ptr<int> *>(from);
+    for (int i = 0; i < 3; ++i) {
+        std::construct_at(first + i, source);
+    }
+    EXPECT_EQ(source.use_count(), 4);
+
+    auto *dest = reinterpret_cast<shared_ptr<int> *>(to);
+    EXPECT_EQ(relocate(first, first + 3, dest), dest + 3);
+    // Nothing was copied or released: the three references moved over
+    EXPECT_EQ(source.use_count(), 4);
+    EXPECT_EQ(dest[2], source);
+    std::destroy(dest, dest + 3);
+    EXPECT_EQ(source.use_count(), 1);
+}
+
+TEST_F(RelocateTest, OthersAreMovedAndDestroyed) {
+    std::allocator<Tracked> alloc;
+    Tracked *first = alloc.allocate(4);
+    Tracked *dest = alloc.allocate(4);
+    for (int i = 0; i < 4; ++i) {
+        std::construct_at(first + i, i);
+    }
+
+    relocate(first, first + 4, dest);
+    EXPECT_EQ(Tracked::moves, 4);
+    EXPECT_EQ(Tracked::copies, 0);
+    EXPECT_EQ(Tracked::destructions, 4);
+    EXPECT_EQ(dest[3].value, 3);
+
+    std::destroy(dest, dest + 4);
+    alloc.deallocate(first, 4);
+    alloc.deallocate(dest, 4);
+}
+
+TEST_F(RelocateTest, ThrowingCopyLeavesTheSource) {
+    std::allocator<ThrowingCopy> alloc;
+    ThrowingCopy *first = alloc.allocate(4);
+    ThrowingCopy *dest = alloc.allocate(4);
+    for (int i = 0; i < 4; ++i) {
+        std::construct_at(first + i, i);
+    }
+
+    ThrowingCopy::throw_on = 3;
+    EXPECT_THROW(relocate(first, first + 4, dest), std::runtime_error);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(first[i].value, i);
+    }
+
+    std::destroy(first, first + 4);
+    alloc.deallocate(first, 4);
+    alloc.deallocate(dest, 4);
+}
+
+} // namespace ksl
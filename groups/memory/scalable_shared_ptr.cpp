@@ -0,0 +1,12 @@
+#include <scalable_shared_ptr.h>
+
+namespace ksl {
+
+unsigned scalable_shard::assign() noexcept {
+    static std::atomic<unsigned> s_next{0};
+    const unsigned index = s_next.fetch_add(1, std::memory_order_relaxed) % k_count;
+    s_thread_index = index;
+    return index;
+}
+
+} // namespace ksl
\ No newline at end of file
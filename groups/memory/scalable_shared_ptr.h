@@ -0,0 +1,247 @@
+#pragma once
+
+#include <relocate.h>
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// SHARD ASSIGNMENT
+// ============================================================================
+
+/// Maps threads to the counter shards of scalable control blocks.
+class scalable_shard {
+  public:
+    /// Shards per control block. Threads beyond this share shards, so the
+    /// count bounds the contention per cache line, not the thread count.
+    static constexpr unsigned k_count = 16;
+
+    /// Size every shard is padded to, so two shards never share a line.
+    static constexpr std::size_t k_cache_line = 64;
+
+    /// The calling thread's shard. Threads are assigned shards round-robin
+    /// on first use.
+    [[nodiscard]] static unsigned current() noexcept {
+        const unsigned index = s_thread_index;
+        return index != k_unassigned ? index : assign();
+    }
+
+  private:
+    static constexpr unsigned k_unassigned = ~0u;
+
+    static unsigned assign() noexcept;
+
+    static inline thread_local unsigned s_thread_index = k_unassigned;
+};
+
+namespace {
+/// Shared count split over scalable_shard::k_count cache lines, plus a
+/// central count of the shards in use.
+///
+/// A copy increments the copying thread's shard, which no other thread
+/// writes as long as there are no more threads than shards. The central
+/// count is only touched when a shard goes from zero to non-zero or back,
+/// so handles copied and dropped on one thread never leave its shard's
+/// line. The block is destroyed when the central count reaches zero.
+///
+/// A shard only goes from zero to one after the central count has been
+/// incremented for it. Every later increment of that shard is a CAS from
+/// a non-zero value, so no thread can see a non-zero shard whose central
+/// reference is still missing.
+struct scalable_control_block_base {
+    struct alignas(scalable_shard::k_cache_line) shard {
+        std::atomic<std::size_t> d_count{0};
+    };
+
+    shard d_shards[scalable_shard::k_count];
+    alignas(scalable_shard::k_cache_line) std::atomic<std::size_t> d_central{1};
+
+    /// Starts with one reference on the creating thread's shard.
+    explicit scalable_control_block_base(unsigned shard_index) noexcept {
+        d_shards[shard_index].d_count.store(1, std::memory_order_relaxed);
+    }
+
+    /// Takes a reference on shard_index. The caller holds a reference,
+    /// possibly on another shard, so the object cannot go away meanwhile.
+    inline void increment(unsigned shard_index) noexcept {
+        std::atomic<std::size_t> &count = d_shards[shard_index].d_count;
+        std::size_t current = count.load(std::memory_order_relaxed);
+        // Fast path: the shard already holds a central reference. Acquire
+        // orders the central increment of whoever revived the shard before
+        // this reference, and so before any release it enables.
+        while (current != 0) {
+            if (count.compare_exchange_weak(current, current + 1, std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+                return;
+            }
+        }
+        // Slow path: take a central reference first, give it back if
+        // another thread revived the shard in the meantime
+        d_central.fetch_add(1, std::memory_order_relaxed);
+        if (count.fetch_add(1, std::memory_order_acq_rel) != 0) {
+            d_central.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Drops a reference on shard_index, destroying the block if it was
+    /// the last reference anywhere.
+    inline void release(unsigned shard_index) noexcept {
+        if (d_shards[shard_index].d_count.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+            d_central.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            destroy();
+        }
+    }
+
+    /// Sum of the shards. Exact only when no other thread is copying or
+    /// releasing.
+    [[nodiscard]] std::size_t use_count() const noexcept {
+        std::size_t total = 0;
+        for (const shard &s : d_shards) {
+            total += s.d_count.load(std::memory_order_acquire);
+        }
+        return total;
+    }
+
+    virtual void destroy() noexcept = 0;
+    virtual ~scalable_control_block_base() = default;
+};
+
+/// Object and counters in a single allocation.
+template <typename T> struct scalable_control_block_impl : public scalable_control_block_base {
+    alignas(T) char d_storage[sizeof(T)];
+
+    template <typename... Args>
+    explicit scalable_control_block_impl(unsigned shard_index, Args &&...args)
+        : scalable_control_block_base(shard_index) {
+        new (d_storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy() noexcept override {
+        reinterpret_cast<T *>(d_storage)->~T();
+        delete this;
+    }
+};
+} // namespace
+
+// ============================================================================
+// SCALABLE SHARED POINTER DEFINITION
+// ============================================================================
+
+/// Shared ownership for objects that very many threads copy at once, such
+/// as a global configuration. Each handle counts on the shard of the thread
+/// that created it, so copies made on different threads do not write to
+/// the same cache line. A control block costs k_count cache lines, and
+/// there is no weak_ptr: use it for hot objects only, and
+/// ksl::shared_ptr everywhere else.
+///
+/// Handles can be moved and released on any thread; a handle keeps
+/// counting on the shard it was created on.
+template <typename T> class scalable_shared_ptr {
+    T *d_ptr;
+    scalable_control_block_base *d_cb;
+    unsigned d_shard;
+
+    scalable_shared_ptr(T *ptr, scalable_control_block_base *cb, unsigned shard) noexcept
+        : d_ptr(ptr), d_cb(cb), d_shard(shard) {}
+
+  public:
+    using Value_Type = T;
+
+  public:
+    /// CONSTRUCTORS
+    constexpr scalable_shared_ptr() noexcept : d_ptr(nullptr), d_cb(nullptr), d_shard(0) {}
+
+    constexpr scalable_shared_ptr(std::nullptr_t) noexcept : scalable_shared_ptr() {}
+
+    /// Takes a reference on the calling thread's shard.
+    scalable_shared_ptr(const scalable_shared_ptr &rhs) noexcept
+        : d_ptr(rhs.d_ptr), d_cb(rhs.d_cb), d_shard(scalable_shard::current()) {
+        if (d_cb) {
+            d_cb->increment(d_shard);
+        }
+    }
+
+    scalable_shared_ptr(scalable_shared_ptr &&rhs) noexcept
+        : d_ptr(std::exchange(rhs.d_ptr, nullptr)), d_cb(std::exchange(rhs.d_cb, nullptr)),
+          d_shard(rhs.d_shard) {}
+
+    /// DESTRUCTORS
+    ~scalable_shared_ptr() {
+        if (d_cb) {
+            d_cb->release(d_shard);
+        }
+    }
+
+    /// ASSIGNMENT
+    scalable_shared_ptr &operator=(const scalable_shared_ptr &rhs) noexcept {
+        scalable_shared_ptr(rhs).swap(*this);
+        return *this;
+    }
+
+    scalable_shared_ptr &operator=(scalable_shared_ptr &&rhs) noexcept {
+        scalable_shared_ptr(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+  public:
+    // ACCESSORS
+    [[nodiscard]] inline T *get() const noexcept { return d_ptr; }
+
+    [[nodiscard]] T &operator*() const noexcept {
+        assert(d_ptr != nullptr && "Attempted to dereference a null scalable_shared_ptr");
+        return *(get());
+    }
+
+    [[nodiscard]] T *operator->() const noexcept { return get(); }
+
+    [[nodiscard]] operator bool() const noexcept { return get() != nullptr; };
+
+  public:
+    // OBSERVERS
+    /// Sums every shard, so it is slower than shared_ptr::use_count() and
+    /// only a snapshot while other threads copy or release.
+    [[nodiscard]] inline std::size_t use_count() const noexcept {
+        if (d_cb) {
+            return d_cb->use_count();
+        }
+        return 0;
+    }
+
+  public:
+    // MODIFIERS
+    inline void reset() noexcept { scalable_shared_ptr().swap(*this); }
+
+    inline void swap(scalable_shared_ptr &ptr) noexcept {
+        std::swap(d_ptr, ptr.d_ptr);
+        std::swap(d_cb, ptr.d_cb);
+        std::swap(d_shard, ptr.d_shard);
+    }
+
+  public:
+    // Friend
+    template <typename Y, typename... Args>
+    friend scalable_shared_ptr<Y> make_shared_scalable(Args &&...args);
+};
+
+// ============================================================================
+// MAKE_SHARED_SCALABLE IMPLEMENTATION
+// ============================================================================
+
+/// Creates the object and its sharded control block in a single allocation.
+template <typename Y, typename... Args>
+scalable_shared_ptr<Y> make_shared_scalable(Args &&...args) {
+    const unsigned shard = scalable_shard::current();
+    auto *cb = new scalable_control_block_impl<Y>(shard, std::forward<Args>(args)...);
+    return scalable_shared_ptr<Y>(reinterpret_cast<Y *>(cb->d_storage), cb, shard);
+}
+
+/// The shard index is a number, not a pointer back into the handle.
+template <typename T> struct is_trivially_relocatable<scalable_shared_ptr<T>> : std::true_type {};
+
+} // namespace ksl
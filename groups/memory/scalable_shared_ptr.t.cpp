@@ -0,0 +1,166 @@
+// Component being tested
+#include <scalable_shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <latch>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class ScalableSharedPtrTest : public ::testing::Test {
+  protected:
+    struct Derived {
+        int value;
+        static std::atomic<int> destructor_count;
+
+        explicit Derived(int v = 42) : value(v) {}
+        ~Derived() { destructor_count++; }
+    };
+};
+
+std::atomic<int> ScalableSharedPtrTest::Derived::destructor_count = 0;
+
+// ============================================================================
+// CONSTRUCTORS
+// ============================================================================
+
+TEST_F(ScalableSharedPtrTest, DefaultAndNullptrConstructors) {
+    scalable_shared_ptr<Derived> empty;
+    scalable_shared_ptr<Derived> null(nullptr);
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(null.get(), nullptr);
+    EXPECT_EQ(empty.use_count(), 0u);
+    static_assert(std::is_same_v<scalable_shared_ptr<Derived>::Value_Type, Derived>);
+}
+
+TEST_F(ScalableSharedPtrTest, MakeSharedScalable) {
+    Derived::destructor_count = 0;
+    {
+        scalable_shared_ptr<Derived> ptr = make_shared_scalable<Derived>(5);
+        EXPECT_EQ(ptr->value, 5);
+        EXPECT_EQ((*ptr).value, 5);
+        EXPECT_EQ(ptr.use_count(), 1u);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(ScalableSharedPtrTest, CopyMoveAndAssignment) {
+    Derived::destructor_count = 0;
+    {
+        scalable_shared_ptr<Derived> ptr = make_shared_scalable<Derived>(1);
+        scalable_shared_ptr<Derived> copy(ptr);
+        EXPECT_EQ(copy.get(), ptr.get());
+        EXPECT_EQ(ptr.use_count(), 2u);
+
+        scalable_shared_ptr<Derived> moved(std::move(copy));
+        EXPECT_FALSE(copy);
+        EXPECT_EQ(ptr.use_count(), 2u);
+
+        scalable_shared_ptr<Derived> other = make_shared_scalable<Derived>(2);
+        other = ptr;
+        EXPECT_EQ(Derived::destructor_count, 1);
+        EXPECT_EQ(ptr.use_count(), 3u);
+
+        other = std::move(moved);
+        EXPECT_EQ(ptr.use_count(), 2u);
+
+        other.reset();
+        EXPECT_EQ(ptr.use_count(), 1u);
+    }
+    EXPECT_EQ(Derived::destructor_count, 2);
+}
+
+TEST_F(ScalableSharedPtrTest, Swap) {
+    scalable_shared_ptr<Derived> first = make_shared_scalable<Derived>(1);
+    scalable_shared_ptr<Derived> second = make_shared_scalable<Derived>(2);
+    first.swap(second);
+    EXPECT_EQ(first->value, 2);
+    EXPECT_EQ(second->value, 1);
+}
+
+// ============================================================================
+// SHARDING
+// ============================================================================
+
+TEST_F(ScalableSharedPtrTest, ShardsDoNotShareCacheLines) {
+    static_assert(sizeof(scalable_control_block_base::shard) == scalable_shard::k_cache_line);
+    EXPECT_LT(scalable_shard::current(), scalable_shard::k_count);
+    EXPECT_EQ(scalable_shard::current(), scalable_shard::current());
+}
+
+TEST_F(ScalableSharedPtrTest, HandlesMovedAcrossThreads) {
+    // A handle released on another thread decrements the shard it was
+    // created on, and the last release on any shard destroys the object.
+    Derived::destructor_count = 0;
+    scalable_shared_ptr<Derived> ptr = make_shared_scalable<Derived>(3);
+    std::vector<scalable_shared_ptr<Derived>> copies;
+    for (unsigned i = 0; i < 2 * scalable_shard::k_count; ++i) {
+        std::thread([&ptr, &copies] { copies.push_back(ptr); }).join();
+    }
+    EXPECT_EQ(ptr.use_count(), 2 * scalable_shard::k_count + 1);
+
+    std::thread([moved = std::move(ptr)]() mutable { moved.reset(); }).join();
+    EXPECT_EQ(Derived::destructor_count, 0);
+    copies.clear();
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(ScalableSharedPtrTest, ConcurrentCopyAndRelease) {
+    constexpr int k_threads = 8;
+    constexpr int k_rounds = 2000;
+    Derived::destructor_count = 0;
+    {
+        scalable_shared_ptr<Derived> ptr = make_shared_scalable<Derived>(1);
+        std::latch start(k_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < k_threads; ++t) {
+            threads.emplace_back([&] {
+                start.arrive_and_wait();
+                for (int i = 0; i < k_rounds; ++i) {
+                    scalable_shared_ptr<Derived> copy(ptr);
+                    scalable_shared_ptr<Derived> again(copy);
+                    EXPECT_EQ(again->value, 1);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(ptr.use_count(), 1u);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(ScalableSharedPtrTest, ConcurrentLastOwnerRelease) {
+    // Each round hands one copy to every thread and drops the original, so
+    // the last release can happen on any shard.
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 500;
+    Derived::destructor_count = 0;
+    for (int round = 0; round < k_rounds; ++round) {
+        scalable_shared_ptr<Derived> ptr = make_shared_scalable<Derived>(round);
+        std::latch start(k_threads);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < k_threads; ++t) {
+            threads.emplace_back([&start, copy = ptr]() mutable {
+                start.arrive_and_wait();
+                scalable_shared_ptr<Derived> local(copy);
+                copy.reset();
+            });
+        }
+        ptr.reset();
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(Derived::destructor_count, k_rounds);
+}
+
+} // namespace ksl
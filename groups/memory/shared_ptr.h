@@ -1,49 +1,519 @@
 #pragma once
 
+#include <control_block_pool.h>
+#include <memory_trace.h>
+#include <numa_arena.h>
+#include <relocate.h>
+#include <scalable_shared_ptr.h>
+#include <unique_ptr.h>
+
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <compare>
 #include <cstddef>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <type_traits>
 #include <utility>
 
 namespace ksl {
+
+/// Memory held by control blocks whose object has expired while weak_ptrs
+/// still refer to them, summed over every such block.
+struct weak_retention_stats {
+    /// Blocks kept alive only by weak references.
+    std::size_t blocks;
+    /// Bytes those blocks occupy, including any object storage inline in
+    /// them.
+    std::size_t bytes;
+};
+
+/// Process-wide weak_retention_stats. A block is counted from the release
+/// of its last shared owner to the release of its last weak_ptr; blocks
+/// without weak_ptrs at that point are never touched. The counters are
+/// striped over scalable_shard's shards, each on its own cache line, so
+/// threads expiring weakly referenced objects at once, as a weak_cache
+/// does, mostly write lines of their own; stats() sums the shards.
+///
+/// A block may be counted on one shard and uncounted on another, so a
+/// single shard's counters can wrap below zero; only their sums mean
+/// anything.
+class weak_retention {
+  public:
+    [[nodiscard]] static weak_retention_stats stats() noexcept {
+        weak_retention_stats total{0, 0};
+        for (const shard &counters : s_shards) {
+            total.blocks += counters.d_blocks.load(std::memory_order_relaxed);
+            total.bytes += counters.d_bytes.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    static void pin(std::size_t bytes) noexcept {
+        shard &local = s_shards[scalable_shard::current()];
+        local.d_blocks.fetch_add(1, std::memory_order_relaxed);
+        local.d_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    static void unpin(std::size_t bytes) noexcept {
+        shard &local = s_shards[scalable_shard::current()];
+        local.d_blocks.fetch_sub(1, std::memory_order_relaxed);
+        local.d_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+
+  private:
+    /// Counters of the threads mapped to one shard. Both are written
+    /// together by the same thread, so they share its line. std::atomic
+    /// value-initializes, so both start at zero.
+    struct alignas(scalable_shard::k_cache_line) shard {
+        std::atomic<std::size_t> d_blocks;
+        std::atomic<std::size_t> d_bytes;
+    };
+
+    static inline shard s_shards[scalable_shard::k_count];
+};
+
 namespace {
 // Callable deleter concepts
 template <typename T, typename D>
 concept CallableDeleter = requires(T *ptr, D del) { del(ptr); };
 
+/// A handle to Y can be converted to a handle to T: derived to base, adding
+/// cv-qualifiers, or U[N] to U[].
+template <typename Y, typename T>
+concept CompatiblePointer = std::is_convertible_v<Y *, T *> ||
+                            (std::is_bounded_array_v<Y> && std::is_unbounded_array_v<T> &&
+                             std::is_convertible_v<std::remove_extent_t<Y> (*)[],
+                                                   std::remove_extent_t<T> (*)[]>);
+
+/// Types with an unambiguous, accessible enable_shared_from_this base.
+template <typename T>
+concept EnablesSharedFromThis = requires { typename T::esft_type; } &&
+                                std::is_convertible_v<T *, typename T::esft_type *>;
+
+/// Reference counts shared by every control block. The counters are plain
+/// inline operations so copying a handle never goes through the vtable;
+/// only disposing of the managed object and destroying the block are
+/// dispatched virtually.
+///
+/// A block is created owned by exactly one shared_ptr. While any shared
+/// owner exists they collectively hold one extra weak reference, so the
+/// thread whose decrement takes a counter to zero is the only one that
+/// disposes of the object or deletes the block.
+///
+/// Increments are relaxed: a new reference can only be made from an
+/// existing one, so there is nothing to synchronize with. Decrements are
+/// acq_rel so every owner's writes to the object happen before dispose().
 struct control_block_base {
-    std::atomic<size_t> d_shared_count{0};
-    std::atomic<size_t> d_weak_count{0};
-    virtual void increment_shared_count() { ++d_shared_count; };
-    virtual void decrement_shared_count() { --d_shared_count; };
-    virtual size_t shared_count() { return d_shared_count; };
-    virtual void increment_weak_count() { ++d_weak_count; };
-    virtual void decrement_weak_count() { --d_weak_count; };
-    virtual size_t weak_count() { return d_weak_count; };
-    virtual void dispose() = 0;
-    virtual ~control_block_base() = default;
+    std::atomic<size_t> d_shared_count{1};
+    std::atomic<size_t> d_weak_count{1};
+
+    control_block_base() noexcept {
+        KSL_MEMORY_TRACE_BLOCK_CREATED(this, &d_shared_count, &d_weak_count);
+    }
+
+    inline void increment_shared_count() noexcept {
+        KSL_MEMORY_TRACE_COPY();
+        d_shared_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Takes count shared references with one increment.
+    inline void increment_shared_count(std::size_t count) noexcept {
+        KSL_MEMORY_TRACE_COPIES(count);
+        d_shared_count.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    /// Takes a shared reference unless the object has already expired.
+    /// Returns false if the shared count was zero.
+    [[nodiscard]] inline bool increment_shared_count_if_not_zero() noexcept {
+        size_t count = d_shared_count.load(std::memory_order_relaxed);
+        do {
+            if (count == 0) {
+                KSL_MEMORY_TRACE_LOCK(false);
+                return false;
+            }
+        } while (!d_shared_count.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel,
+                                                       std::memory_order_relaxed));
+        KSL_MEMORY_TRACE_LOCK(true);
+        return true;
+    }
+
+    /// Drops a shared reference, disposing of the object and dropping the
+    /// owners' weak reference if it was the last one. A block that takes
+    /// the reference over in dispose() drops it itself later.
+    inline void release_shared() noexcept {
+        if (d_shared_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (dispose()) {
+                release_owners_weak();
+            }
+        }
+    }
+
+    /// Drops count shared references, which the caller holds, with one
+    /// decrement.
+    inline void release_shared(std::size_t count) noexcept {
+        if (d_shared_count.fetch_sub(count, std::memory_order_acq_rel) == count) {
+            if (dispose()) {
+                release_owners_weak();
+            }
+        }
+    }
+
+    /// Drops the owners' weak reference once the object is disposed of.
+    /// With no weak_ptr left none can be made any more, so the block goes
+    /// without another atomic write. Otherwise it is counted in
+    /// weak_retention until the last weak_ptr releases it.
+    inline void release_owners_weak() noexcept {
+        if (d_weak_count.load(std::memory_order_acquire) == 1) {
+            destroy();
+            return;
+        }
+        const std::size_t bytes = retained_bytes();
+        weak_retention::pin(bytes);
+        if (d_weak_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            weak_retention::unpin(bytes);
+            destroy();
+        }
+    }
+
+    [[nodiscard]] inline size_t shared_count() const noexcept {
+        return d_shared_count.load(std::memory_order_acquire);
+    }
+
+    inline void increment_weak_count() noexcept {
+        d_weak_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /// Drops a weak_ptr's reference, destroying the block if it was the
+    /// last one. The owners' reference is gone by then, so the block was
+    /// counted in weak_retention.
+    inline void release_weak() noexcept {
+        if (d_weak_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            weak_retention::unpin(retained_bytes());
+            destroy();
+        }
+    }
+
+    /// Number of weak references, including the one held by the shared
+    /// owners while the object is alive.
+    [[nodiscard]] inline size_t weak_count() const noexcept {
+        return d_weak_count.load(std::memory_order_acquire);
+    }
+
+    /// Destroys the managed object and returns true. A block that destroys
+    /// it later instead returns false, keeping the owners' weak reference
+    /// until then and dropping it with release_owners_weak().
+    virtual bool dispose() = 0;
+
+    /// Destroys and frees the block itself, with the allocator it came from.
+    virtual void destroy() noexcept = 0;
+
+    /// Bytes the block keeps allocated after dispose().
+    [[nodiscard]] virtual std::size_t retained_bytes() const noexcept = 0;
+
+    virtual ~control_block_base() { KSL_MEMORY_TRACE_BLOCK_DESTROYED(this); }
 };
 
-template <typename T, typename Deleter = std::default_delete<T>>
+/// Allocates and constructs a control block of type Block with a copy of
+/// alloc rebound to Block.
+template <typename Block, typename Alloc, typename... Args>
+Block *allocate_control_block(const Alloc &alloc, Args &&...args) {
+    using block_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+    using block_traits = std::allocator_traits<block_alloc>;
+
+    block_alloc cb_alloc(alloc);
+    Block *cb = block_traits::allocate(cb_alloc, 1);
+    try {
+        block_traits::construct(cb_alloc, cb, std::forward<Args>(args)...);
+    } catch (...) {
+        block_traits::deallocate(cb_alloc, cb, 1);
+        throw;
+    }
+    return cb;
+}
+
+/// Destroys a control block created by allocate_control_block. The block's
+/// allocator is copied out first since it lives inside the block.
+template <typename Block, typename Alloc> void deallocate_control_block(Block *cb) noexcept {
+    using block_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+    using block_traits = std::allocator_traits<block_alloc>;
+
+    block_alloc cb_alloc(cb->d_alloc);
+    block_traits::destroy(cb_alloc, cb);
+    block_traits::deallocate(cb_alloc, cb, 1);
+}
+
+/// Stateless deleters (std::default_delete, capture-less lambdas) and
+/// allocators take no space in the block.
+template <typename T, typename Deleter = std::default_delete<T>,
+          typename Alloc = std::allocator<T>>
 struct control_block_impl : public control_block_base {
     T *d_ptr;
-    Deleter d_deleter;
+    [[no_unique_address]] Deleter d_deleter;
+    [[no_unique_address]] Alloc d_alloc;
+
+    control_block_impl(T *ptr, Deleter &&deleter, const Alloc &alloc = Alloc())
+        : d_ptr(ptr), d_deleter(std::move(deleter)), d_alloc(alloc) {}
+    bool dispose() override {
+        d_deleter(d_ptr);
+        return true;
+    }
+    void destroy() noexcept override {
+        deallocate_control_block<control_block_impl, Alloc>(this);
+    }
+    std::size_t retained_bytes() const noexcept override { return sizeof(*this); }
+};
+
+/// Compact block for shared_ptr(new T): no deleter is stored at all, so the
+/// block is the base counters plus the owned pointer.
+template <typename T, typename Alloc>
+struct control_block_impl<T, std::default_delete<T>, Alloc> : public control_block_base {
+    T *d_ptr;
+    [[no_unique_address]] Alloc d_alloc;
+
+    control_block_impl(T *ptr, std::default_delete<T>, const Alloc &alloc = Alloc())
+        : d_ptr(ptr), d_alloc(alloc) {}
+    bool dispose() override {
+        delete d_ptr;
+        return true;
+    }
+    void destroy() noexcept override {
+        deallocate_control_block<control_block_impl, Alloc>(this);
+    }
+    std::size_t retained_bytes() const noexcept override { return sizeof(*this); }
+};
+
+/// Tag selecting default-initialization of the object, for
+/// make_shared_for_overwrite.
+struct for_overwrite_t {
+    explicit for_overwrite_t() = default;
+};
+
+/// Tag selecting a make_shared block whose object starts on a cache line of
+/// its own, after the counters and the vptr. Writes to a frequently
+/// modified object then stop invalidating the line other threads copy and
+/// release handles on, at the cost of up to two extra lines per block.
+struct padded_layout_t {
+    explicit padded_layout_t() = default;
 
-    control_block_impl(T *ptr, Deleter deleter) : d_ptr(ptr), d_deleter(deleter) {}
-    void dispose() override { d_deleter(d_ptr); }
+    /// Line size the object is aligned to. The block's size is rounded up
+    /// to it too, so the object's last line holds nothing else either.
+    static constexpr std::size_t k_cache_line = 64;
 };
 
-template <typename T> struct control_block_make_shared_impl : public control_block_base {
-    alignas(T) char d_storage[sizeof(T)];
+inline constexpr padded_layout_t padded_layout{};
 
-    template <typename... Args> control_block_make_shared_impl(Args &&...args) {
+/// The object is stored inline after the counters. Align is raised above
+/// alignof(T) for padded_layout_t blocks.
+template <typename T, typename Alloc = std::allocator<T>, std::size_t Align = alignof(T)>
+struct control_block_make_shared_impl : public control_block_base {
+    alignas(Align) char d_storage[sizeof(T)];
+    [[no_unique_address]] Alloc d_alloc;
+
+    template <typename... Args>
+    control_block_make_shared_impl(const Alloc &alloc, Args &&...args) : d_alloc(alloc) {
         new (d_storage) T(std::forward<Args>(args)...);
     }
 
-    void dispose() override { reinterpret_cast<T *>(d_storage)->~T(); }
+    control_block_make_shared_impl(for_overwrite_t, const Alloc &alloc) : d_alloc(alloc) {
+        new (d_storage) T;
+    }
+
+    bool dispose() override {
+        reinterpret_cast<T *>(d_storage)->~T();
+        return true;
+    }
+    void destroy() noexcept override {
+        deallocate_control_block<control_block_make_shared_impl, Alloc>(this);
+    }
+    /// The object's storage is part of the block and stays with it.
+    std::size_t retained_bytes() const noexcept override { return sizeof(*this); }
+};
+
+/// Block for make_shared objects above the inline limit (see
+/// make_shared_splits): the object has an allocation of its own, freed by
+/// dispose(), so weak_ptrs outliving it only keep the small block alive.
+template <typename T, typename Alloc = std::allocator<T>>
+struct control_block_split_impl : public control_block_base {
+    using object_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+    using object_traits = std::allocator_traits<object_alloc>;
+
+    T *d_ptr;
+    [[no_unique_address]] Alloc d_alloc;
+
+    template <typename... Args>
+    control_block_split_impl(const Alloc &alloc, Args &&...args)
+        : d_ptr(allocate_object(alloc)), d_alloc(alloc) {
+        try {
+            ::new (static_cast<void *>(d_ptr)) T(std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate_object();
+            throw;
+        }
+    }
+
+    control_block_split_impl(for_overwrite_t, const Alloc &alloc)
+        : d_ptr(allocate_object(alloc)), d_alloc(alloc) {
+        try {
+            ::new (static_cast<void *>(d_ptr)) T;
+        } catch (...) {
+            deallocate_object();
+            throw;
+        }
+    }
+
+    static T *allocate_object(const Alloc &alloc) {
+        object_alloc storage_alloc(alloc);
+        return object_traits::allocate(storage_alloc, 1);
+    }
+
+    void deallocate_object() noexcept {
+        object_alloc storage_alloc(d_alloc);
+        object_traits::deallocate(storage_alloc, d_ptr, 1);
+    }
+
+    bool dispose() override {
+        d_ptr->~T();
+        deallocate_object();
+        return true;
+    }
+    void destroy() noexcept override {
+        deallocate_control_block<control_block_split_impl, Alloc>(this);
+    }
+    std::size_t retained_bytes() const noexcept override { return sizeof(*this); }
+};
+
+/// Array blocks are allocated in units aligned for both the block and its
+/// elements, so the elements can start right after the block.
+template <std::size_t Align> struct alignas(Align) array_storage_unit {
+    unsigned char d_bytes[Align];
 };
+
+/// Block for make_shared<T[]>(n) and make_shared<T[N]>(): the d_size
+/// elements live inline after the block, in the same allocation.
+template <typename E, typename Alloc> struct control_block_array_impl : public control_block_base {
+    std::size_t d_size;
+    [[no_unique_address]] Alloc d_alloc;
+
+    control_block_array_impl(std::size_t size, const Alloc &alloc) : d_size(size), d_alloc(alloc) {}
+
+    static constexpr std::size_t alignment() noexcept {
+        return std::max(alignof(control_block_array_impl), alignof(E));
+    }
+
+    /// Offset of the first element from the start of the block.
+    static constexpr std::size_t elements_offset() noexcept {
+        return (sizeof(control_block_array_impl) + alignof(E) - 1) / alignof(E) * alignof(E);
+    }
+
+    /// Number of storage units making up a block of size elements.
+    static constexpr std::size_t unit_count(std::size_t size) noexcept {
+        return (elements_offset() + size * sizeof(E) + alignment() - 1) / alignment();
+    }
+
+    E *elements() noexcept {
+        return reinterpret_cast<E *>(reinterpret_cast<unsigned char *>(this) + elements_offset());
+    }
+
+    bool dispose() override {
+        // Elements are destroyed in the reverse order of construction
+        if constexpr (!std::is_trivially_destructible_v<E>) {
+            E *elems = elements();
+            for (std::size_t i = d_size; i > 0; --i) {
+                std::destroy_at(elems + i - 1);
+            }
+        }
+        return true;
+    }
+
+    void destroy() noexcept override {
+        using unit = array_storage_unit<alignment()>;
+        using unit_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<unit>;
+
+        unit_alloc storage_alloc(d_alloc);
+        const std::size_t count = unit_count(d_size);
+        unit *storage = reinterpret_cast<unit *>(this);
+        this->~control_block_array_impl();
+        std::allocator_traits<unit_alloc>::deallocate(storage_alloc, storage, count);
+    }
+
+    /// The elements live in the block's allocation and stay with it.
+    std::size_t retained_bytes() const noexcept override {
+        return unit_count(d_size) * alignment();
+    }
+};
+
+/// Allocates an array block for size elements from alloc, and constructs
+/// the elements with init(elements, size). If init throws, the block is
+/// freed and the exception propagates.
+template <typename E, typename Alloc, typename Init>
+control_block_array_impl<E, Alloc> *allocate_array_block(const Alloc &alloc, std::size_t size,
+                                                         Init init) {
+    using block = control_block_array_impl<E, Alloc>;
+    using unit = array_storage_unit<block::alignment()>;
+    using unit_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<unit>;
+    using unit_traits = std::allocator_traits<unit_alloc>;
+
+    assert(size <= (std::numeric_limits<std::size_t>::max() - block::elements_offset() -
+                    block::alignment()) /
+                       sizeof(E) &&
+           "Array too large for make_shared");
+    unit_alloc storage_alloc(alloc);
+    const std::size_t count = block::unit_count(size);
+    unit *storage = unit_traits::allocate(storage_alloc, count);
+    block *cb = ::new (static_cast<void *>(storage)) block(size, alloc);
+    try {
+        init(cb->elements(), size);
+    } catch (...) {
+        cb->~block();
+        unit_traits::deallocate(storage_alloc, storage, count);
+        throw;
+    }
+    return cb;
+}
+
+/// Element initializers for allocate_array_block.
+struct value_initializer {
+    template <typename E> void operator()(E *elems, std::size_t size) const {
+        std::uninitialized_value_construct_n(elems, size);
+    }
+};
+
+template <typename E> struct fill_initializer {
+    const E &d_value;
+
+    void operator()(E *elems, std::size_t size) const {
+        std::uninitialized_fill_n(elems, size, d_value);
+    }
+};
+
+/// Trivially constructible elements are left untouched, so large buffers
+/// are not written to before the caller fills them.
+struct default_initializer {
+    template <typename E> void operator()(E *elems, std::size_t size) const {
+        if constexpr (!std::is_trivially_default_constructible_v<E>) {
+            std::uninitialized_default_construct_n(elems, size);
+        }
+    }
+};
+
+/// Control block adopting ptr with the given deleter. It comes from
+/// control_block_pool if the pool is enabled by default, and from the
+/// global heap otherwise. The deleter is only moved from once the block is
+/// allocated, so the caller still has it if the allocation throws.
+template <typename T, typename Deleter>
+control_block_base *adopt_control_block(T *ptr, Deleter &&deleter) {
+    using stored_deleter = std::remove_cvref_t<Deleter>;
+    if (control_block_pool::enabled_by_default()) {
+        return allocate_control_block<control_block_impl<T, stored_deleter, pool_allocator<T>>>(
+            pool_allocator<T>(), ptr, std::forward<Deleter>(deleter), pool_allocator<T>());
+    }
+    return allocate_control_block<control_block_impl<T, stored_deleter>>(
+        std::allocator<T>(), ptr, std::forward<Deleter>(deleter));
+}
 } // namespace
 
 // ============================================================================
@@ -51,9 +521,15 @@ template <typename T> struct control_block_make_shared_impl : public control_blo
 // ============================================================================
 
 template <typename T> class weak_ptr;
+template <typename T> class atomic_shared_ptr;
+template <typename T> class enable_shared_from_this;
+
+struct shared_ptr_access;
 
+/// T may be an array type, U[] or U[N], in which case the handle points at
+/// the first element and provides operator[] instead of * and ->.
 template <typename T> class shared_ptr {
-    T *d_ptr;
+    std::remove_extent_t<T> *d_ptr;
     control_block_base *d_cb;
 
     inline void release() {
@@ -61,19 +537,14 @@ template <typename T> class shared_ptr {
             return;
         }
 
-        d_cb->decrement_shared_count();
-        if (d_cb->shared_count() == 0) {
-            d_cb->dispose();
-            if (d_cb->weak_count() == 0) {
-                delete d_cb;
-            }
-        }
+        d_cb->release_shared();
         d_cb = nullptr;
         d_ptr = nullptr;
     }
 
   public:
     using Value_Type = T;
+    using Element_Type = std::remove_extent_t<T>;
 
   public:
     // Constructor
@@ -84,28 +555,61 @@ template <typename T> class shared_ptr {
     constexpr shared_ptr(std::nullptr_t) noexcept;
 
     /// Creates a shared_ptr that manages the given raw pointer.
-    explicit shared_ptr(T *ptr);
+    explicit shared_ptr(Element_Type *ptr);
+
+    /// Creates a shared_ptr that manages the given raw pointer, with its
+    /// control block taken from control_block_pool.
+    shared_ptr(Element_Type *ptr, pooled_t);
 
     /// Creates a shared_ptr that manages the given raw pointer and
     /// a deleter to manage the clean up of the raw pointer
     template <typename Deleter>
-        requires CallableDeleter<T, Deleter>
-    explicit shared_ptr(T *ptr, Deleter deleter);
+        requires CallableDeleter<std::remove_extent_t<T>, Deleter>
+    explicit shared_ptr(Element_Type *ptr, Deleter deleter);
+
+    /// Creates a shared_ptr that manages the given raw pointer with a
+    /// deleter, and allocates its control block from alloc instead of the
+    /// global heap. The block keeps a rebound copy of alloc to free itself.
+    template <typename Deleter, typename Alloc>
+        requires CallableDeleter<std::remove_extent_t<T>, Deleter>
+    shared_ptr(Element_Type *ptr, Deleter deleter, const Alloc &alloc);
 
     // Create a shared_ptr from a weak_ptr
     explicit shared_ptr(const weak_ptr<T> &ptr);
 
+    /// Takes over ptr's object, moving its deleter into the control block.
+    /// A reference deleter is stored as a std::reference_wrapper. ptr is
+    /// left untouched if the block cannot be allocated, and an empty ptr
+    /// gives an empty shared_ptr without allocating.
+    template <typename Y, typename Deleter>
+        requires CompatiblePointer<Y, T> && CallableDeleter<std::remove_extent_t<Y>, Deleter>
+    shared_ptr(unique_ptr<Y, Deleter> &&ptr);
+
     // Copy constructor
     shared_ptr(const shared_ptr<T> &rhs) noexcept;
 
+    /// Converting copy constructor, e.g. shared_ptr<Derived> to
+    /// shared_ptr<Base>.
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    shared_ptr(const shared_ptr<Y> &rhs) noexcept;
+
     /// Alias copy constructor
-    template <typename Y> shared_ptr(const shared_ptr<Y> &ptr, T *element_type) noexcept;
+    template <typename Y>
+    shared_ptr(const shared_ptr<Y> &ptr, Element_Type *element_type) noexcept;
 
     // Move constructor
     shared_ptr(shared_ptr<T> &&rhs) noexcept;
 
-    /// Alias move constructor
-    template <typename Y> shared_ptr(shared_ptr<Y> &&ptr, T *element_type) noexcept;
+    /// Converting move constructor. The reference moves with the control
+    /// block, so the counts are not touched.
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    shared_ptr(shared_ptr<Y> &&rhs) noexcept;
+
+    /// Alias move constructor. Takes over ptr's reference and leaves ptr
+    /// empty.
+    template <typename Y> shared_ptr(shared_ptr<Y> &&ptr, Element_Type *element_type) noexcept;
 
     // Copy assignment
     /// Assignment operator that deletes the current managed object and
@@ -115,24 +619,66 @@ template <typename T> class shared_ptr {
     // Move assignment
     shared_ptr<T> &operator=(shared_ptr<T> &&rhs);
 
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    shared_ptr<T> &operator=(const shared_ptr<Y> &rhs) noexcept {
+        shared_ptr<T>(rhs).swap(*this);
+        return *this;
+    }
+
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    shared_ptr<T> &operator=(shared_ptr<Y> &&rhs) noexcept {
+        shared_ptr<T>(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    template <typename Y, typename Deleter>
+        requires CompatiblePointer<Y, T> && CallableDeleter<std::remove_extent_t<Y>, Deleter>
+    shared_ptr<T> &operator=(unique_ptr<Y, Deleter> &&rhs) {
+        shared_ptr<T>(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
     // Desctructor
     /// Destroys the managed object if this is the last shared_ptr owning it.
     ~shared_ptr();
 
   private:
-    // A private constructor for internal use by weak_ptr && make_shared
-    shared_ptr(T *ptr, control_block_base *cb) noexcept;
+    // A private constructor for internal use by weak_ptr && make_shared.
+    // Adopts a shared reference the caller has already taken on cb.
+    shared_ptr(Element_Type *ptr, control_block_base *cb) noexcept;
+
+    /// Points the weak_ptr embedded by enable_shared_from_this at this
+    /// handle's block the first time the object gets an owner. Called by
+    /// every path that creates a block for a new object.
+    void enable_weak_this() noexcept;
 
   public:
     // ACCESSORS
-    [[nodiscard]] inline T *get() const noexcept { return d_ptr; }
+    [[nodiscard]] inline Element_Type *get() const noexcept { return d_ptr; }
 
-    [[nodiscard]] T &operator*() const noexcept {
+    [[nodiscard]] Element_Type &operator*() const noexcept
+        requires(!std::is_array_v<T>)
+    {
         assert(d_ptr != nullptr && "Attempted to dereference a null shared_ptr");
         return *(get());
     }
 
-    [[nodiscard]] T *operator->() const noexcept { return get(); }
+    [[nodiscard]] Element_Type *operator->() const noexcept
+        requires(!std::is_array_v<T>)
+    {
+        return get();
+    }
+
+    [[nodiscard]] Element_Type &operator[](std::ptrdiff_t index) const noexcept
+        requires std::is_array_v<T>
+    {
+        assert(d_ptr != nullptr && "Attempted to index a null shared_ptr");
+        assert((std::extent_v<T> == 0 || static_cast<std::size_t>(index) < std::extent_v<T>) &&
+               "Index out of bounds");
+        return get()[index];
+    }
 
     [[nodiscard]] operator bool() const noexcept { return get() != nullptr; };
 
@@ -145,32 +691,44 @@ template <typename T> class shared_ptr {
         return 0;
     }
 
+    /// Owner-based ordering, hashing and equivalence: handles sharing a
+    /// control block are equivalent, whatever they point at and whether or
+    /// not the object has expired. Only the block's address is read, never
+    /// its counters.
+    template <typename Y> [[nodiscard]] bool owner_before(const shared_ptr<Y> &rhs) const noexcept {
+        return std::less<const control_block_base *>()(d_cb, rhs.d_cb);
+    }
+
+    template <typename Y> [[nodiscard]] bool owner_before(const weak_ptr<Y> &rhs) const noexcept {
+        return std::less<const control_block_base *>()(d_cb, rhs.d_cb);
+    }
+
+    [[nodiscard]] std::size_t owner_hash() const noexcept {
+        return std::hash<const control_block_base *>()(d_cb);
+    }
+
+    template <typename Y> [[nodiscard]] bool owner_equal(const shared_ptr<Y> &rhs) const noexcept {
+        return d_cb == rhs.d_cb;
+    }
+
+    template <typename Y> [[nodiscard]] bool owner_equal(const weak_ptr<Y> &rhs) const noexcept {
+        return d_cb == rhs.d_cb;
+    }
+
   public:
     inline void reset() { release(); }
 
-    inline void reset(T *ptr) {
-        control_block_impl<T, std::default_delete<T>> *new_cb = nullptr;
-        if (ptr != nullptr) {
-            new_cb =
-                new control_block_impl<T, std::default_delete<T>>{ptr, std::default_delete<T>()};
-        }
+    inline void reset(Element_Type *ptr) { shared_ptr<T>(ptr).swap(*this); }
 
-        release();
-        d_cb = new_cb;
-        d_ptr = ptr;
-        d_cb->increment_shared_count();
-    }
+    inline void reset(Element_Type *ptr, pooled_t tag) { shared_ptr<T>(ptr, tag).swap(*this); }
 
-    template <typename Deleter> inline void reset(T *ptr, Deleter deleter) {
-        control_block_impl<T, Deleter> *new_cb = nullptr;
-        if (ptr != nullptr) {
-            new_cb = new control_block_impl<T, Deleter>{ptr, deleter};
-        }
+    template <typename Deleter> inline void reset(Element_Type *ptr, Deleter deleter) {
+        shared_ptr<T>(ptr, deleter).swap(*this);
+    }
 
-        release();
-        d_cb = new_cb;
-        d_ptr = ptr;
-        d_cb->increment_shared_count();
+    template <typename Deleter, typename Alloc>
+    inline void reset(Element_Type *ptr, Deleter deleter, const Alloc &alloc) {
+        shared_ptr<T>(ptr, deleter, alloc).swap(*this);
     }
 
     inline void swap(shared_ptr &ptr) noexcept {
@@ -180,16 +738,20 @@ template <typename T> class shared_ptr {
 
   public:
     // Friend
-    friend class weak_ptr<T>;
+    template <typename Y> friend class weak_ptr;
 
-    template <typename Y, typename... Args> friend shared_ptr<Y> make_shared(Args &&...args);
+    friend class atomic_shared_ptr<T>;
+
+    friend struct shared_ptr_access;
+
+    template <typename Y> friend class shared_ptr;
 };
 
 // ============================================================================
 // WEAK POINTERS DEFINITION
 // ============================================================================
 template <typename T> class weak_ptr {
-    T *d_ptr;
+    std::remove_extent_t<T> *d_ptr;
     control_block_base *d_cb;
 
   private:
@@ -197,18 +759,16 @@ template <typename T> class weak_ptr {
         if (!d_cb) {
             return;
         }
-        d_cb->decrement_weak_count();
-        if (d_cb->shared_count() == 0 && d_cb->weak_count() == 0) {
-            delete d_cb;
-        }
+        d_cb->release_weak();
         d_cb = nullptr;
         d_ptr = nullptr;
     }
 
-    [[nodiscard]] inline T *get() const noexcept { return d_ptr; }
+    [[nodiscard]] inline std::remove_extent_t<T> *get() const noexcept { return d_ptr; }
 
   public:
     using Value_Type = T;
+    using Element_Type = std::remove_extent_t<T>;
 
   public:
     /// CONSTRUCTORS
@@ -220,6 +780,22 @@ template <typename T> class weak_ptr {
 
     weak_ptr(weak_ptr<T> &&ptr) noexcept;
 
+    /// Converting constructors, e.g. weak_ptr<Derived> to weak_ptr<Base>.
+    /// Converting the pointer of an expired object could read a freed
+    /// vtable when Base is a virtual base, so the conversion goes through
+    /// lock(). The control block is kept even if the object has expired.
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    weak_ptr(const weak_ptr<Y> &ptr) noexcept;
+
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    weak_ptr(weak_ptr<Y> &&ptr) noexcept;
+
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    weak_ptr(const shared_ptr<Y> &ptr) noexcept;
+
     /// DESTRUCTORS
     ~weak_ptr() noexcept;
 
@@ -230,6 +806,27 @@ template <typename T> class weak_ptr {
 
     weak_ptr<T> &operator=(weak_ptr<T> &&rhs) noexcept;
 
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    weak_ptr<T> &operator=(const weak_ptr<Y> &rhs) noexcept {
+        weak_ptr<T>(rhs).swap(*this);
+        return *this;
+    }
+
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    weak_ptr<T> &operator=(weak_ptr<Y> &&rhs) noexcept {
+        weak_ptr<T>(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    template <typename Y>
+        requires CompatiblePointer<Y, T>
+    weak_ptr<T> &operator=(const shared_ptr<Y> &rhs) noexcept {
+        weak_ptr<T>(rhs).swap(*this);
+        return *this;
+    }
+
   public:
     /// MODIFIERS
     inline void reset() noexcept { release(); }
@@ -250,12 +847,105 @@ template <typename T> class weak_ptr {
     }
 
     [[nodiscard]] inline shared_ptr<T> lock() const noexcept {
-        return expired() ? shared_ptr<T>() : shared_ptr<T>(this->d_ptr, this->d_cb);
+        if (d_cb && d_cb->increment_shared_count_if_not_zero()) {
+            return shared_ptr<T>(this->d_ptr, this->d_cb);
+        }
+        return shared_ptr<T>();
+    }
+
+    /// Owner-based ordering, hashing and equivalence, as for shared_ptr. A
+    /// weak_ptr can be used as a key this way without calling lock().
+    template <typename Y> [[nodiscard]] bool owner_before(const shared_ptr<Y> &rhs) const noexcept {
+        return std::less<const control_block_base *>()(d_cb, rhs.d_cb);
+    }
+
+    template <typename Y> [[nodiscard]] bool owner_before(const weak_ptr<Y> &rhs) const noexcept {
+        return std::less<const control_block_base *>()(d_cb, rhs.d_cb);
+    }
+
+    [[nodiscard]] std::size_t owner_hash() const noexcept {
+        return std::hash<const control_block_base *>()(d_cb);
+    }
+
+    template <typename Y> [[nodiscard]] bool owner_equal(const shared_ptr<Y> &rhs) const noexcept {
+        return d_cb == rhs.d_cb;
+    }
+
+    template <typename Y> [[nodiscard]] bool owner_equal(const weak_ptr<Y> &rhs) const noexcept {
+        return d_cb == rhs.d_cb;
+    }
+
+  private:
+    /// Element pointer of ptr converted to Element_Type. Only a cv change
+    /// (or an array element type) needs no adjustment through the object.
+    template <typename Y>
+    static Element_Type *converted_element(const weak_ptr<Y> &ptr) noexcept {
+        if constexpr (std::is_array_v<T> ||
+                      std::is_same_v<std::remove_cv_t<Y>, std::remove_cv_t<T>>) {
+            return ptr.d_ptr;
+        } else {
+            return ptr.lock().get();
+        }
     }
 
   public:
     // Friend
-    friend class shared_ptr<T>;
+    template <typename Y> friend class shared_ptr;
+
+    template <typename Y> friend class weak_ptr;
+
+    friend struct shared_ptr_access;
+};
+
+// ============================================================================
+// ENABLE_SHARED_FROM_THIS DEFINITION
+// ============================================================================
+
+/// Base letting an object owned by shared_ptr hand out more owners from
+/// `this`. The weak_ptr lives inside the object and is pointed at the
+/// control block by the constructor or make_shared call that creates the
+/// first owner, so there is no lookup and no extra allocation: a call to
+/// shared_from_this() is a single increment of the shared count.
+template <typename T> class enable_shared_from_this {
+    mutable weak_ptr<T> d_weak_this;
+
+  protected:
+    constexpr enable_shared_from_this() noexcept = default;
+
+    /// A copy is a new object with its own owners, if any.
+    enable_shared_from_this(const enable_shared_from_this &) noexcept {}
+
+    enable_shared_from_this &operator=(const enable_shared_from_this &) noexcept { return *this; }
+
+    ~enable_shared_from_this() = default;
+
+  public:
+    /// Detection hook used by shared_ptr.
+    using esft_type = enable_shared_from_this;
+
+  public:
+    /// Returns a new owner of this object. The object must already be
+    /// owned by a shared_ptr.
+    [[nodiscard]] shared_ptr<T> shared_from_this() {
+        shared_ptr<T> self(d_weak_this);
+        assert(self && "shared_from_this called on an object without an owner");
+        return self;
+    }
+
+    [[nodiscard]] shared_ptr<const T> shared_from_this() const {
+        shared_ptr<T> self(d_weak_this);
+        assert(self && "shared_from_this called on an object without an owner");
+        return self;
+    }
+
+    /// Empty if the object has no owner.
+    [[nodiscard]] weak_ptr<T> weak_from_this() noexcept { return d_weak_this; }
+
+    [[nodiscard]] weak_ptr<const T> weak_from_this() const noexcept { return d_weak_this; }
+
+  public:
+    // Friend
+    template <typename Y> friend class shared_ptr;
 };
 
 // ============================================================================
@@ -269,31 +959,58 @@ template <typename T>
 constexpr shared_ptr<T>::shared_ptr(std::nullptr_t) noexcept : d_ptr(nullptr), d_cb(nullptr) {}
 
 template <typename T>
-shared_ptr<T>::shared_ptr(T *ptr)
-    : d_ptr(ptr),
-      d_cb(new control_block_impl<T, std::default_delete<T>>{ptr, std::default_delete<T>()}) {
-    d_cb->increment_shared_count();
+shared_ptr<T>::shared_ptr(Element_Type *ptr)
+    : d_ptr(ptr), d_cb(adopt_control_block(ptr, std::default_delete<T>())) {
+    enable_weak_this();
 }
 
+template <typename T>
+shared_ptr<T>::shared_ptr(Element_Type *ptr, pooled_t)
+    : shared_ptr(ptr, std::default_delete<T>(), pool_allocator<Element_Type>()) {}
+
 template <typename T>
 template <typename Deleter>
-    requires CallableDeleter<T, Deleter>
-shared_ptr<T>::shared_ptr(T *ptr, Deleter deleter)
-    : d_ptr(ptr), d_cb(new control_block_impl<T, Deleter>{ptr, deleter}) {
-    d_cb->increment_shared_count();
+    requires CallableDeleter<std::remove_extent_t<T>, Deleter>
+shared_ptr<T>::shared_ptr(Element_Type *ptr, Deleter deleter)
+    : d_ptr(ptr), d_cb(adopt_control_block(ptr, std::move(deleter))) {
+    enable_weak_this();
+}
+
+template <typename T>
+template <typename Deleter, typename Alloc>
+    requires CallableDeleter<std::remove_extent_t<T>, Deleter>
+shared_ptr<T>::shared_ptr(Element_Type *ptr, Deleter deleter, const Alloc &alloc)
+    : d_ptr(ptr), d_cb(allocate_control_block<control_block_impl<Element_Type, Deleter, Alloc>>(
+                      alloc, ptr, std::move(deleter), alloc)) {
+    enable_weak_this();
 }
 
 template <typename T> shared_ptr<T>::shared_ptr(const weak_ptr<T> &wptr) {
-    if (wptr.d_cb && wptr.d_cb->shared_count() > 0) {
+    if (wptr.d_cb && wptr.d_cb->increment_shared_count_if_not_zero()) {
         this->d_ptr = wptr.d_ptr;
         this->d_cb = wptr.d_cb;
-        this->d_cb->increment_shared_count();
     } else {
         this->d_ptr = nullptr;
         this->d_cb = nullptr;
     }
 }
 
+template <typename T>
+template <typename Y, typename Deleter>
+    requires CompatiblePointer<Y, T> && CallableDeleter<std::remove_extent_t<Y>, Deleter>
+shared_ptr<T>::shared_ptr(unique_ptr<Y, Deleter> &&ptr) : d_ptr(ptr.get()), d_cb(nullptr) {
+    if (!d_ptr) {
+        return;
+    }
+    if constexpr (std::is_reference_v<Deleter>) {
+        d_cb = adopt_control_block(ptr.get(), std::ref(ptr.get_deleter()));
+    } else {
+        d_cb = adopt_control_block(ptr.get(), std::move(ptr.get_deleter()));
+    }
+    (void)ptr.release();
+    enable_weak_this();
+}
+
 template <typename T> shared_ptr<T>::~shared_ptr() { release(); }
 
 template <typename T>
@@ -303,10 +1020,19 @@ shared_ptr<T>::shared_ptr(const shared_ptr<T> &rhs) noexcept : d_ptr(rhs.d_ptr),
     }
 }
 
+template <typename T>
+template <typename Y>
+    requires CompatiblePointer<Y, T>
+shared_ptr<T>::shared_ptr(const shared_ptr<Y> &rhs) noexcept : d_ptr(rhs.d_ptr), d_cb(rhs.d_cb) {
+    if (d_cb) {
+        d_cb->increment_shared_count();
+    }
+}
+
 /// Alias constructor
 template <typename T>
 template <typename Y>
-shared_ptr<T>::shared_ptr(const shared_ptr<Y> &ptr, T *element_type) noexcept
+shared_ptr<T>::shared_ptr(const shared_ptr<Y> &ptr, Element_Type *element_type) noexcept
     : d_ptr(element_type), d_cb(ptr.d_cb) {
     if (d_cb) {
         d_cb->increment_shared_count();
@@ -315,16 +1041,26 @@ shared_ptr<T>::shared_ptr(const shared_ptr<Y> &ptr, T *element_type) noexcept
 
 template <typename T>
 shared_ptr<T>::shared_ptr(shared_ptr<T> &&rhs) noexcept : d_ptr(nullptr), d_cb(nullptr) {
+    KSL_MEMORY_TRACE_MOVE();
     std::swap(this->d_cb, rhs.d_cb);
     std::swap(this->d_ptr, rhs.d_ptr);
 }
 
+template <typename T>
+template <typename Y>
+    requires CompatiblePointer<Y, T>
+shared_ptr<T>::shared_ptr(shared_ptr<Y> &&rhs) noexcept
+    : d_ptr(std::exchange(rhs.d_ptr, nullptr)), d_cb(std::exchange(rhs.d_cb, nullptr)) {
+    KSL_MEMORY_TRACE_MOVE();
+}
+
 /// Alias constructor
 template <typename T>
 template <typename Y>
-shared_ptr<T>::shared_ptr(shared_ptr<Y> &&ptr, T *element_type) noexcept
-    : d_ptr(element_type), d_cb(nullptr) {
-    std::swap(d_cb, ptr.d_cb);
+shared_ptr<T>::shared_ptr(shared_ptr<Y> &&ptr, Element_Type *element_type) noexcept
+    : d_ptr(element_type), d_cb(std::exchange(ptr.d_cb, nullptr)) {
+    KSL_MEMORY_TRACE_MOVE();
+    ptr.d_ptr = nullptr;
 }
 
 template <typename T> shared_ptr<T> &shared_ptr<T>::operator=(const shared_ptr<T> &rhs) {
@@ -341,6 +1077,7 @@ template <typename T> shared_ptr<T> &shared_ptr<T>::operator=(const shared_ptr<T
 
 template <typename T> shared_ptr<T> &shared_ptr<T>::operator=(shared_ptr<T> &&rhs) {
     if (this != &rhs) {
+        KSL_MEMORY_TRACE_MOVE();
         release();
         std::swap(this->d_cb, rhs.d_cb);
         std::swap(this->d_ptr, rhs.d_ptr);
@@ -349,9 +1086,22 @@ template <typename T> shared_ptr<T> &shared_ptr<T>::operator=(shared_ptr<T> &&rh
 }
 
 template <typename T>
-shared_ptr<T>::shared_ptr(T *ptr, control_block_base *cb) noexcept : d_ptr(ptr), d_cb(cb) {
-    if (d_ptr && d_cb) {
-        d_cb->increment_shared_count();
+shared_ptr<T>::shared_ptr(Element_Type *ptr, control_block_base *cb) noexcept
+    : d_ptr(ptr), d_cb(cb) {}
+
+template <typename T> void shared_ptr<T>::enable_weak_this() noexcept {
+    if constexpr (EnablesSharedFromThis<std::remove_cv_t<T>>) {
+        if (!d_ptr) {
+            return;
+        }
+        auto *object = const_cast<std::remove_cv_t<T> *>(d_ptr);
+        // An object already owned elsewhere keeps pointing at its first block
+        if (object->d_weak_this.expired()) {
+            object->d_weak_this.reset();
+            d_cb->increment_weak_count();
+            object->d_weak_this.d_ptr = object;
+            object->d_weak_this.d_cb = d_cb;
+        }
     }
 }
 
@@ -381,6 +1131,33 @@ weak_ptr<T>::weak_ptr(weak_ptr<T> &&ptr) noexcept : d_ptr(nullptr), d_cb(nullptr
     std::swap(d_cb, ptr.d_cb);
 }
 
+template <typename T>
+template <typename Y>
+    requires CompatiblePointer<Y, T>
+weak_ptr<T>::weak_ptr(const weak_ptr<Y> &ptr) noexcept
+    : d_ptr(converted_element(ptr)), d_cb(ptr.d_cb) {
+    if (d_cb) {
+        d_cb->increment_weak_count();
+    }
+}
+
+template <typename T>
+template <typename Y>
+    requires CompatiblePointer<Y, T>
+weak_ptr<T>::weak_ptr(weak_ptr<Y> &&ptr) noexcept
+    : d_ptr(converted_element(ptr)), d_cb(std::exchange(ptr.d_cb, nullptr)) {
+    ptr.d_ptr = nullptr;
+}
+
+template <typename T>
+template <typename Y>
+    requires CompatiblePointer<Y, T>
+weak_ptr<T>::weak_ptr(const shared_ptr<Y> &ptr) noexcept : d_ptr(ptr.d_ptr), d_cb(ptr.d_cb) {
+    if (d_cb) {
+        d_cb->increment_weak_count();
+    }
+}
+
 template <typename T> weak_ptr<T>::~weak_ptr() noexcept { release(); }
 
 template <typename T> weak_ptr<T> &weak_ptr<T>::operator=(const weak_ptr<T> &rhs) noexcept {
@@ -415,13 +1192,492 @@ template <typename T> void weak_ptr<T>::swap(weak_ptr<T> &ptr) noexcept {
     std::swap(this->d_cb, ptr.d_cb);
 }
 
+// ============================================================================
+// POINTER CASTS IMPLEMENTATION
+// ============================================================================
+
+/// Each cast shares ownership with ptr. The rvalue overloads take over
+/// ptr's reference instead of taking a new one, so casting a temporary or
+/// a moved handle touches no count. ptr is left empty, except by a failed
+/// dynamic_pointer_cast which leaves it untouched.
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> static_pointer_cast(const shared_ptr<Y> &ptr) noexcept {
+    return shared_ptr<T>(ptr, static_cast<typename shared_ptr<T>::Element_Type *>(ptr.get()));
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> static_pointer_cast(shared_ptr<Y> &&ptr) noexcept {
+    auto *element = static_cast<typename shared_ptr<T>::Element_Type *>(ptr.get());
+    return shared_ptr<T>(std::move(ptr), element);
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> dynamic_pointer_cast(const shared_ptr<Y> &ptr) noexcept {
+    if (auto *element = dynamic_cast<typename shared_ptr<T>::Element_Type *>(ptr.get())) {
+        return shared_ptr<T>(ptr, element);
+    }
+    return shared_ptr<T>();
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> dynamic_pointer_cast(shared_ptr<Y> &&ptr) noexcept {
+    if (auto *element = dynamic_cast<typename shared_ptr<T>::Element_Type *>(ptr.get())) {
+        return shared_ptr<T>(std::move(ptr), element);
+    }
+    return shared_ptr<T>();
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> const_pointer_cast(const shared_ptr<Y> &ptr) noexcept {
+    return shared_ptr<T>(ptr, const_cast<typename shared_ptr<T>::Element_Type *>(ptr.get()));
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> const_pointer_cast(shared_ptr<Y> &&ptr) noexcept {
+    auto *element = const_cast<typename shared_ptr<T>::Element_Type *>(ptr.get());
+    return shared_ptr<T>(std::move(ptr), element);
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> reinterpret_pointer_cast(const shared_ptr<Y> &ptr) noexcept {
+    return shared_ptr<T>(ptr,
+                         reinterpret_cast<typename shared_ptr<T>::Element_Type *>(ptr.get()));
+}
+
+template <typename T, typename Y>
+[[nodiscard]] shared_ptr<T> reinterpret_pointer_cast(shared_ptr<Y> &&ptr) noexcept {
+    auto *element = reinterpret_cast<typename shared_ptr<T>::Element_Type *>(ptr.get());
+    return shared_ptr<T>(std::move(ptr), element);
+}
+
+// ============================================================================
+// COMPARISONS AND HASHING
+// ============================================================================
+
+/// shared_ptrs compare by the pointer they hold, like raw pointers. Two
+/// aliases of one object are different keys here but equivalent under
+/// owner_less and owner_equal.
+template <typename T, typename U>
+[[nodiscard]] bool operator==(const shared_ptr<T> &lhs, const shared_ptr<U> &rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template <typename T, typename U>
+[[nodiscard]] std::strong_ordering operator<=>(const shared_ptr<T> &lhs,
+                                               const shared_ptr<U> &rhs) noexcept {
+    return std::compare_three_way()(lhs.get(), rhs.get());
+}
+
+template <typename T>
+[[nodiscard]] bool operator==(const shared_ptr<T> &lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+
+template <typename T>
+[[nodiscard]] std::strong_ordering operator<=>(const shared_ptr<T> &lhs, std::nullptr_t) noexcept {
+    return std::compare_three_way()(lhs.get(),
+                                    static_cast<typename shared_ptr<T>::Element_Type *>(nullptr));
+}
+
+/// Owner-based strict weak ordering, for sorted containers keyed by
+/// shared_ptr or weak_ptr. The void specialization compares any mix of the
+/// two and is transparent.
+template <typename T = void> struct owner_less;
+
+template <typename T> struct owner_less<shared_ptr<T>> {
+    bool operator()(const shared_ptr<T> &lhs, const shared_ptr<T> &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+    bool operator()(const shared_ptr<T> &lhs, const weak_ptr<T> &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+    bool operator()(const weak_ptr<T> &lhs, const shared_ptr<T> &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+};
+
+template <typename T> struct owner_less<weak_ptr<T>> {
+    bool operator()(const weak_ptr<T> &lhs, const weak_ptr<T> &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+    bool operator()(const shared_ptr<T> &lhs, const weak_ptr<T> &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+    bool operator()(const weak_ptr<T> &lhs, const shared_ptr<T> &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+};
+
+template <> struct owner_less<void> {
+    using is_transparent = void;
+
+    template <typename T, typename U>
+    bool operator()(const T &lhs, const U &rhs) const noexcept {
+        return lhs.owner_before(rhs);
+    }
+};
+
+/// Owner-based hash and equality, for unordered containers keyed by
+/// shared_ptr or weak_ptr. Both are transparent.
+struct owner_hash {
+    using is_transparent = void;
+
+    template <typename T> std::size_t operator()(const T &ptr) const noexcept {
+        return ptr.owner_hash();
+    }
+};
+
+struct owner_equal {
+    using is_transparent = void;
+
+    template <typename T, typename U>
+    bool operator()(const T &lhs, const U &rhs) const noexcept {
+        return lhs.owner_equal(rhs);
+    }
+};
+
 // ============================================================================
 // MAKE_SHARED IMPLEMENTATION
 // ============================================================================
 
-template <typename Y, typename... Args> shared_ptr<Y> make_shared(Args &&...args) {
-    auto cb = new control_block_make_shared_impl<Y>{std::forward<Args>(args)...};
-    Y *ptr = reinterpret_cast<Y *>(cb->d_storage);
-    return shared_ptr<Y>(ptr, cb);
+/// Lets the make_shared family hand a freshly created block to a handle
+/// through the adopting constructor, and other components in this group
+/// take a handle's reference as a bare control block.
+struct shared_ptr_access {
+    template <typename T>
+    static shared_ptr<T> adopt(std::remove_extent_t<T> *ptr, control_block_base *cb) noexcept {
+        shared_ptr<T> result(ptr, cb);
+        result.enable_weak_this();
+        return result;
+    }
+
+    /// Empties ptr and returns its block, whose shared reference now
+    /// belongs to the caller.
+    template <typename T> static control_block_base *detach(shared_ptr<T> &ptr) noexcept {
+        ptr.d_ptr = nullptr;
+        return std::exchange(ptr.d_cb, nullptr);
+    }
+
+    template <typename T> static control_block_base *block(const shared_ptr<T> &ptr) noexcept {
+        return ptr.d_cb;
+    }
+
+    /// A handle for a reference the caller has already taken on the block
+    /// of an object that has owners, so enable_shared_from_this is left
+    /// alone.
+    template <typename T>
+    static shared_ptr<T> share(std::remove_extent_t<T> *ptr, control_block_base *cb) noexcept {
+        return shared_ptr<T>(ptr, cb);
+    }
+
+    /// A weak_ptr to the object of a shared_ptr, taking a weak reference
+    /// on cb.
+    template <typename T>
+    static weak_ptr<T> weaken(std::remove_extent_t<T> *ptr, control_block_base *cb) noexcept {
+        weak_ptr<T> result;
+        if (cb) {
+            cb->increment_weak_count();
+            result.d_ptr = ptr;
+            result.d_cb = cb;
+        }
+        return result;
+    }
+};
+
+/// Objects up to this size are stored inline in their make_shared block.
+inline constexpr std::size_t k_make_shared_inline_limit = 1024;
+
+/// Whether make_shared and allocate_shared give T an allocation separate
+/// from its control block. Inline storage saves an allocation but is only
+/// freed with the block, so an expired object stays in memory for as long
+/// as any weak_ptr to it. Specialize to override the size rule for a type.
+template <typename T>
+inline constexpr bool make_shared_splits = sizeof(T) > k_make_shared_inline_limit;
+
+namespace {
+template <typename Alloc> inline constexpr bool is_std_allocator = false;
+template <typename T> inline constexpr bool is_std_allocator<std::allocator<T>> = true;
+
+/// Calls make with alloc, or, if alloc is a std::allocator and the calling
+/// thread has a preferred node, with a numa_allocator for that node.
+template <typename Alloc, typename Make> auto with_preferred_node(const Alloc &alloc, Make make) {
+    if constexpr (is_std_allocator<Alloc>) {
+        if (const int node = numa_arena::preferred_node(); node != numa_arena::k_no_node)
+            [[unlikely]] {
+            return make(numa_allocator<typename Alloc::value_type>(node));
+        }
+    }
+    return make(alloc);
+}
+
+template <typename Y, typename Alloc, typename Init>
+shared_ptr<Y> allocate_shared_array(const Alloc &alloc, std::size_t size, Init init) {
+    auto cb = allocate_array_block<std::remove_extent_t<Y>>(alloc, size, init);
+    return shared_ptr_access::adopt<Y>(cb->elements(), cb);
+}
+
+/// Creates a make_shared object from args, which are forwarded to the
+/// block's constructor after the allocator, with the layout picked by
+/// make_shared_splits.
+template <typename Y, typename Alloc, typename... Args>
+shared_ptr<Y> allocate_shared_object(const Alloc &alloc, Args &&...args) {
+    if constexpr (make_shared_splits<Y>) {
+        auto cb = allocate_control_block<control_block_split_impl<Y, Alloc>>(
+            alloc, std::forward<Args>(args)...);
+        return shared_ptr_access::adopt<Y>(cb->d_ptr, cb);
+    } else {
+        auto cb = allocate_control_block<control_block_make_shared_impl<Y, Alloc>>(
+            alloc, std::forward<Args>(args)...);
+        Y *ptr = reinterpret_cast<Y *>(cb->d_storage);
+        return shared_ptr_access::adopt<Y>(ptr, cb);
+    }
+}
+} // namespace
+
+/// Creates the object and its control block in a single allocation made
+/// with alloc, or in two if make_shared_splits<Y> holds. The block keeps a
+/// rebound copy of alloc to free itself.
+///
+/// Every allocate_shared and make_shared given or defaulting to a
+/// std::allocator allocates from numa_arena instead while the calling
+/// thread has a preferred node.
+template <typename Y, typename Alloc, typename... Args>
+    requires(!std::is_array_v<Y> && !std::is_same_v<Alloc, padded_layout_t>)
+shared_ptr<Y> allocate_shared(const Alloc &alloc, Args &&...args) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_object<Y>(placed, placed, std::forward<Args>(args)...);
+    });
+}
+
+/// Like allocate_shared, with the object on its own cache lines, away from
+/// the counters. Meant for shared objects that are written to while other
+/// threads copy handles to them; alloc must support over-aligned types.
+/// The object is always inline, whatever make_shared_splits says.
+template <typename Y, typename Alloc, typename... Args>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> allocate_shared(padded_layout_t, const Alloc &alloc, Args &&...args) {
+    constexpr std::size_t align = std::max(alignof(Y), padded_layout_t::k_cache_line);
+    return with_preferred_node(alloc, [&]<typename Placed>(const Placed &placed) {
+        auto cb = allocate_control_block<control_block_make_shared_impl<Y, Placed, align>>(
+            placed, placed, std::forward<Args>(args)...);
+        Y *ptr = reinterpret_cast<Y *>(cb->d_storage);
+        return shared_ptr_access::adopt<Y>(ptr, cb);
+    });
+}
+
+/// Creates size value-initialized elements stored inline after their
+/// control block, in a single allocation made with alloc.
+template <typename Y, typename Alloc>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> allocate_shared(const Alloc &alloc, std::size_t size) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_array<Y>(placed, size, value_initializer());
+    });
+}
+
+template <typename Y, typename Alloc>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> allocate_shared(const Alloc &alloc, std::size_t size,
+                              const std::remove_extent_t<Y> &value) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_array<Y>(placed, size,
+                                        fill_initializer<std::remove_extent_t<Y>>{value});
+    });
+}
+
+template <typename Y, typename Alloc>
+    requires std::is_bounded_array_v<Y>
+shared_ptr<Y> allocate_shared(const Alloc &alloc) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_array<Y>(placed, std::extent_v<Y>, value_initializer());
+    });
+}
+
+template <typename Y, typename Alloc>
+    requires std::is_bounded_array_v<Y>
+shared_ptr<Y> allocate_shared(const Alloc &alloc, const std::remove_extent_t<Y> &value) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_array<Y>(placed, std::extent_v<Y>,
+                                        fill_initializer<std::remove_extent_t<Y>>{value});
+    });
+}
+
+/// Like allocate_shared but the object, or each element, is
+/// default-initialized: trivially constructible types are left
+/// uninitialized.
+template <typename Y, typename Alloc>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> allocate_shared_for_overwrite(const Alloc &alloc) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_object<Y>(placed, for_overwrite_t(), placed);
+    });
+}
+
+template <typename Y, typename Alloc>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> allocate_shared_for_overwrite(const Alloc &alloc, std::size_t size) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_array<Y>(placed, size, default_initializer());
+    });
+}
+
+template <typename Y, typename Alloc>
+    requires std::is_bounded_array_v<Y>
+shared_ptr<Y> allocate_shared_for_overwrite(const Alloc &alloc) {
+    return with_preferred_node(alloc, [&](const auto &placed) {
+        return allocate_shared_array<Y>(placed, std::extent_v<Y>, default_initializer());
+    });
+}
+
+template <typename Y, typename... Args>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> make_shared(Args &&...args) {
+    return ksl::allocate_shared<Y>(std::allocator<Y>(), std::forward<Args>(args)...);
+}
+
+template <typename Y, typename... Args>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> make_shared(padded_layout_t layout, Args &&...args) {
+    return ksl::allocate_shared<Y>(layout, std::allocator<Y>(), std::forward<Args>(args)...);
+}
+
+template <typename Y>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> make_shared(std::size_t size) {
+    return ksl::allocate_shared<Y>(std::allocator<std::remove_extent_t<Y>>(), size);
+}
+
+template <typename Y>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> make_shared(std::size_t size, const std::remove_extent_t<Y> &value) {
+    return ksl::allocate_shared<Y>(std::allocator<std::remove_extent_t<Y>>(), size, value);
+}
+
+template <typename Y>
+    requires std::is_bounded_array_v<Y>
+shared_ptr<Y> make_shared() {
+    return ksl::allocate_shared<Y>(std::allocator<std::remove_extent_t<Y>>());
+}
+
+template <typename Y>
+    requires std::is_bounded_array_v<Y>
+shared_ptr<Y> make_shared(const std::remove_extent_t<Y> &value) {
+    return ksl::allocate_shared<Y>(std::allocator<std::remove_extent_t<Y>>(), value);
+}
+
+template <typename Y>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> make_shared_for_overwrite() {
+    return ksl::allocate_shared_for_overwrite<Y>(std::allocator<Y>());
+}
+
+template <typename Y>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> make_shared_for_overwrite(std::size_t size) {
+    return ksl::allocate_shared_for_overwrite<Y>(std::allocator<std::remove_extent_t<Y>>(), size);
+}
+
+template <typename Y>
+    requires std::is_bounded_array_v<Y>
+shared_ptr<Y> make_shared_for_overwrite() {
+    return ksl::allocate_shared_for_overwrite<Y>(std::allocator<std::remove_extent_t<Y>>());
+}
+
+/// Creates the object and its control block in one allocation from node's
+/// numa_arena, whatever the calling thread's preferred node.
+template <typename Y, typename... Args>
+    requires(!std::is_array_v<Y>)
+shared_ptr<Y> make_shared_on_node(int node, Args &&...args) {
+    return ksl::allocate_shared<Y>(numa_allocator<Y>(node), std::forward<Args>(args)...);
+}
+
+template <typename Y>
+    requires std::is_unbounded_array_v<Y>
+shared_ptr<Y> make_shared_on_node(int node, std::size_t size) {
+    return ksl::allocate_shared<Y>(numa_allocator<std::remove_extent_t<Y>>(node), size);
+}
+
+// ============================================================================
+// BATCHED REFERENCE COUNTING
+// ============================================================================
+
+/// Writes n handles sharing ownership with ptr to out, as n copies would,
+/// but takes their references with one atomic increment instead of n, for
+/// handing one object to many consumers. Returns out past the last handle.
+/// If writing to out throws, the references not handed out yet are given
+/// back before the exception leaves.
+template <typename T, std::output_iterator<shared_ptr<T>> OutputIt>
+OutputIt share_n(const shared_ptr<T> &ptr, std::size_t n, OutputIt out) {
+    control_block_base *cb = shared_ptr_access::block(ptr);
+    if (!cb) {
+        for (; n > 0; --n) {
+            *out = shared_ptr<T>();
+            ++out;
+        }
+        return out;
+    }
+    if (n == 0) {
+        return out;
+    }
+
+    cb->increment_shared_count(n);
+    std::size_t remaining = n;
+    try {
+        for (; remaining > 0; --remaining) {
+            *out = shared_ptr_access::share<T>(ptr.get(), cb);
+            ++out;
+        }
+    } catch (...) {
+        // The handle being written owned its reference, and has given it
+        // back on its way out. ptr keeps the count above zero.
+        cb->release_shared(remaining - 1);
+        throw;
+    }
+    return out;
+}
+
+/// Resets the n handles from first, dropping the references of each run
+/// of consecutive handles sharing a control block with one atomic
+/// decrement, which makes releasing what share_n() handed out cost one
+/// decrement too. Returns first past the last handle.
+template <std::input_iterator InputIt>
+    requires requires(InputIt it) { shared_ptr_access::detach(*it); }
+InputIt release_n(InputIt first, std::size_t n) noexcept {
+    control_block_base *run = nullptr;
+    std::size_t count = 0;
+    for (; n > 0; --n, ++first) {
+        control_block_base *cb = shared_ptr_access::detach(*first);
+        if (cb != run) {
+            if (run) {
+                run->release_shared(count);
+            }
+            run = cb;
+            count = 0;
+        }
+        count += cb != nullptr;
+    }
+    if (run) {
+        run->release_shared(count);
+    }
+    return first;
 }
-} // namespace ksl
\ No newline at end of file
+
+/// Handles hold two pointers and nothing refers to a handle's address, so
+/// containers may move them with memcpy.
+template <typename T> struct is_trivially_relocatable<shared_ptr<T>> : std::true_type {};
+template <typename T> struct is_trivially_relocatable<weak_ptr<T>> : std::true_type {};
+
+} // namespace ksl
+
+/// Hashes the held pointer, consistently with operator==.
+template <typename T> struct std::hash<ksl::shared_ptr<T>> {
+    std::size_t operator()(const ksl::shared_ptr<T> &ptr) const noexcept {
+        return std::hash<typename ksl::shared_ptr<T>::Element_Type *>()(ptr.get());
+    }
+};
+
+/// A weak_ptr's pointer may dangle, so it hashes by owner instead,
+/// consistently with ksl::owner_equal.
+template <typename T> struct std::hash<ksl::weak_ptr<T>> {
+    std::size_t operator()(const ksl::weak_ptr<T> &ptr) const noexcept { return ptr.owner_hash(); }
+};
\ No newline at end of file
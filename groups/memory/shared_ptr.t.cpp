@@ -4,8 +4,54 @@
 // Testing framework
 #include <gtest/gtest.h>
 
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <latch>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+/// Allocations the calling thread makes before its next operator new
+/// throws std::bad_alloc, or -1 for none.
+thread_local int t_allocations_before_failure = -1;
+} // namespace
+
+void *operator new(std::size_t size) {
+    if (t_allocations_before_failure >= 0 && t_allocations_before_failure-- == 0) {
+        throw std::bad_alloc();
+    }
+    if (void *ptr = std::malloc(size != 0 ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
 namespace ksl {
 
+/// Makes the calling thread's next operator new throw, for a scope.
+class failing_allocation_scope {
+  public:
+    failing_allocation_scope() noexcept { t_allocations_before_failure = 0; }
+
+    failing_allocation_scope(const failing_allocation_scope &) = delete;
+    failing_allocation_scope &operator=(const failing_allocation_scope &) = delete;
+
+    ~failing_allocation_scope() { t_allocations_before_failure = -1; }
+};
+
 class SharedPtrTest : public ::testing::Test {
   protected:
     struct Derived {
@@ -19,6 +65,12 @@ class SharedPtrTest : public ::testing::Test {
 
 int SharedPtrTest::Derived::destructor_count = 0;
 
+// Number of threads and rounds used by the concurrency stress tests. They are
+// meant to be run under `./build.sh -Dthread` where TSan reports any data race
+// on the control block, and under `-Daddress` for double frees.
+constexpr int k_stress_threads = 4;
+constexpr int k_stress_rounds = 2000;
+
 // ============================================================================
 // CONSTRUCTORS
 // ============================================================================
@@ -386,6 +438,32 @@ TEST_F(SharedPtrTest, CustomDeleterWithFunctorAndSharedOwnership) {
     EXPECT_EQ(Derived::destructor_count, 2);
 }
 
+// ============================================================================
+// CONTROL BLOCK LAYOUT
+// ============================================================================
+
+TEST_F(SharedPtrTest, StatelessDeletersTakeNoSpace) {
+    constexpr std::size_t compact = sizeof(control_block_base) + sizeof(Derived *);
+    auto stateless = [](Derived *p) { delete p; };
+    int captured = 0;
+    auto stateful = [&captured](Derived *p) {
+        captured++;
+        delete p;
+    };
+
+    static_assert(sizeof(control_block_impl<Derived>) == compact);
+    static_assert(sizeof(control_block_impl<Derived, decltype(stateless)>) == compact);
+    static_assert(
+        sizeof(control_block_impl<Derived, decltype(stateless), pool_allocator<Derived>>) ==
+        compact);
+    static_assert(sizeof(control_block_impl<Derived, decltype(stateful)>) > compact);
+
+    // The compact default-delete block still deletes its object
+    Derived::destructor_count = 0;
+    { shared_ptr<Derived> ptr(new Derived(3), std::default_delete<Derived>()); }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
 // ============================================================================
 // SWAP AND TYPE ALIAS
 // ============================================================================
@@ -455,6 +533,374 @@ TEST_F(SharedPtrTest, MakeSharedWithMultipleArguments) {
     }
 }
 
+// ============================================================================
+// ALLOCATORS
+// ============================================================================
+
+/// Allocator that records every allocation made through it, and its rebound
+/// copies, in a shared set of counters.
+struct AllocationCounts {
+    int allocations = 0;
+    int deallocations = 0;
+    std::size_t bytes = 0;
+};
+
+template <typename T> struct CountingAllocator {
+    using value_type = T;
+
+    AllocationCounts *counts;
+
+    explicit CountingAllocator(AllocationCounts *c) : counts(c) {}
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &other) noexcept : counts(other.counts) {}
+
+    T *allocate(std::size_t n) {
+        counts->allocations++;
+        counts->bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) noexcept {
+        counts->deallocations++;
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template <typename U> bool operator==(const CountingAllocator<U> &other) const noexcept {
+        return counts == other.counts;
+    }
+};
+
+TEST_F(SharedPtrTest, AllocateShared) {
+    Derived::destructor_count = 0;
+    AllocationCounts counts;
+    {
+        shared_ptr<Derived> ptr =
+            allocate_shared<Derived>(CountingAllocator<Derived>(&counts), 100);
+        EXPECT_EQ(ptr->value, 100);
+        EXPECT_EQ(ptr.use_count(), 1);
+        EXPECT_EQ(counts.allocations, 1);
+        EXPECT_GE(counts.bytes, sizeof(Derived));
+
+        shared_ptr<Derived> copy(ptr);
+        EXPECT_EQ(ptr.use_count(), 2);
+        EXPECT_EQ(counts.allocations, 1);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+    EXPECT_EQ(counts.deallocations, 1);
+}
+
+TEST_F(SharedPtrTest, AllocateSharedOutlivedByWeakPtr) {
+    Derived::destructor_count = 0;
+    AllocationCounts counts;
+    weak_ptr<Derived> wptr;
+    {
+        shared_ptr<Derived> ptr = allocate_shared<Derived>(CountingAllocator<char>(&counts), 7);
+        wptr = ptr;
+    }
+    // The object is gone but the block, which holds it, is still alive.
+    EXPECT_EQ(Derived::destructor_count, 1);
+    EXPECT_TRUE(wptr.expired());
+    EXPECT_EQ(counts.deallocations, 0);
+
+    wptr.reset();
+    EXPECT_EQ(counts.allocations, 1);
+    EXPECT_EQ(counts.deallocations, 1);
+}
+
+TEST_F(SharedPtrTest, MakeSharedPaddedLayout) {
+    constexpr std::size_t k_line = padded_layout_t::k_cache_line;
+    Derived::destructor_count = 0;
+    {
+        shared_ptr<Derived> ptr = make_shared<Derived>(padded_layout, 8);
+        EXPECT_EQ(ptr->value, 8);
+        EXPECT_EQ(ptr.use_count(), 1);
+
+        // The object starts on a line after the one holding the counters
+        const auto object = reinterpret_cast<std::uintptr_t>(ptr.get());
+        control_block_base *cb = shared_ptr_access::detach(ptr);
+        const auto counters = reinterpret_cast<std::uintptr_t>(&cb->d_shared_count);
+        EXPECT_EQ(object % k_line, 0u);
+        EXPECT_GE(object, counters - counters % k_line + k_line);
+        ptr = shared_ptr_access::adopt<Derived>(reinterpret_cast<Derived *>(object), cb);
+
+        shared_ptr<Derived> copy(ptr);
+        EXPECT_EQ(ptr.use_count(), 2);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+
+    // Nothing follows the object on its last line
+    using padded_block = control_block_make_shared_impl<Derived, std::allocator<Derived>, k_line>;
+    static_assert(sizeof(padded_block) % k_line == 0);
+}
+
+TEST_F(SharedPtrTest, AllocateSharedPaddedLayout) {
+    Derived::destructor_count = 0;
+    AllocationCounts counts;
+    weak_ptr<Derived> wptr;
+    {
+        shared_ptr<Derived> ptr =
+            allocate_shared<Derived>(padded_layout, CountingAllocator<Derived>(&counts), 9);
+        EXPECT_EQ(ptr->value, 9);
+        EXPECT_EQ(counts.allocations, 1);
+        EXPECT_GE(counts.bytes, 2 * padded_layout_t::k_cache_line);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr.get()) % padded_layout_t::k_cache_line,
+                  0u);
+        wptr = ptr;
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+    EXPECT_EQ(counts.deallocations, 0);
+    wptr.reset();
+    EXPECT_EQ(counts.deallocations, 1);
+}
+
+// Above k_make_shared_inline_limit, so make_shared allocates it separately.
+struct Large {
+    static int live;
+    int value;
+    unsigned char bytes[2 * k_make_shared_inline_limit];
+
+    explicit Large(int v = 0) : value(v) { live++; }
+    ~Large() { live--; }
+};
+
+int Large::live = 0;
+
+TEST_F(SharedPtrTest, MakeSharedSplitsLargeObjects) {
+    static_assert(make_shared_splits<Large>);
+    static_assert(!make_shared_splits<Derived>);
+
+    const weak_retention_stats before = weak_retention::stats();
+    AllocationCounts counts;
+    weak_ptr<Large> wptr;
+    {
+        shared_ptr<Large> ptr = allocate_shared<Large>(CountingAllocator<Large>(&counts), 3);
+        EXPECT_EQ(ptr->value, 3);
+        EXPECT_EQ(counts.allocations, 2);
+        wptr = ptr;
+    }
+    // The object's storage goes with the last owner, only the block stays
+    EXPECT_EQ(Large::live, 0);
+    EXPECT_EQ(counts.deallocations, 1);
+    weak_retention_stats pinned = weak_retention::stats();
+    EXPECT_EQ(pinned.blocks - before.blocks, 1u);
+    EXPECT_LT(pinned.bytes - before.bytes, sizeof(Large));
+
+    wptr.reset();
+    EXPECT_EQ(counts.deallocations, 2);
+    pinned = weak_retention::stats();
+    EXPECT_EQ(pinned.blocks, before.blocks);
+    EXPECT_EQ(pinned.bytes, before.bytes);
+
+    shared_ptr<Large> overwrite = make_shared_for_overwrite<Large>();
+    EXPECT_EQ(Large::live, 1);
+}
+
+// Large object whose constructor throws.
+struct ThrowingLarge : Large {
+    ThrowingLarge() { throw 1; }
+};
+
+TEST_F(SharedPtrTest, MakeSharedSplitConstructorThrows) {
+    AllocationCounts counts;
+    EXPECT_THROW((void)allocate_shared<ThrowingLarge>(CountingAllocator<ThrowingLarge>(&counts)),
+                 int);
+    EXPECT_EQ(Large::live, 0);
+    EXPECT_EQ(counts.allocations, 2);
+    EXPECT_EQ(counts.deallocations, 2);
+}
+
+TEST_F(SharedPtrTest, WeakRetentionCountsInlineStorage) {
+    const weak_retention_stats before = weak_retention::stats();
+    {
+        // No weak_ptr left when the object expires: nothing is counted
+        shared_ptr<Derived> ptr = make_shared<Derived>(1);
+        weak_ptr<Derived> wptr(ptr);
+        wptr.reset();
+    }
+    EXPECT_EQ(weak_retention::stats().blocks, before.blocks);
+
+    weak_ptr<Derived> wptr = make_shared<Derived>(2);
+    weak_ptr<Derived> other = wptr;
+    weak_retention_stats pinned = weak_retention::stats();
+    EXPECT_EQ(pinned.blocks - before.blocks, 1u);
+    EXPECT_GE(pinned.bytes - before.bytes, sizeof(control_block_base) + sizeof(Derived));
+
+    wptr.reset();
+    EXPECT_EQ(weak_retention::stats().blocks - before.blocks, 1u);
+    other.reset();
+    pinned = weak_retention::stats();
+    EXPECT_EQ(pinned.blocks, before.blocks);
+    EXPECT_EQ(pinned.bytes, before.bytes);
+}
+
+TEST_F(SharedPtrTest, WeakRetentionSumsEveryThread) {
+    // Blocks counted on the threads' shards and uncounted on this one
+    constexpr int k_threads = 2 * static_cast<int>(scalable_shard::k_count);
+    const weak_retention_stats before = weak_retention::stats();
+    std::vector<weak_ptr<int>> weak(k_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back(
+            [&weak, t] { weak[static_cast<std::size_t>(t)] = make_shared<int>(t); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(weak_retention::stats().blocks - before.blocks, static_cast<std::size_t>(k_threads));
+
+    weak.clear();
+    const weak_retention_stats after = weak_retention::stats();
+    EXPECT_EQ(after.blocks, before.blocks);
+    EXPECT_EQ(after.bytes, before.bytes);
+}
+
+TEST_F(SharedPtrTest, RawPointerConstructorWithDeleterAndAllocator) {
+    Derived::destructor_count = 0;
+    int deleter_count = 0;
+    AllocationCounts counts;
+    {
+        auto deleter = [&deleter_count](Derived *p) {
+            deleter_count++;
+            delete p;
+        };
+        shared_ptr<Derived> ptr(new Derived(5), deleter, CountingAllocator<Derived>(&counts));
+        EXPECT_EQ(ptr->value, 5);
+        EXPECT_EQ(counts.allocations, 1);
+
+        ptr.reset(new Derived(6), deleter, CountingAllocator<Derived>(&counts));
+        EXPECT_EQ(ptr->value, 6);
+        EXPECT_EQ(deleter_count, 1);
+        EXPECT_EQ(counts.allocations, 2);
+        EXPECT_EQ(counts.deallocations, 1);
+    }
+    EXPECT_EQ(deleter_count, 2);
+    EXPECT_EQ(Derived::destructor_count, 2);
+    EXPECT_EQ(counts.deallocations, 2);
+}
+
+// ============================================================================
+// ARRAYS
+// ============================================================================
+
+TEST_F(SharedPtrTest, RawArrayPointerConstructor) {
+    static_assert(std::is_same_v<shared_ptr<int[]>::Element_Type, int>);
+    static_assert(std::is_same_v<shared_ptr<int[]>::Value_Type, int[]>);
+
+    Derived::destructor_count = 0;
+    {
+        // Released with delete[], which ASan checks in -Daddress builds
+        shared_ptr<Derived[]> ptr(new Derived[3]);
+        ptr[1].value = 7;
+        EXPECT_EQ(ptr[0].value, 42);
+        EXPECT_EQ(ptr.get()[1].value, 7);
+    }
+    EXPECT_EQ(Derived::destructor_count, 3);
+}
+
+TEST_F(SharedPtrTest, MakeSharedUnboundedArray) {
+    Derived::destructor_count = 0;
+    {
+        shared_ptr<Derived[]> ptr = make_shared<Derived[]>(4);
+        for (int i = 0; i < 4; ++i) {
+            EXPECT_EQ(ptr[i].value, 42);
+        }
+        ptr[3].value = 3;
+
+        shared_ptr<Derived[]> copy(ptr);
+        EXPECT_EQ(copy[3].value, 3);
+        EXPECT_EQ(ptr.use_count(), 2);
+    }
+    EXPECT_EQ(Derived::destructor_count, 4);
+
+    shared_ptr<int[]> ints = make_shared<int[]>(3, 9);
+    EXPECT_EQ(ints[0], 9);
+    EXPECT_EQ(ints[2], 9);
+
+    shared_ptr<int[]> empty = make_shared<int[]>(0);
+    EXPECT_TRUE(empty);
+    EXPECT_EQ(empty.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, MakeSharedBoundedArray) {
+    shared_ptr<int[8]> zeros = make_shared<int[8]>();
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ(zeros[i], 0);
+    }
+
+    shared_ptr<int[2]> filled = make_shared<int[2]>(5);
+    EXPECT_EQ(filled[0], 5);
+    EXPECT_EQ(filled[1], 5);
+}
+
+TEST_F(SharedPtrTest, ArrayElementsShareTheControlBlockAllocation) {
+    struct alignas(64) Sample {
+        float values[4];
+    };
+
+    AllocationCounts counts;
+    weak_ptr<Sample[]> wptr;
+    {
+        shared_ptr<Sample[]> ptr =
+            allocate_shared<Sample[]>(CountingAllocator<Sample>(&counts), 16);
+        EXPECT_EQ(counts.allocations, 1);
+        EXPECT_GE(counts.bytes, 16 * sizeof(Sample));
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(ptr.get()) % alignof(Sample), 0u);
+        wptr = ptr;
+    }
+    EXPECT_TRUE(wptr.expired());
+    EXPECT_EQ(counts.deallocations, 0);
+    wptr.reset();
+    EXPECT_EQ(counts.deallocations, 1);
+}
+
+// Element type whose third construction throws.
+struct Throwing {
+    static int live;
+
+    Throwing() {
+        if (live == 2) {
+            throw 1;
+        }
+        live++;
+    }
+    ~Throwing() { live--; }
+};
+
+int Throwing::live = 0;
+
+TEST_F(SharedPtrTest, ArrayElementConstructorThrows) {
+    Throwing::live = 0;
+
+    AllocationCounts counts;
+    EXPECT_THROW((void)allocate_shared<Throwing[]>(CountingAllocator<Throwing>(&counts), 5), int);
+    // The two constructed elements and the block are released
+    EXPECT_EQ(Throwing::live, 0);
+    EXPECT_EQ(counts.allocations, 1);
+    EXPECT_EQ(counts.deallocations, 1);
+}
+
+TEST_F(SharedPtrTest, MakeSharedForOverwrite) {
+    Derived::destructor_count = 0;
+    {
+        // Types with a constructor are still default-initialized
+        shared_ptr<Derived> single = make_shared_for_overwrite<Derived>();
+        EXPECT_EQ(single->value, 42);
+
+        shared_ptr<Derived[]> many = make_shared_for_overwrite<Derived[]>(2);
+        EXPECT_EQ(many[1].value, 42);
+
+        shared_ptr<double[4]> bounded = make_shared_for_overwrite<double[4]>();
+        bounded[3] = 1.5;
+        EXPECT_EQ(bounded[3], 1.5);
+    }
+    EXPECT_EQ(Derived::destructor_count, 3);
+
+    shared_ptr<unsigned char[]> buffer = make_shared_for_overwrite<unsigned char[]>(1 << 16);
+    buffer[0] = 1;
+    buffer[(1 << 16) - 1] = 2;
+    EXPECT_EQ(buffer[0] + buffer[(1 << 16) - 1], 3);
+}
+
 // ============================================================================
 // WEAK_PTR TESTS
 // ============================================================================
@@ -607,4 +1053,695 @@ TEST_F(SharedPtrTest, SharedPtrFromWeakPtr) {
     EXPECT_EQ(Derived::destructor_count, 2);
 }
 
+// ============================================================================
+// CONVERSIONS AND CASTS
+// ============================================================================
+
+struct Animal {
+    int legs = 4;
+    static int destructor_count;
+
+    virtual ~Animal() { destructor_count++; }
+};
+
+int Animal::destructor_count = 0;
+
+struct Tagged {
+    int tag = 9;
+};
+
+// Tagged is not the first base, so converting to it adjusts the pointer
+struct Dog : Animal, Tagged {
+    int barks = 0;
+};
+
+struct Cat : Animal {};
+
+TEST_F(SharedPtrTest, ConvertingCopyConstructor) {
+    Animal::destructor_count = 0;
+    {
+        shared_ptr<Dog> dog = make_shared<Dog>();
+        shared_ptr<Animal> animal(dog);
+        shared_ptr<const Dog> constant = dog;
+        EXPECT_EQ(animal.get(), static_cast<Animal *>(dog.get()));
+        EXPECT_EQ(dog.use_count(), 3);
+
+        shared_ptr<Tagged> tagged = dog;
+        EXPECT_EQ(tagged.get(), static_cast<Tagged *>(dog.get()));
+        EXPECT_EQ(tagged->tag, 9);
+    }
+    EXPECT_EQ(Animal::destructor_count, 1);
+}
+
+TEST_F(SharedPtrTest, ConvertingMoveConstructor) {
+    Animal::destructor_count = 0;
+    {
+        shared_ptr<Dog> dog(new Dog);
+        Dog *raw = dog.get();
+        shared_ptr<Tagged> tagged(std::move(dog));
+        EXPECT_EQ(dog.get(), nullptr);
+        EXPECT_EQ(dog.use_count(), 0);
+        EXPECT_EQ(tagged.use_count(), 1);
+        EXPECT_EQ(tagged.get(), static_cast<Tagged *>(raw));
+    }
+    // The block still deletes the Dog it was created for
+    EXPECT_EQ(Animal::destructor_count, 1);
+}
+
+TEST_F(SharedPtrTest, ConvertingAssignment) {
+    shared_ptr<Dog> dog = make_shared<Dog>();
+    shared_ptr<Animal> animal;
+    animal = dog;
+    EXPECT_EQ(dog.use_count(), 2);
+    animal = shared_ptr<Cat>(new Cat);
+    EXPECT_EQ(dog.use_count(), 1);
+    EXPECT_EQ(animal.use_count(), 1);
+    animal = std::move(dog);
+    EXPECT_FALSE(dog);
+    EXPECT_EQ(animal.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, ConvertingArrays) {
+    shared_ptr<int[4]> bounded = make_shared<int[4]>(1);
+    shared_ptr<const int[]> unbounded = bounded;
+    EXPECT_EQ(unbounded[3], 1);
+    EXPECT_EQ(bounded.use_count(), 2);
+}
+
+TEST_F(SharedPtrTest, AliasMoveConstructorEmptiesTheSource) {
+    shared_ptr<Dog> dog = make_shared<Dog>();
+    shared_ptr<int> legs(std::move(dog), &dog->legs);
+    EXPECT_EQ(dog.get(), nullptr);
+    EXPECT_EQ(dog.use_count(), 0);
+    EXPECT_EQ(*legs, 4);
+    EXPECT_EQ(legs.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, StaticPointerCast) {
+    shared_ptr<Animal> animal = make_shared<Dog>();
+    shared_ptr<Dog> dog = static_pointer_cast<Dog>(animal);
+    EXPECT_EQ(dog.use_count(), 2);
+    EXPECT_EQ(static_cast<Animal *>(dog.get()), animal.get());
+
+    shared_ptr<Tagged> tagged = static_pointer_cast<Tagged>(std::move(dog));
+    EXPECT_FALSE(dog);
+    EXPECT_EQ(animal.use_count(), 2);
+    EXPECT_EQ(tagged->tag, 9);
+}
+
+TEST_F(SharedPtrTest, DynamicPointerCast) {
+    shared_ptr<Animal> animal = make_shared<Dog>();
+    EXPECT_TRUE(dynamic_pointer_cast<Dog>(animal));
+    EXPECT_FALSE(dynamic_pointer_cast<Cat>(animal));
+    EXPECT_EQ(animal.use_count(), 1);
+
+    // A failed cast leaves the source untouched
+    shared_ptr<Cat> cat = dynamic_pointer_cast<Cat>(std::move(animal));
+    EXPECT_FALSE(cat);
+    EXPECT_EQ(cat.use_count(), 0);
+    EXPECT_TRUE(animal);
+    EXPECT_EQ(animal.use_count(), 1);
+
+    shared_ptr<Dog> dog = dynamic_pointer_cast<Dog>(std::move(animal));
+    EXPECT_TRUE(dog);
+    EXPECT_FALSE(animal);
+    EXPECT_EQ(dog.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, ConstAndReinterpretPointerCast) {
+    shared_ptr<const Dog> constant = make_shared<Dog>();
+    shared_ptr<Dog> mutable_dog = const_pointer_cast<Dog>(constant);
+    mutable_dog->barks = 3;
+    EXPECT_EQ(constant->barks, 3);
+    EXPECT_EQ(constant.use_count(), 2);
+
+    shared_ptr<unsigned char> bytes =
+        reinterpret_pointer_cast<unsigned char>(std::move(mutable_dog));
+    EXPECT_EQ(static_cast<const void *>(bytes.get()), static_cast<const void *>(constant.get()));
+    EXPECT_EQ(constant.use_count(), 2);
+}
+
+TEST_F(SharedPtrTest, WeakPtrConversions) {
+    shared_ptr<Dog> dog = make_shared<Dog>();
+    weak_ptr<Dog> weak_dog = dog;
+    weak_ptr<Tagged> weak_tagged = weak_dog;
+    EXPECT_EQ(weak_tagged.lock().get(), static_cast<Tagged *>(dog.get()));
+
+    weak_ptr<Animal> weak_animal = dog;
+    weak_ptr<const Animal> weak_const(std::move(weak_animal));
+    EXPECT_TRUE(weak_animal.expired());
+    EXPECT_EQ(weak_const.lock().get(), static_cast<Animal *>(dog.get()));
+
+    dog.reset();
+    // Converting an expired weak_ptr keeps the block but not the pointer
+    weak_ptr<Tagged> expired = weak_dog;
+    EXPECT_TRUE(expired.expired());
+    EXPECT_FALSE(expired.lock());
+}
+
+// ============================================================================
+// FROM UNIQUE_PTR
+// ============================================================================
+
+/// Deleter that may be moved but not copied, counting the moves.
+struct MoveOnlyDeleter {
+    int *d_moves;
+    int *d_calls;
+
+    MoveOnlyDeleter(int *moves, int *calls) : d_moves(moves), d_calls(calls) {}
+    MoveOnlyDeleter(const MoveOnlyDeleter &) = delete;
+    MoveOnlyDeleter(MoveOnlyDeleter &&rhs) noexcept : d_moves(rhs.d_moves), d_calls(rhs.d_calls) {
+        (*d_moves)++;
+    }
+
+    void operator()(Dog *dog) const {
+        (*d_calls)++;
+        delete dog;
+    }
+};
+
+TEST_F(SharedPtrTest, FromUniquePtrTakesOwnership) {
+    Animal::destructor_count = 0;
+    unique_ptr<Dog> unique = make_unique<Dog>();
+    Dog *raw = unique.get();
+
+    shared_ptr<Tagged> tagged(std::move(unique));
+    EXPECT_EQ(unique.get(), nullptr);
+    EXPECT_EQ(tagged.get(), static_cast<Tagged *>(raw));
+    EXPECT_EQ(tagged.use_count(), 1);
+
+    // The block deletes the Dog, not the Tagged base, which has no virtual
+    // destructor
+    tagged.reset();
+    EXPECT_EQ(Animal::destructor_count, 1);
+
+    shared_ptr<Animal> animal;
+    animal = make_unique<Cat>();
+    EXPECT_EQ(animal.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, FromUniquePtrMovesTheDeleter) {
+    int moves = 0;
+    int calls = 0;
+    {
+        unique_ptr<Dog, MoveOnlyDeleter> unique(new Dog, MoveOnlyDeleter(&moves, &calls));
+        moves = 0;
+        shared_ptr<Dog> ptr(std::move(unique));
+        // Straight into the block
+        EXPECT_EQ(moves, 1);
+        shared_ptr<Dog> copy = ptr;
+        EXPECT_EQ(calls, 0);
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST_F(SharedPtrTest, FromUniquePtrKeepsDeleterIfAllocationFails) {
+    int calls = 0;
+    Dog *raw = new Dog;
+    unique_ptr<Dog, std::function<void(Dog *)>> unique(raw, [&calls](Dog *dog) {
+        calls++;
+        delete dog;
+    });
+    ASSERT_FALSE(control_block_pool::enabled_by_default());
+    {
+        failing_allocation_scope failing;
+        EXPECT_THROW((void)shared_ptr<Dog>(std::move(unique)), std::bad_alloc);
+    }
+
+    // Still owned, with a deleter that can be called
+    EXPECT_EQ(unique.get(), raw);
+    EXPECT_TRUE(unique.get_deleter());
+    unique.reset();
+    EXPECT_EQ(calls, 1);
+}
+
+TEST_F(SharedPtrTest, FromUniquePtrKeepsReferenceDeleter) {
+    int moves = 0;
+    int calls = 0;
+    MoveOnlyDeleter deleter(&moves, &calls);
+    {
+        unique_ptr<Dog, MoveOnlyDeleter &> unique(new Dog, deleter);
+        shared_ptr<Dog> ptr(std::move(unique));
+    }
+    EXPECT_EQ(moves, 0);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST_F(SharedPtrTest, FromUniquePtrArrayAndEmpty) {
+    Animal::destructor_count = 0;
+    {
+        shared_ptr<Animal[]> array(make_unique<Animal[]>(3));
+        EXPECT_EQ(array[2].legs, 4);
+    }
+    EXPECT_EQ(Animal::destructor_count, 3);
+
+    shared_ptr<Dog> empty(unique_ptr<Dog>{});
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(empty.use_count(), 0);
+}
+
+// ============================================================================
+// ENABLE_SHARED_FROM_THIS
+// ============================================================================
+
+struct Widget : enable_shared_from_this<Widget> {
+    int value;
+    static int destructor_count;
+
+    explicit Widget(int v = 0) : value(v) {}
+    ~Widget() { destructor_count++; }
+};
+
+int Widget::destructor_count = 0;
+
+struct Gadget : Widget {
+    explicit Gadget(int v) : Widget(v) {}
+};
+
+TEST_F(SharedPtrTest, SharedFromThisRawPointer) {
+    Widget::destructor_count = 0;
+    {
+        Widget *raw = new Widget(1);
+        shared_ptr<Widget> ptr(raw);
+        shared_ptr<Widget> self = raw->shared_from_this();
+        EXPECT_EQ(self.get(), raw);
+        EXPECT_EQ(ptr.use_count(), 2);
+    }
+    EXPECT_EQ(Widget::destructor_count, 1);
+}
+
+TEST_F(SharedPtrTest, SharedFromThisWithDeleter) {
+    int deleter_count = 0;
+    {
+        shared_ptr<Widget> ptr(new Widget(2), [&deleter_count](Widget *p) {
+            deleter_count++;
+            delete p;
+        });
+        EXPECT_EQ(ptr->shared_from_this().use_count(), 2);
+    }
+    EXPECT_EQ(deleter_count, 1);
+}
+
+TEST_F(SharedPtrTest, SharedFromThisMakeSharedAllocatesOnce) {
+    Widget::destructor_count = 0;
+    AllocationCounts counts;
+    {
+        shared_ptr<Widget> ptr = allocate_shared<Widget>(CountingAllocator<Widget>(&counts), 3);
+        shared_ptr<Widget> self = ptr->shared_from_this();
+        EXPECT_EQ(self.get(), ptr.get());
+        EXPECT_EQ(ptr.use_count(), 2);
+        EXPECT_EQ(counts.allocations, 1);
+
+        shared_ptr<Widget> made = make_shared<Widget>(4);
+        EXPECT_EQ(made->shared_from_this().use_count(), 2);
+    }
+    // The embedded weak_ptr does not keep the object or its block alive
+    EXPECT_EQ(Widget::destructor_count, 2);
+    EXPECT_EQ(counts.deallocations, 1);
+}
+
+TEST_F(SharedPtrTest, SharedFromThisThroughDerivedType) {
+    shared_ptr<Gadget> ptr = make_shared<Gadget>(5);
+    shared_ptr<Widget> self = ptr->shared_from_this();
+    EXPECT_EQ(self.get(), ptr.get());
+    EXPECT_EQ(self->value, 5);
+    EXPECT_EQ(ptr.use_count(), 2);
+}
+
+TEST_F(SharedPtrTest, SharedFromThisConst) {
+    shared_ptr<Widget> ptr = make_shared<Widget>(6);
+    const Widget &widget = *ptr;
+    shared_ptr<const Widget> self = widget.shared_from_this();
+    EXPECT_EQ(self->value, 6);
+    EXPECT_EQ(ptr.use_count(), 2);
+
+    weak_ptr<const Widget> weak = widget.weak_from_this();
+    EXPECT_FALSE(weak.expired());
+    EXPECT_EQ(ptr.use_count(), 2);
+}
+
+TEST_F(SharedPtrTest, WeakFromThis) {
+    Widget unowned(7);
+    EXPECT_TRUE(unowned.weak_from_this().expired());
+
+    weak_ptr<Widget> weak;
+    {
+        shared_ptr<Widget> ptr = make_shared<Widget>(8);
+        weak = ptr->weak_from_this();
+        EXPECT_EQ(weak.lock().get(), ptr.get());
+
+        // A copy of the object is not owned by ptr
+        Widget copy(*ptr);
+        EXPECT_TRUE(copy.weak_from_this().expired());
+    }
+    EXPECT_TRUE(weak.expired());
+}
+
+// ============================================================================
+// COMPARISONS AND HASHING
+// ============================================================================
+
+TEST_F(SharedPtrTest, ComparisonOperators) {
+    shared_ptr<Derived[2]> pair = make_shared<Derived[2]>();
+    shared_ptr<Derived> first(pair, &pair[0]);
+    shared_ptr<Derived> second(pair, &pair[1]);
+    shared_ptr<Derived> same = first;
+    shared_ptr<const Derived> other_type = first;
+    shared_ptr<Derived> empty;
+
+    EXPECT_TRUE(first == same);
+    EXPECT_TRUE(first == other_type);
+    EXPECT_TRUE(first != second);
+    EXPECT_TRUE(first < second);
+    EXPECT_TRUE(second >= first);
+    EXPECT_EQ(first <=> same, std::strong_ordering::equal);
+
+    EXPECT_TRUE(empty == nullptr);
+    EXPECT_TRUE(nullptr == empty);
+    EXPECT_TRUE(first != nullptr);
+    EXPECT_EQ(empty <=> nullptr, std::strong_ordering::equal);
+    EXPECT_TRUE(nullptr < first);
+}
+
+TEST_F(SharedPtrTest, StdHashMatchesEquality) {
+    shared_ptr<Derived> ptr = make_shared<Derived>(1);
+    shared_ptr<Derived> copy = ptr;
+    EXPECT_EQ(std::hash<shared_ptr<Derived>>()(ptr), std::hash<shared_ptr<Derived>>()(copy));
+    EXPECT_EQ(std::hash<shared_ptr<Derived>>()(ptr), std::hash<Derived *>()(ptr.get()));
+
+    std::unordered_set<shared_ptr<Derived>> set{ptr, copy, make_shared<Derived>(2)};
+    EXPECT_EQ(set.size(), 2u);
+    EXPECT_EQ(set.count(copy), 1u);
+}
+
+TEST_F(SharedPtrTest, OwnerBeforeUsesTheControlBlock) {
+    shared_ptr<Derived[2]> pair = make_shared<Derived[2]>();
+    shared_ptr<Derived> first(pair, &pair[0]);
+    shared_ptr<Derived> second(pair, &pair[1]);
+    shared_ptr<Derived> unrelated = make_shared<Derived>(3);
+    weak_ptr<Derived> observer = second;
+
+    // Aliases of one block are equivalent, while their pointers differ
+    EXPECT_FALSE(first.owner_before(second));
+    EXPECT_FALSE(second.owner_before(first));
+    EXPECT_FALSE(first.owner_before(observer));
+    EXPECT_FALSE(observer.owner_before(pair));
+    EXPECT_TRUE(first.owner_equal(observer));
+    EXPECT_TRUE(observer.owner_equal(pair));
+    EXPECT_EQ(first.owner_hash(), observer.owner_hash());
+
+    EXPECT_NE(first.owner_before(unrelated), unrelated.owner_before(first));
+    EXPECT_FALSE(first.owner_equal(unrelated));
+
+    // Nothing is read through the block, so an expired weak_ptr still works
+    weak_ptr<Derived> expired = make_shared<Derived>(4);
+    EXPECT_TRUE(expired.expired());
+    EXPECT_TRUE(expired.owner_equal(expired));
+    EXPECT_FALSE(expired.owner_equal(weak_ptr<Derived>()));
+    EXPECT_TRUE(weak_ptr<Derived>().owner_equal(shared_ptr<Derived>()));
+}
+
+TEST_F(SharedPtrTest, OwnerLessKeysSortedContainers) {
+    shared_ptr<Derived> ptr = make_shared<Derived>(1);
+    shared_ptr<Derived> other = make_shared<Derived>(2);
+
+    std::map<weak_ptr<Derived>, int, owner_less<weak_ptr<Derived>>> by_weak;
+    by_weak[ptr] = 1;
+    by_weak[other] = 2;
+    by_weak[weak_ptr<Derived>(ptr)] = 3;
+    EXPECT_EQ(by_weak.size(), 2u);
+    EXPECT_EQ(by_weak.at(ptr), 3);
+    EXPECT_TRUE(owner_less<shared_ptr<Derived>>()(ptr, other) ||
+                owner_less<shared_ptr<Derived>>()(other, ptr));
+
+    // The transparent form looks weak_ptr keys up by shared_ptr directly
+    std::set<weak_ptr<Derived>, owner_less<>> set{ptr, other};
+    EXPECT_EQ(set.count(other), 1u);
+    EXPECT_NE(set.find(ptr), set.end());
+}
+
+TEST_F(SharedPtrTest, OwnerHashKeysUnorderedContainers) {
+    shared_ptr<Derived> ptr = make_shared<Derived>(1);
+    shared_ptr<Derived> alias(ptr, nullptr);
+
+    std::unordered_map<weak_ptr<Derived>, int, owner_hash, owner_equal> cache;
+    cache[ptr] = 1;
+    cache[alias] = 2;
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.find(ptr)->second, 2);
+
+    // std::hash<weak_ptr> hashes by owner as well
+    EXPECT_EQ(std::hash<weak_ptr<Derived>>()(ptr), ptr.owner_hash());
+    std::unordered_set<weak_ptr<Derived>, std::hash<weak_ptr<Derived>>, owner_equal> set{ptr};
+    EXPECT_EQ(set.count(alias), 1u);
+    ptr.reset();
+    alias.reset();
+    EXPECT_EQ(set.size(), 1u);
+    EXPECT_TRUE(set.begin()->expired());
+}
+
+// ============================================================================
+// BATCHED REFERENCE COUNTING
+// ============================================================================
+
+// Output iterator whose third assignment throws, as a full buffer would.
+template <typename T> struct ThrowingSink {
+    using difference_type = std::ptrdiff_t;
+
+    std::vector<shared_ptr<T>> *out;
+    int *assignments;
+
+    ThrowingSink &operator*() { return *this; }
+    ThrowingSink &operator++() { return *this; }
+    ThrowingSink operator++(int) { return *this; }
+    ThrowingSink &operator=(shared_ptr<T> ptr) {
+        if (++*assignments == 3) {
+            throw std::runtime_error("sink full");
+        }
+        out->push_back(std::move(ptr));
+        return *this;
+    }
+};
+
+TEST_F(SharedPtrTest, ShareNTakesAllReferencesAtOnce) {
+    shared_ptr<Derived> source = make_shared<Derived>(5);
+    std::vector<shared_ptr<Derived>> subscribers;
+    share_n(source, 16, std::back_inserter(subscribers));
+
+    ASSERT_EQ(subscribers.size(), 16u);
+    EXPECT_EQ(source.use_count(), 17);
+    for (const auto &subscriber : subscribers) {
+        EXPECT_EQ(subscriber, source);
+        EXPECT_FALSE(subscriber.owner_before(source) || source.owner_before(subscriber));
+    }
+    subscribers.clear();
+    EXPECT_EQ(source.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, ShareNIntoExistingHandles) {
+    shared_ptr<Derived> source = make_shared<Derived>(5);
+    shared_ptr<Derived> other = make_shared<Derived>(6);
+    std::vector<shared_ptr<Derived>> slots(4, other);
+    auto end = share_n(source, slots.size(), slots.begin());
+    EXPECT_EQ(end, slots.end());
+    EXPECT_EQ(source.use_count(), 5);
+    EXPECT_EQ(other.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, ShareNOfEmptyOrNone) {
+    std::vector<shared_ptr<Derived>> out;
+    share_n(shared_ptr<Derived>(), 3, std::back_inserter(out));
+    ASSERT_EQ(out.size(), 3u);
+    EXPECT_FALSE(out[0]);
+    EXPECT_EQ(out[2].use_count(), 0);
+
+    shared_ptr<Derived> source = make_shared<Derived>();
+    share_n(source, 0, std::back_inserter(out));
+    EXPECT_EQ(out.size(), 3u);
+    EXPECT_EQ(source.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, ShareNGivesBackReferencesItCouldNotHandOut) {
+    shared_ptr<Derived> source = make_shared<Derived>();
+    std::vector<shared_ptr<Derived>> out;
+    int assignments = 0;
+    EXPECT_THROW(share_n(source, 8, ThrowingSink<Derived>{&out, &assignments}), std::runtime_error);
+    EXPECT_EQ(out.size(), 2u);
+    EXPECT_EQ(source.use_count(), 3);
+    out.clear();
+    EXPECT_EQ(source.use_count(), 1);
+}
+
+TEST_F(SharedPtrTest, ReleaseNDropsRunsOfOneBlock) {
+    shared_ptr<Derived> a = make_shared<Derived>(1);
+    shared_ptr<Derived> b = make_shared<Derived>(2);
+    std::vector<shared_ptr<Derived>> handles{a, a, b, nullptr, b, b, a};
+    EXPECT_EQ(a.use_count(), 4);
+    EXPECT_EQ(b.use_count(), 4);
+
+    auto end = release_n(handles.begin(), handles.size());
+    EXPECT_EQ(end, handles.end());
+    EXPECT_EQ(a.use_count(), 1);
+    EXPECT_EQ(b.use_count(), 1);
+    for (const auto &handle : handles) {
+        EXPECT_FALSE(handle);
+        EXPECT_EQ(handle.use_count(), 0);
+    }
+}
+
+TEST_F(SharedPtrTest, ReleaseNOfLastOwnersDisposesOnce) {
+    Derived::destructor_count = 0;
+    std::vector<shared_ptr<Derived>> subscribers;
+    {
+        shared_ptr<Derived> source(new Derived(3));
+        share_n(source, 8, std::back_inserter(subscribers));
+    }
+    weak_ptr<Derived> observer = subscribers.front();
+    release_n(subscribers.begin(), 7);
+    EXPECT_EQ(Derived::destructor_count, 0);
+    EXPECT_EQ(observer.use_count(), 1);
+    release_n(subscribers.begin() + 7, 1);
+    EXPECT_EQ(Derived::destructor_count, 1);
+    EXPECT_TRUE(observer.expired());
+}
+
+TEST_F(SharedPtrTest, ShareNKeepsSharedFromThis) {
+    struct Node : enable_shared_from_this<Node> {};
+    shared_ptr<Node> source = make_shared<Node>();
+    std::vector<shared_ptr<Node>> out;
+    share_n(source, 2, std::back_inserter(out));
+    EXPECT_EQ(out[1]->shared_from_this(), source);
+    EXPECT_EQ(source.use_count(), 3);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(SharedPtrTest, ConcurrentCopyAndRelease) {
+    Derived::destructor_count = 0;
+    {
+        shared_ptr<Derived> source(new Derived(42));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < k_stress_threads; ++t) {
+            threads.emplace_back([&source] {
+                for (int i = 0; i < k_stress_rounds; ++i) {
+                    shared_ptr<Derived> copy(source);
+                    EXPECT_EQ(copy->value, 42);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        EXPECT_EQ(source.use_count(), 1);
+        EXPECT_EQ(Derived::destructor_count, 0);
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
+TEST_F(SharedPtrTest, ConcurrentLastOwnerRelease) {
+    // Every owner releases at the same time, exactly one of them must
+    // dispose of the object and free the control block.
+    Derived::destructor_count = 0;
+    for (int i = 0; i < k_stress_rounds / 10; ++i) {
+        std::vector<shared_ptr<Derived>> owners(k_stress_threads, make_shared<Derived>(i));
+        std::latch start(k_stress_threads);
+        std::vector<std::thread> threads;
+        for (auto &owner : owners) {
+            threads.emplace_back([&owner, &start] {
+                start.arrive_and_wait();
+                owner.reset();
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(Derived::destructor_count, k_stress_rounds / 10);
+}
+
+TEST_F(SharedPtrTest, ConcurrentSharedAndWeakRelease) {
+    // The last shared_ptr and the last weak_ptr go away on different threads,
+    // the control block must be freed exactly once.
+    Derived::destructor_count = 0;
+    for (int i = 0; i < k_stress_rounds / 10; ++i) {
+        shared_ptr<Derived> owner(new Derived(i));
+        weak_ptr<Derived> observer(owner);
+        std::latch start(2);
+        std::thread strong([&owner, &start] {
+            start.arrive_and_wait();
+            owner.reset();
+        });
+        std::thread weak([&observer, &start] {
+            start.arrive_and_wait();
+            observer.reset();
+        });
+        strong.join();
+        weak.join();
+    }
+    EXPECT_EQ(Derived::destructor_count, k_stress_rounds / 10);
+}
+
+TEST_F(SharedPtrTest, ConcurrentLockWhileExpiring) {
+    // lock() racing with the last release either fails or returns an owner
+    // that keeps the object alive, it never resurrects a disposed object.
+    Derived::destructor_count = 0;
+    for (int i = 0; i < k_stress_rounds / 10; ++i) {
+        shared_ptr<Derived> owner = make_shared<Derived>(7);
+        weak_ptr<Derived> observer(owner);
+        std::latch start(2);
+        std::thread releaser([&owner, &start] {
+            start.arrive_and_wait();
+            owner.reset();
+        });
+        std::thread locker([&observer, &start] {
+            start.arrive_and_wait();
+            for (int attempt = 0; attempt < 16; ++attempt) {
+                if (shared_ptr<Derived> ptr = observer.lock()) {
+                    EXPECT_EQ(ptr->value, 7);
+                }
+            }
+        });
+        releaser.join();
+        locker.join();
+        EXPECT_TRUE(observer.expired());
+    }
+    EXPECT_EQ(Derived::destructor_count, k_stress_rounds / 10);
+}
+
+TEST_F(SharedPtrTest, ConcurrentFanOut) {
+    // Batches taken and dropped by several threads while others copy one
+    // at a time; the last of them frees the object once.
+    Derived::destructor_count = 0;
+    {
+        std::latch start(k_stress_threads);
+        std::vector<std::thread> threads;
+        {
+            shared_ptr<Derived> source = make_shared<Derived>(9);
+            for (int t = 0; t < k_stress_threads; ++t) {
+                threads.emplace_back([copy = source, &start, t]() mutable {
+                    start.arrive_and_wait();
+                    std::vector<shared_ptr<Derived>> batch;
+                    for (int i = 0; i < k_stress_rounds / 10; ++i) {
+                        if (t % 2 == 0) {
+                            share_n(copy, 16, std::back_inserter(batch));
+                            EXPECT_EQ(batch.back()->value, 9);
+                            release_n(batch.begin(), batch.size());
+                            batch.clear();
+                        } else {
+                            shared_ptr<Derived> one(copy);
+                            EXPECT_EQ(one->value, 9);
+                        }
+                    }
+                });
+            }
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    EXPECT_EQ(Derived::destructor_count, 1);
+}
+
 } // namespace ksl
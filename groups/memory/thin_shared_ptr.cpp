@@ -0,0 +1 @@
+#include <thin_shared_ptr.h>
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <relocate.h>
+#include <shared_ptr.h>
+
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// THIN SHARED POINTER DEFINITION
+// ============================================================================
+
+/// A shared_ptr to a make_shared object in one word instead of two. The
+/// object of a make_shared block sits at a fixed offset from the block, so
+/// the handle keeps only the block and adds the offset on every access:
+/// an index of handles takes half the memory, for one add per dereference.
+///
+/// It shares the object with shared_ptr and weak_ptr, counting in the same
+/// block: it converts to a shared_ptr, try_from() converts back where the
+/// layout allows, and it hands out weak_ptrs. A shared_ptr from one made by
+/// make_thin_shared always converts back, whatever its size.
+template <typename T> class thin_shared_ptr {
+    static_assert(!std::is_array_v<T>, "thin_shared_ptr holds a single object");
+
+    control_block_base *d_cb;
+
+    [[nodiscard]] T *object() const noexcept {
+        return reinterpret_cast<T *>(reinterpret_cast<char *>(d_cb) + k_object_offset);
+    }
+
+    /// Adopts a shared reference to cb's make_shared object.
+    explicit thin_shared_ptr(control_block_base *cb) noexcept : d_cb(cb) {}
+
+  public:
+    using Value_Type = T;
+
+    /// Where a make_shared block keeps its object: after the counters, at
+    /// the object's alignment. The allocator is stored after the object.
+    static constexpr std::size_t k_object_offset =
+        (sizeof(control_block_base) + alignof(T) - 1) / alignof(T) * alignof(T);
+
+    /// Whether ptr can be held: it is empty, or points at the object at
+    /// k_object_offset in its block. That is what make_shared gives below
+    /// the inline limit; split and padded_layout blocks, owned raw pointers
+    /// and aliases to anything but that object are not.
+    [[nodiscard]] static bool can_hold(const shared_ptr<T> &ptr) noexcept {
+        const control_block_base *cb = shared_ptr_access::block(ptr);
+        return !cb || reinterpret_cast<const char *>(cb) + k_object_offset ==
+                          reinterpret_cast<const char *>(ptr.get());
+    }
+
+    /// CONSTRUCTORS
+    constexpr thin_shared_ptr() noexcept : d_cb(nullptr) {}
+
+    constexpr thin_shared_ptr(std::nullptr_t) noexcept : d_cb(nullptr) {}
+
+    /// FACTORIES
+    /// A handle sharing ptr's object, or an empty one if can_hold(ptr)
+    /// rejects it: a handle to anything but a make_shared object would
+    /// find its object at the wrong address.
+    [[nodiscard]] static thin_shared_ptr try_from(const shared_ptr<T> &ptr) noexcept {
+        if (!can_hold(ptr)) {
+            return thin_shared_ptr();
+        }
+        control_block_base *cb = shared_ptr_access::block(ptr);
+        if (cb) {
+            cb->increment_shared_count();
+        }
+        return thin_shared_ptr(cb);
+    }
+
+    /// Takes over ptr's reference and leaves it empty, or gives an empty
+    /// handle and leaves ptr untouched if can_hold(ptr) rejects it.
+    [[nodiscard]] static thin_shared_ptr try_from(shared_ptr<T> &&ptr) noexcept {
+        if (!can_hold(ptr)) {
+            return thin_shared_ptr();
+        }
+        KSL_MEMORY_TRACE_MOVE();
+        return thin_shared_ptr(shared_ptr_access::detach(ptr));
+    }
+
+    thin_shared_ptr(const thin_shared_ptr &rhs) noexcept : d_cb(rhs.d_cb) {
+        if (d_cb) {
+            d_cb->increment_shared_count();
+        }
+    }
+
+    thin_shared_ptr(thin_shared_ptr &&rhs) noexcept : d_cb(std::exchange(rhs.d_cb, nullptr)) {
+        KSL_MEMORY_TRACE_MOVE();
+    }
+
+    thin_shared_ptr &operator=(const thin_shared_ptr &rhs) noexcept {
+        thin_shared_ptr(rhs).swap(*this);
+        return *this;
+    }
+
+    thin_shared_ptr &operator=(thin_shared_ptr &&rhs) noexcept {
+        thin_shared_ptr(std::move(rhs)).swap(*this);
+        return *this;
+    }
+
+    ~thin_shared_ptr() {
+        if (d_cb) {
+            d_cb->release_shared();
+        }
+    }
+
+    /// CONVERSIONS
+    /// A shared_ptr sharing the object.
+    [[nodiscard]] operator shared_ptr<T>() const & noexcept {
+        if (d_cb) {
+            d_cb->increment_shared_count();
+        }
+        return shared_ptr_access::share<T>(get(), d_cb);
+    }
+
+    /// Moves the reference to a shared_ptr, leaving this empty.
+    [[nodiscard]] operator shared_ptr<T>() && noexcept {
+        KSL_MEMORY_TRACE_MOVE();
+        T *ptr = get();
+        return shared_ptr_access::share<T>(ptr, std::exchange(d_cb, nullptr));
+    }
+
+    /// A weak_ptr to the object, taken without touching the shared count.
+    /// Its lock() gives a shared_ptr that try_from() accepts. A conversion
+    /// would make shared_ptr(thin) ambiguous with shared_ptr(weak_ptr).
+    [[nodiscard]] weak_ptr<T> weak() const noexcept {
+        return shared_ptr_access::weaken<T>(get(), d_cb);
+    }
+
+    /// ACCESSORS
+    [[nodiscard]] T *get() const noexcept { return d_cb ? object() : nullptr; }
+
+    [[nodiscard]] T &operator*() const noexcept {
+        assert(d_cb != nullptr && "Attempted to dereference a null thin_shared_ptr");
+        return *object();
+    }
+
+    [[nodiscard]] T *operator->() const noexcept {
+        assert(d_cb != nullptr && "Attempted to dereference a null thin_shared_ptr");
+        return object();
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return d_cb != nullptr; }
+
+    /// OBSERVERS
+    [[nodiscard]] std::size_t use_count() const noexcept {
+        return d_cb ? d_cb->shared_count() : 0;
+    }
+
+    /// MODIFIERS
+    void reset() noexcept { thin_shared_ptr().swap(*this); }
+
+    void swap(thin_shared_ptr &other) noexcept { std::swap(d_cb, other.d_cb); }
+    friend void swap(thin_shared_ptr &lhs, thin_shared_ptr &rhs) noexcept { lhs.swap(rhs); }
+
+    /// COMPARISONS
+    /// By the object, like shared_ptr. Each block has one object, so the
+    /// block's address stands in for it.
+    friend bool operator==(const thin_shared_ptr &lhs, const thin_shared_ptr &rhs) noexcept {
+        return lhs.d_cb == rhs.d_cb;
+    }
+
+    friend std::strong_ordering operator<=>(const thin_shared_ptr &lhs,
+                                            const thin_shared_ptr &rhs) noexcept {
+        return std::compare_three_way()(lhs.d_cb, rhs.d_cb);
+    }
+
+    friend bool operator==(const thin_shared_ptr &lhs, std::nullptr_t) noexcept { return !lhs; }
+};
+
+// ============================================================================
+// MAKE_THIN_SHARED IMPLEMENTATION
+// ============================================================================
+
+/// Creates the object inline in its control block, in one allocation made
+/// with alloc, or from numa_arena like allocate_shared. It stays inline
+/// above k_make_shared_inline_limit too, so a weak_ptr to a large object
+/// keeps all of it allocated.
+template <typename Y, typename Alloc, typename... Args>
+    requires(!std::is_array_v<Y>)
+thin_shared_ptr<Y> allocate_thin_shared(const Alloc &alloc, Args &&...args) {
+    return with_preferred_node(alloc, [&]<typename Placed>(const Placed &placed) {
+        auto cb = allocate_control_block<control_block_make_shared_impl<Y, Placed>>(
+            placed, placed, std::forward<Args>(args)...);
+        Y *ptr = reinterpret_cast<Y *>(cb->d_storage);
+        return thin_shared_ptr<Y>::try_from(shared_ptr_access::adopt<Y>(ptr, cb));
+    });
+}
+
+template <typename Y, typename... Args>
+    requires(!std::is_array_v<Y>)
+thin_shared_ptr<Y> make_thin_shared(Args &&...args) {
+    return allocate_thin_shared<Y>(std::allocator<Y>(), std::forward<Args>(args)...);
+}
+
+/// One pointer, to the block.
+template <typename T> struct is_trivially_relocatable<thin_shared_ptr<T>> : std::true_type {};
+
+} // namespace ksl
+
+/// Hashes the object's address, as std::hash<ksl::shared_ptr<T>> does.
+template <typename T> struct std::hash<ksl::thin_shared_ptr<T>> {
+    std::size_t operator()(const ksl::thin_shared_ptr<T> &ptr) const noexcept {
+        return std::hash<T *>()(ptr.get());
+    }
+};
@@ -0,0 +1,242 @@
+// Component being tested
+#include <thin_shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <latch>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ksl {
+
+class ThinSharedPtrTest : public ::testing::Test {
+  protected:
+    struct Node {
+        int value;
+        static int destructor_count;
+
+        explicit Node(int v = 7) : value(v) {}
+        ~Node() { destructor_count++; }
+    };
+
+    struct alignas(64) Wide {
+        int value = 3;
+    };
+
+    struct Large {
+        std::array<std::byte, 2 * k_make_shared_inline_limit> bytes{};
+    };
+
+    void SetUp() override { Node::destructor_count = 0; }
+};
+
+int ThinSharedPtrTest::Node::destructor_count = 0;
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+TEST_F(ThinSharedPtrTest, IsOnePointer) {
+    EXPECT_EQ(sizeof(thin_shared_ptr<Node>), sizeof(void *));
+    EXPECT_EQ(sizeof(shared_ptr<Node>), 2 * sizeof(void *));
+    EXPECT_TRUE(is_trivially_relocatable_v<thin_shared_ptr<Node>>);
+}
+
+TEST_F(ThinSharedPtrTest, FindsTheObjectOfMakeShared) {
+    EXPECT_TRUE(thin_shared_ptr<Node>::can_hold(make_shared<Node>()));
+    EXPECT_TRUE(thin_shared_ptr<char>::can_hold(make_shared<char>('a')));
+    EXPECT_TRUE(thin_shared_ptr<Wide>::can_hold(make_shared<Wide>()));
+    EXPECT_TRUE(thin_shared_ptr<Node>::can_hold(shared_ptr<Node>()));
+
+    auto shared = make_shared<Wide>();
+    auto thin = thin_shared_ptr<Wide>::try_from(shared);
+    EXPECT_EQ(thin.get(), shared.get());
+    EXPECT_EQ(thin->value, 3);
+}
+
+TEST_F(ThinSharedPtrTest, RejectsOtherBlocks) {
+    EXPECT_FALSE(thin_shared_ptr<Node>::can_hold(shared_ptr<Node>(new Node())));
+    EXPECT_FALSE(thin_shared_ptr<Large>::can_hold(make_shared<Large>()));
+    EXPECT_FALSE(thin_shared_ptr<Node>::can_hold(ksl::allocate_shared<Node>(
+        padded_layout, std::allocator<Node>())));
+
+    auto pair = make_shared<std::pair<int, int>>(1, 2);
+    EXPECT_FALSE(thin_shared_ptr<int>::can_hold(shared_ptr<int>(pair, &pair->second)));
+}
+
+TEST_F(ThinSharedPtrTest, TryFromRejectsOtherBlocks) {
+    // Checked in every build, not only with assertions enabled
+    auto large = make_shared<Large>();
+    EXPECT_FALSE(thin_shared_ptr<Large>::try_from(large));
+    EXPECT_EQ(large.use_count(), 1u);
+
+    auto raw = shared_ptr<Node>(new Node());
+    EXPECT_FALSE(thin_shared_ptr<Node>::try_from(std::move(raw)));
+    EXPECT_TRUE(raw);
+    EXPECT_EQ(raw.use_count(), 1u);
+
+    auto padded = make_shared<Node>(padded_layout);
+    EXPECT_FALSE(thin_shared_ptr<Node>::try_from(padded));
+
+    auto pair = make_shared<std::pair<int, int>>(1, 2);
+    EXPECT_FALSE(thin_shared_ptr<int>::try_from(shared_ptr<int>(pair, &pair->second)));
+    EXPECT_EQ(pair.use_count(), 1u);
+    EXPECT_EQ(Node::destructor_count, 0);
+}
+
+// ============================================================================
+// OWNERSHIP
+// ============================================================================
+
+TEST_F(ThinSharedPtrTest, MakeThinShared) {
+    {
+        auto thin = make_thin_shared<Node>(11);
+        EXPECT_TRUE(thin);
+        EXPECT_EQ(thin->value, 11);
+        EXPECT_EQ((*thin).value, 11);
+        EXPECT_EQ(thin.use_count(), 1u);
+    }
+    EXPECT_EQ(Node::destructor_count, 1);
+}
+
+TEST_F(ThinSharedPtrTest, LargeObjectsStayInline) {
+    auto thin = make_thin_shared<Large>();
+    shared_ptr<Large> shared = thin;
+    EXPECT_TRUE(thin_shared_ptr<Large>::can_hold(shared));
+    EXPECT_EQ(shared.get(), thin.get());
+}
+
+TEST_F(ThinSharedPtrTest, CopyAndMove) {
+    auto a = make_thin_shared<Node>();
+    thin_shared_ptr<Node> b = a;
+    EXPECT_EQ(a.use_count(), 2u);
+    EXPECT_EQ(a, b);
+
+    thin_shared_ptr<Node> c = std::move(b);
+    EXPECT_FALSE(b);
+    EXPECT_EQ(b, nullptr);
+    EXPECT_EQ(c.use_count(), 2u);
+
+    c = make_thin_shared<Node>(5);
+    EXPECT_EQ(a.use_count(), 1u);
+    EXPECT_NE(a, c);
+
+    a = c;
+    EXPECT_EQ(Node::destructor_count, 1);
+    a.reset();
+    c = nullptr;
+    EXPECT_EQ(Node::destructor_count, 2);
+}
+
+TEST_F(ThinSharedPtrTest, NullHandle) {
+    thin_shared_ptr<Node> thin;
+    EXPECT_FALSE(thin);
+    EXPECT_EQ(thin.get(), nullptr);
+    EXPECT_EQ(thin.use_count(), 0u);
+
+    shared_ptr<Node> shared = thin;
+    EXPECT_FALSE(shared);
+    EXPECT_TRUE(thin.weak().expired());
+    EXPECT_FALSE(thin_shared_ptr<Node>::try_from(shared_ptr<Node>()));
+}
+
+// ============================================================================
+// CONVERSIONS
+// ============================================================================
+
+TEST_F(ThinSharedPtrTest, ToAndFromSharedPtr) {
+    auto shared = make_shared<Node>(4);
+    auto thin = thin_shared_ptr<Node>::try_from(shared);
+    EXPECT_EQ(shared.use_count(), 2u);
+
+    shared_ptr<Node> back = thin;
+    EXPECT_EQ(back, shared);
+    EXPECT_EQ(shared.use_count(), 3u);
+
+    shared_ptr<Node> moved = std::move(thin);
+    EXPECT_FALSE(thin);
+    EXPECT_EQ(shared.use_count(), 3u);
+
+    auto taken = thin_shared_ptr<Node>::try_from(std::move(moved));
+    EXPECT_FALSE(moved);
+    EXPECT_EQ(taken.get(), shared.get());
+    EXPECT_EQ(shared.use_count(), 3u);
+}
+
+TEST_F(ThinSharedPtrTest, WeakPtrSharesTheBlock) {
+    weak_ptr<Node> weak;
+    {
+        auto thin = make_thin_shared<Node>(9);
+        weak = thin.weak();
+        EXPECT_EQ(weak.use_count(), 1u);
+
+        auto locked = thin_shared_ptr<Node>::try_from(weak.lock());
+        EXPECT_EQ(locked, thin);
+        EXPECT_EQ(thin.use_count(), 2u);
+    }
+    EXPECT_TRUE(weak.expired());
+    EXPECT_EQ(Node::destructor_count, 1);
+    EXPECT_FALSE(weak.lock());
+}
+
+struct ThinSelf : enable_shared_from_this<ThinSelf> {};
+
+TEST_F(ThinSharedPtrTest, EnablesSharedFromThis) {
+    auto thin = make_thin_shared<ThinSelf>();
+    shared_ptr<ThinSelf> self = thin->shared_from_this();
+    EXPECT_EQ(self.get(), thin.get());
+    EXPECT_EQ(thin.use_count(), 2u);
+}
+
+TEST_F(ThinSharedPtrTest, HashesLikeSharedPtr) {
+    auto thin = make_thin_shared<Node>();
+    shared_ptr<Node> shared = thin;
+    EXPECT_EQ(std::hash<thin_shared_ptr<Node>>()(thin), std::hash<shared_ptr<Node>>()(shared));
+
+    std::unordered_set<thin_shared_ptr<Node>> set;
+    set.insert(thin);
+    set.insert(thin_shared_ptr<Node>::try_from(shared));
+    set.insert(make_thin_shared<Node>());
+    EXPECT_EQ(set.size(), 2u);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(ThinSharedPtrTest, ConcurrentCopiesWithSharedPtrs) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 2000;
+    auto thin = make_thin_shared<Node>(1);
+    std::latch start(k_threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&start, &thin, t] {
+            start.arrive_and_wait();
+            for (int i = 0; i < k_rounds; ++i) {
+                if (t % 2 == 0) {
+                    thin_shared_ptr<Node> copy = thin;
+                    EXPECT_EQ(copy->value, 1);
+                } else {
+                    shared_ptr<Node> copy = thin;
+                    auto again = thin_shared_ptr<Node>::try_from(std::move(copy));
+                    EXPECT_EQ(again->value, 1);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(thin.use_count(), 1u);
+    EXPECT_EQ(Node::destructor_count, 0);
+}
+
+} // namespace ksl
@@ -0,0 +1 @@
+#include <unique_ptr.h>
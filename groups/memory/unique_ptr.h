@@ -0,0 +1,242 @@
+#pragma once
+
+#include <relocate.h>
+
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+namespace {
+/// A unique_ptr<Y, E> can be converted to a unique_ptr<T, D>: derived to
+/// base or adding cv-qualifiers, but never between an array and a
+/// non-array, or to an array of a different element type.
+template <typename Y, typename T>
+concept UniqueConvertible =
+    !std::is_bounded_array_v<Y> && std::is_array_v<Y> == std::is_array_v<T> &&
+    (std::is_array_v<T> ? std::is_convertible_v<std::remove_extent_t<Y> (*)[],
+                                                std::remove_extent_t<T> (*)[]>
+                        : std::is_convertible_v<Y *, T *>);
+} // namespace
+
+// ============================================================================
+// UNIQUE POINTER DEFINITION
+// ============================================================================
+
+/// Sole ownership of an object, or of an array for T = U[], destroyed with
+/// Deleter when the handle goes. A stateless Deleter takes no space, so the
+/// default unique_ptr is exactly one pointer wide and, once inlined, its
+/// operations compile to what the raw pointer code would.
+///
+/// Deleter may be an lvalue reference, in which case the handle refers to a
+/// deleter owned elsewhere.
+template <typename T, typename Deleter = std::default_delete<T>> class unique_ptr {
+    std::remove_extent_t<T> *d_ptr;
+    [[no_unique_address]] Deleter d_deleter;
+
+    template <typename Y, typename E> friend class unique_ptr;
+
+  public:
+    using Value_Type = T;
+    using Element_Type = std::remove_extent_t<T>;
+    using Deleter_Type = Deleter;
+
+  public:
+    /// CONSTRUCTORS
+    constexpr unique_ptr() noexcept
+        requires(std::is_default_constructible_v<Deleter> && !std::is_pointer_v<Deleter>)
+        : d_ptr(nullptr), d_deleter() {}
+
+    constexpr unique_ptr(std::nullptr_t) noexcept
+        requires(std::is_default_constructible_v<Deleter> && !std::is_pointer_v<Deleter>)
+        : unique_ptr() {}
+
+    /// Takes ownership of ptr.
+    explicit unique_ptr(Element_Type *ptr) noexcept
+        requires(std::is_default_constructible_v<Deleter> && !std::is_pointer_v<Deleter>)
+        : d_ptr(ptr), d_deleter() {}
+
+    /// Takes ownership of ptr, to be destroyed with deleter. A reference
+    /// Deleter binds to deleter instead of copying it.
+    unique_ptr(Element_Type *ptr, Deleter deleter) noexcept(
+        std::is_nothrow_move_constructible_v<Deleter> || std::is_reference_v<Deleter>)
+        : d_ptr(ptr), d_deleter(std::forward<Deleter>(deleter)) {}
+
+    unique_ptr(const unique_ptr &) = delete;
+
+    unique_ptr(unique_ptr &&rhs) noexcept
+        : d_ptr(std::exchange(rhs.d_ptr, nullptr)),
+          d_deleter(std::forward<Deleter>(rhs.d_deleter)) {}
+
+    /// Converting move constructor, e.g. unique_ptr<Derived> to
+    /// unique_ptr<Base>. The deleter is moved along with the pointer.
+    template <typename Y, typename E>
+        requires UniqueConvertible<Y, T> &&
+                 (std::is_reference_v<Deleter> ? std::is_same_v<E, Deleter>
+                                               : std::is_convertible_v<E, Deleter>)
+    unique_ptr(unique_ptr<Y, E> &&rhs) noexcept
+        : d_ptr(std::exchange(rhs.d_ptr, nullptr)), d_deleter(std::forward<E>(rhs.d_deleter)) {}
+
+    /// DESTRUCTORS
+    ~unique_ptr() {
+        if (d_ptr) {
+            d_deleter(d_ptr);
+        }
+    }
+
+    /// ASSIGNMENT
+    unique_ptr &operator=(const unique_ptr &) = delete;
+
+    unique_ptr &operator=(unique_ptr &&rhs) noexcept {
+        reset(rhs.release());
+        d_deleter = std::forward<Deleter>(rhs.d_deleter);
+        return *this;
+    }
+
+    template <typename Y, typename E>
+        requires UniqueConvertible<Y, T> && std::is_assignable_v<Deleter &, E &&>
+    unique_ptr &operator=(unique_ptr<Y, E> &&rhs) noexcept {
+        reset(rhs.release());
+        d_deleter = std::forward<E>(rhs.d_deleter);
+        return *this;
+    }
+
+    unique_ptr &operator=(std::nullptr_t) noexcept {
+        reset();
+        return *this;
+    }
+
+  public:
+    // ACCESSORS
+    [[nodiscard]] inline Element_Type *get() const noexcept { return d_ptr; }
+
+    [[nodiscard]] inline Deleter &get_deleter() noexcept { return d_deleter; }
+
+    [[nodiscard]] inline const Deleter &get_deleter() const noexcept { return d_deleter; }
+
+    [[nodiscard]] Element_Type &operator*() const noexcept
+        requires(!std::is_array_v<T>)
+    {
+        assert(d_ptr != nullptr && "Attempted to dereference a null unique_ptr");
+        return *(get());
+    }
+
+    [[nodiscard]] Element_Type *operator->() const noexcept
+        requires(!std::is_array_v<T>)
+    {
+        return get();
+    }
+
+    [[nodiscard]] Element_Type &operator[](std::size_t index) const noexcept
+        requires std::is_array_v<T>
+    {
+        assert(d_ptr != nullptr && "Attempted to index a null unique_ptr");
+        return get()[index];
+    }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return get() != nullptr; }
+
+  public:
+    // MODIFIERS
+    /// Gives up ownership without destroying the object and returns it.
+    [[nodiscard]] inline Element_Type *release() noexcept { return std::exchange(d_ptr, nullptr); }
+
+    /// Takes ownership of ptr, then destroys the previous object. The handle
+    /// already holds ptr when the old object's destructor runs.
+    inline void reset(Element_Type *ptr = nullptr) noexcept {
+        Element_Type *old = std::exchange(d_ptr, ptr);
+        if (old) {
+            d_deleter(old);
+        }
+    }
+
+    inline void swap(unique_ptr &ptr) noexcept {
+        std::swap(d_ptr, ptr.d_ptr);
+        std::swap(d_deleter, ptr.d_deleter);
+    }
+};
+
+// ============================================================================
+// COMPARISONS
+// ============================================================================
+
+template <typename T, typename D, typename U, typename E>
+[[nodiscard]] bool operator==(const unique_ptr<T, D> &lhs, const unique_ptr<U, E> &rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template <typename T, typename D, typename U, typename E>
+[[nodiscard]] std::strong_ordering operator<=>(const unique_ptr<T, D> &lhs,
+                                               const unique_ptr<U, E> &rhs) noexcept {
+    return std::compare_three_way()(lhs.get(), rhs.get());
+}
+
+template <typename T, typename D>
+[[nodiscard]] bool operator==(const unique_ptr<T, D> &lhs, std::nullptr_t) noexcept {
+    return !lhs;
+}
+
+template <typename T, typename D>
+[[nodiscard]] std::strong_ordering operator<=>(const unique_ptr<T, D> &lhs,
+                                               std::nullptr_t) noexcept {
+    return std::compare_three_way()(
+        lhs.get(), static_cast<typename unique_ptr<T, D>::Element_Type *>(nullptr));
+}
+
+// ============================================================================
+// MAKE_UNIQUE IMPLEMENTATION
+// ============================================================================
+
+template <typename Y, typename... Args>
+    requires(!std::is_array_v<Y>)
+unique_ptr<Y> make_unique(Args &&...args) {
+    return unique_ptr<Y>(new Y(std::forward<Args>(args)...));
+}
+
+/// size value-initialized elements.
+template <typename Y>
+    requires std::is_unbounded_array_v<Y>
+unique_ptr<Y> make_unique(std::size_t size) {
+    return unique_ptr<Y>(new std::remove_extent_t<Y>[size]());
+}
+
+template <typename Y, typename... Args>
+    requires std::is_bounded_array_v<Y>
+void make_unique(Args &&...) = delete;
+
+/// Default-initializes the object, leaving trivial types uninitialized for
+/// the caller to overwrite.
+template <typename Y>
+    requires(!std::is_array_v<Y>)
+unique_ptr<Y> make_unique_for_overwrite() {
+    return unique_ptr<Y>(new Y);
+}
+
+template <typename Y>
+    requires std::is_unbounded_array_v<Y>
+unique_ptr<Y> make_unique_for_overwrite(std::size_t size) {
+    return unique_ptr<Y>(new std::remove_extent_t<Y>[size]);
+}
+
+template <typename Y, typename... Args>
+    requires std::is_bounded_array_v<Y>
+void make_unique_for_overwrite(Args &&...) = delete;
+
+/// Relocatable with the deleter: a reference deleter is just a pointer.
+template <typename T, typename Deleter>
+struct is_trivially_relocatable<unique_ptr<T, Deleter>>
+    : std::bool_constant<std::is_reference_v<Deleter> || is_trivially_relocatable_v<Deleter>> {};
+
+} // namespace ksl
+
+/// Hashes the held pointer, consistently with operator==.
+template <typename T, typename D> struct std::hash<ksl::unique_ptr<T, D>> {
+    std::size_t operator()(const ksl::unique_ptr<T, D> &ptr) const noexcept {
+        return std::hash<typename ksl::unique_ptr<T, D>::Element_Type *>()(ptr.get());
+    }
+};
@@ -0,0 +1,250 @@
+// Component being tested
+#include <unique_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <set>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace ksl {
+
+class UniquePtrTest : public ::testing::Test {
+  protected:
+    struct Base {
+        int value;
+        static int destructor_count;
+
+        explicit Base(int v = 42) : value(v) {}
+        virtual ~Base() { destructor_count++; }
+    };
+
+    struct Derived : Base {
+        explicit Derived(int v = 7) : Base(v) {}
+    };
+
+    /// Stateful, move-only deleter recording what it destroys.
+    struct RecordingDeleter {
+        std::vector<int> *d_deleted;
+
+        explicit RecordingDeleter(std::vector<int> *deleted) : d_deleted(deleted) {}
+        RecordingDeleter(RecordingDeleter &&) = default;
+        RecordingDeleter &operator=(RecordingDeleter &&) = default;
+
+        void operator()(Base *ptr) const {
+            d_deleted->push_back(ptr->value);
+            delete ptr;
+        }
+    };
+
+    void SetUp() override { Base::destructor_count = 0; }
+};
+
+int UniquePtrTest::Base::destructor_count = 0;
+
+// ============================================================================
+// LAYOUT
+// ============================================================================
+
+TEST_F(UniquePtrTest, StatelessDeleterTakesNoSpace) {
+    auto lambda = [](int *ptr) { delete ptr; };
+
+    EXPECT_EQ(sizeof(unique_ptr<int>), sizeof(int *));
+    EXPECT_EQ(sizeof(unique_ptr<int[]>), sizeof(int *));
+    EXPECT_EQ(sizeof(unique_ptr<int, decltype(lambda)>), sizeof(int *));
+    EXPECT_GT(sizeof(unique_ptr<Base, RecordingDeleter>), sizeof(Base *));
+    EXPECT_TRUE(std::is_nothrow_move_constructible_v<unique_ptr<int>>);
+    EXPECT_FALSE(std::is_copy_constructible_v<unique_ptr<int>>);
+    EXPECT_FALSE(std::is_copy_assignable_v<unique_ptr<int>>);
+}
+
+// ============================================================================
+// CONSTRUCTORS
+// ============================================================================
+
+TEST_F(UniquePtrTest, DefaultIsEmpty) {
+    unique_ptr<Base> ptr;
+    unique_ptr<Base> null(nullptr);
+    EXPECT_EQ(ptr.get(), nullptr);
+    EXPECT_FALSE(ptr);
+    EXPECT_FALSE(null);
+}
+
+TEST_F(UniquePtrTest, DestroysOnScopeExit) {
+    {
+        unique_ptr<Base> ptr(new Base(1));
+        EXPECT_TRUE(ptr);
+        EXPECT_EQ(ptr->value, 1);
+        EXPECT_EQ((*ptr).value, 1);
+    }
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+TEST_F(UniquePtrTest, MoveTransfersOwnership) {
+    unique_ptr<Base> ptr = make_unique<Base>(2);
+    Base *raw = ptr.get();
+
+    unique_ptr<Base> moved(std::move(ptr));
+    EXPECT_EQ(ptr.get(), nullptr);
+    EXPECT_EQ(moved.get(), raw);
+
+    unique_ptr<Base> assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(moved.get(), nullptr);
+    EXPECT_EQ(assigned.get(), raw);
+    EXPECT_EQ(Base::destructor_count, 0);
+
+    assigned = nullptr;
+    EXPECT_EQ(Base::destructor_count, 1);
+}
+
+TEST_F(UniquePtrTest, ConvertsDerivedToBase) {
+    unique_ptr<Derived> derived = make_unique<Derived>(3);
+    unique_ptr<Base> base(std::move(derived));
+    EXPECT_EQ(derived.get(), nullptr);
+    EXPECT_EQ(base->value, 3);
+
+    unique_ptr<Base> assigned = make_unique<Base>(4);
+    assigned = make_unique<Derived>(5);
+    EXPECT_EQ(Base::destructor_count, 1);
+    EXPECT_EQ(assigned->value, 5);
+
+    EXPECT_FALSE((std::is_constructible_v<unique_ptr<Derived>, unique_ptr<Base> &&>));
+    EXPECT_FALSE((std::is_constructible_v<unique_ptr<Base[]>, unique_ptr<Derived[]> &&>));
+    EXPECT_TRUE((std::is_constructible_v<unique_ptr<const int[]>, unique_ptr<int[]> &&>));
+}
+
+// ============================================================================
+// DELETERS
+// ============================================================================
+
+TEST_F(UniquePtrTest, StatefulDeleterIsMovedAlong) {
+    std::vector<int> deleted;
+    {
+        unique_ptr<Base, RecordingDeleter> ptr(new Base(1), RecordingDeleter(&deleted));
+        unique_ptr<Base, RecordingDeleter> moved(std::move(ptr));
+        EXPECT_EQ(moved.get_deleter().d_deleted, &deleted);
+    }
+    EXPECT_EQ(deleted, (std::vector<int>{1}));
+}
+
+TEST_F(UniquePtrTest, ReferenceDeleterIsNotCopied) {
+    std::vector<int> deleted;
+    RecordingDeleter deleter(&deleted);
+    {
+        unique_ptr<Base, RecordingDeleter &> ptr(new Base(2), deleter);
+        EXPECT_EQ(&ptr.get_deleter(), &deleter);
+    }
+    EXPECT_EQ(deleted, (std::vector<int>{2}));
+}
+
+TEST_F(UniquePtrTest, ResetAndRelease) {
+    unique_ptr<Base> ptr = make_unique<Base>(1);
+    ptr.reset(new Base(2));
+    EXPECT_EQ(Base::destructor_count, 1);
+    EXPECT_EQ(ptr->value, 2);
+
+    Base *raw = ptr.release();
+    EXPECT_EQ(ptr.get(), nullptr);
+    EXPECT_EQ(Base::destructor_count, 1);
+    delete raw;
+
+    ptr.reset();
+    EXPECT_EQ(Base::destructor_count, 2);
+}
+
+TEST_F(UniquePtrTest, ResetHoldsNewPointerDuringOldDestructor) {
+    using handle = unique_ptr<int, void (*)(int *)>;
+    static handle *s_owner = nullptr;
+    static int *s_seen = nullptr;
+
+    handle ptr(new int(1), [](int *old) {
+        s_seen = s_owner->get();
+        delete old;
+    });
+    s_owner = &ptr;
+    int *replacement = new int(2);
+    ptr.reset(replacement);
+    EXPECT_EQ(s_seen, replacement);
+}
+
+TEST_F(UniquePtrTest, Swap) {
+    unique_ptr<Base> a = make_unique<Base>(1);
+    unique_ptr<Base> b = make_unique<Base>(2);
+    a.swap(b);
+    EXPECT_EQ(a->value, 2);
+    EXPECT_EQ(b->value, 1);
+}
+
+// ============================================================================
+// ARRAYS
+// ============================================================================
+
+TEST_F(UniquePtrTest, ArrayUsesDeleteArray) {
+    {
+        unique_ptr<Base[]> array(new Base[3]);
+        array[1].value = 9;
+        EXPECT_EQ(array[0].value, 42);
+        EXPECT_EQ(array[1].value, 9);
+    }
+    EXPECT_EQ(Base::destructor_count, 3);
+}
+
+TEST_F(UniquePtrTest, MakeUniqueArrayValueInitializes) {
+    unique_ptr<int[]> array = make_unique<int[]>(4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(array[static_cast<std::size_t>(i)], 0);
+    }
+}
+
+// ============================================================================
+// MAKE_UNIQUE
+// ============================================================================
+
+TEST_F(UniquePtrTest, MakeUniqueForwardsArguments) {
+    unique_ptr<std::pair<int, double>> ptr = make_unique<std::pair<int, double>>(1, 2.5);
+    EXPECT_EQ(ptr->first, 1);
+    EXPECT_EQ(ptr->second, 2.5);
+}
+
+TEST_F(UniquePtrTest, MakeUniqueForOverwrite) {
+    unique_ptr<Base> object = make_unique_for_overwrite<Base>();
+    EXPECT_EQ(object->value, 42);
+
+    unique_ptr<int[]> array = make_unique_for_overwrite<int[]>(8);
+    for (std::size_t i = 0; i < 8; ++i) {
+        array[i] = static_cast<int>(i);
+    }
+    EXPECT_EQ(array[7], 7);
+}
+
+// ============================================================================
+// COMPARISONS AND HASHING
+// ============================================================================
+
+TEST_F(UniquePtrTest, ComparisonsFollowThePointer) {
+    unique_ptr<Base> a = make_unique<Base>(1);
+    unique_ptr<Base> b = make_unique<Base>(2);
+    unique_ptr<Base> empty;
+
+    EXPECT_TRUE(a == a);
+    EXPECT_FALSE(a == b);
+    EXPECT_TRUE(empty == nullptr);
+    EXPECT_TRUE(a != nullptr);
+    EXPECT_EQ(a < b, std::less<Base *>()(a.get(), b.get()));
+    EXPECT_EQ(std::hash<unique_ptr<Base>>()(a), std::hash<Base *>()(a.get()));
+
+    std::set<unique_ptr<Base>> sorted;
+    sorted.insert(std::move(a));
+    sorted.insert(std::move(b));
+    EXPECT_EQ(sorted.size(), 2u);
+
+    std::unordered_set<unique_ptr<Base>> hashed;
+    hashed.insert(make_unique<Base>(3));
+    EXPECT_EQ(hashed.size(), 1u);
+}
+
+} // namespace ksl
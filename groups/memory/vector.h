@@ -0,0 +1,196 @@
+#pragma once
+
+#include <relocate.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace ksl {
+
+// ============================================================================
+// VECTOR DEFINITION
+// ============================================================================
+
+/// A growable array, like std::vector for the operations it has, that
+/// moves its elements to new storage with relocate(): one memcpy for
+/// trivially relocatable types such as ksl::shared_ptr, where std::vector
+/// runs a move constructor and a destructor per element. Capacity doubles
+/// on growth.
+template <typename T> class vector {
+    static_assert(std::is_object_v<T> && !std::is_const_v<T>, "vector holds mutable objects");
+
+    T *d_begin = nullptr;
+    T *d_end = nullptr;
+    T *d_capacity = nullptr;
+
+    static T *allocate(std::size_t count) { return std::allocator<T>().allocate(count); }
+
+    static void deallocate(T *ptr, std::size_t count) noexcept {
+        if (ptr) {
+            std::allocator<T>().deallocate(ptr, count);
+        }
+    }
+
+    /// Moves the elements to new storage for capacity elements.
+    void reallocate(std::size_t capacity) {
+        T *storage = allocate(capacity);
+        T *end = storage;
+        try {
+            end = relocate(d_begin, d_end, storage);
+        } catch (...) {
+            deallocate(storage, capacity);
+            throw;
+        }
+        deallocate(d_begin, this->capacity());
+        d_begin = storage;
+        d_end = end;
+        d_capacity = storage + capacity;
+    }
+
+    [[nodiscard]] std::size_t grown_capacity() const noexcept {
+        return std::max<std::size_t>(2 * capacity(), 4);
+    }
+
+  public:
+    using Value_Type = T;
+
+    /// CONSTRUCTORS
+    vector() noexcept = default;
+
+    vector(std::initializer_list<T> values) : vector() {
+        reserve(values.size());
+        for (const T &value : values) {
+            push_back(value);
+        }
+    }
+
+    vector(const vector &other) : vector() {
+        reserve(other.size());
+        for (const T &value : other) {
+            push_back(value);
+        }
+    }
+
+    vector(vector &&other) noexcept
+        : d_begin(std::exchange(other.d_begin, nullptr)),
+          d_end(std::exchange(other.d_end, nullptr)),
+          d_capacity(std::exchange(other.d_capacity, nullptr)) {}
+
+    vector &operator=(const vector &other) {
+        if (this != &other) {
+            vector(other).swap(*this);
+        }
+        return *this;
+    }
+
+    vector &operator=(vector &&other) noexcept {
+        vector(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    ~vector() {
+        clear();
+        deallocate(d_begin, capacity());
+    }
+
+    /// CAPACITY
+    [[nodiscard]] std::size_t size() const noexcept {
+        return static_cast<std::size_t>(d_end - d_begin);
+    }
+    [[nodiscard]] std::size_t capacity() const noexcept {
+        return static_cast<std::size_t>(d_capacity - d_begin);
+    }
+    [[nodiscard]] bool empty() const noexcept { return d_begin == d_end; }
+
+    void reserve(std::size_t capacity) {
+        if (capacity > this->capacity()) {
+            reallocate(capacity);
+        }
+    }
+
+    /// MODIFIERS
+    /// Like std::vector, args may refer to an element: the new element is
+    /// made before the old ones move.
+    template <typename... Args> T &emplace_back(Args &&...args) {
+        if (d_end != d_capacity) {
+            std::construct_at(d_end, std::forward<Args>(args)...);
+            return *d_end++;
+        }
+
+        const std::size_t capacity = grown_capacity();
+        T *storage = allocate(capacity);
+        T *slot = storage + size();
+        try {
+            std::construct_at(slot, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(storage, capacity);
+            throw;
+        }
+        try {
+            relocate(d_begin, d_end, storage);
+        } catch (...) {
+            std::destroy_at(slot);
+            deallocate(storage, capacity);
+            throw;
+        }
+        deallocate(d_begin, this->capacity());
+        d_begin = storage;
+        d_end = slot + 1;
+        d_capacity = storage + capacity;
+        return *slot;
+    }
+
+    void push_back(const T &value) { emplace_back(value); }
+    void push_back(T &&value) { emplace_back(std::move(value)); }
+
+    void pop_back() noexcept {
+        assert(!empty() && "Attempted to pop from an empty vector");
+        std::destroy_at(--d_end);
+    }
+
+    /// Keeps the capacity.
+    void clear() noexcept {
+        std::destroy(d_begin, d_end);
+        d_end = d_begin;
+    }
+
+    void swap(vector &other) noexcept {
+        std::swap(d_begin, other.d_begin);
+        std::swap(d_end, other.d_end);
+        std::swap(d_capacity, other.d_capacity);
+    }
+    friend void swap(vector &lhs, vector &rhs) noexcept { lhs.swap(rhs); }
+
+    /// ACCESS
+    [[nodiscard]] T &operator[](std::size_t index) noexcept {
+        assert(index < size() && "Index out of bounds");
+        return d_begin[index];
+    }
+    [[nodiscard]] const T &operator[](std::size_t index) const noexcept {
+        assert(index < size() && "Index out of bounds");
+        return d_begin[index];
+    }
+
+    [[nodiscard]] T &front() noexcept { return (*this)[0]; }
+    [[nodiscard]] const T &front() const noexcept { return (*this)[0]; }
+    [[nodiscard]] T &back() noexcept { return (*this)[size() - 1]; }
+    [[nodiscard]] const T &back() const noexcept { return (*this)[size() - 1]; }
+
+    [[nodiscard]] T *data() noexcept { return d_begin; }
+    [[nodiscard]] const T *data() const noexcept { return d_begin; }
+
+    [[nodiscard]] T *begin() noexcept { return d_begin; }
+    [[nodiscard]] const T *begin() const noexcept { return d_begin; }
+    [[nodiscard]] T *end() noexcept { return d_end; }
+    [[nodiscard]] const T *end() const noexcept { return d_end; }
+};
+
+/// Three pointers into its own heap storage, never into itself.
+template <typename T> struct is_trivially_relocatable<vector<T>> : std::true_type {};
+
+} // namespace ksl
@@ -0,0 +1,158 @@
+// Component being tested
+#include <vector.h>
+
+#include <shared_ptr.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+
+namespace ksl {
+
+class VectorTest : public ::testing::Test {
+  protected:
+    /// Not trivially relocatable: growth moves and destroys each one.
+    struct Tracked {
+        std::string value;
+        static int moves;
+        static int live;
+
+        explicit Tracked(std::string v) : value(std::move(v)) { live++; }
+        Tracked(Tracked &&other) noexcept : value(std::move(other.value)) {
+            moves++;
+            live++;
+        }
+        Tracked(const Tracked &other) : value(other.value) { live++; }
+        ~Tracked() { live--; }
+    };
+
+    /// Copyable only, so growth copies it; the given copy throws.
+    struct ThrowingCopy {
+        int value;
+        static int copies;
+        static int throw_on;
+
+        explicit ThrowingCopy(int v) : value(v) {}
+        ThrowingCopy(const ThrowingCopy &other) : value(other.value) {
+            if (++copies == throw_on) {
+                throw std::runtime_error("copy failed");
+            }
+        }
+    };
+
+    void SetUp() override {
+        Tracked::moves = 0;
+        Tracked::live = 0;
+        ThrowingCopy::copies = 0;
+        ThrowingCopy::throw_on = 0;
+    }
+};
+
+int VectorTest::Tracked::moves = 0;
+int VectorTest::Tracked::live = 0;
+int VectorTest::ThrowingCopy::copies = 0;
+int VectorTest::ThrowingCopy::throw_on = 0;
+
+// ============================================================================
+// GROWTH
+// ============================================================================
+
+TEST_F(VectorTest, GrowthRelocatesHandlesWithoutTouchingCounts) {
+    shared_ptr<int> source = make_shared<int>(1);
+    vector<shared_ptr<int>> handles;
+    for (int i = 0; i < 1000; ++i) {
+        handles.push_back(source);
+    }
+    EXPECT_EQ(handles.size(), 1000u);
+    EXPECT_GE(handles.capacity(), 1000u);
+    EXPECT_EQ(source.use_count(), 1001);
+    EXPECT_EQ(handles[999], source);
+
+    handles.pop_back();
+    EXPECT_EQ(source.use_count(), 1000);
+    handles.clear();
+    EXPECT_EQ(source.use_count(), 1);
+    EXPECT_TRUE(handles.empty());
+}
+
+TEST_F(VectorTest, GrowthMovesOtherTypes) {
+    {
+        vector<Tracked> values;
+        values.reserve(4);
+        for (int i = 0; i < 5; ++i) {
+            values.emplace_back(std::to_string(i));
+        }
+        // The fifth element grew the storage, moving the first four
+        EXPECT_EQ(Tracked::moves, 4);
+        EXPECT_EQ(Tracked::live, 5);
+        EXPECT_EQ(values.front().value, "0");
+        EXPECT_EQ(values.back().value, "4");
+    }
+    EXPECT_EQ(Tracked::live, 0);
+}
+
+TEST_F(VectorTest, EmplaceMayReferToAnElement) {
+    vector<std::string> values{"first"};
+    while (values.size() != values.capacity()) {
+        values.push_back("filler");
+    }
+    // Full, so this push_back reallocates while reading values[0]
+    values.push_back(values[0]);
+    EXPECT_EQ(values.back(), "first");
+}
+
+TEST_F(VectorTest, ThrowingGrowthLeavesTheVector) {
+    vector<ThrowingCopy> values;
+    values.reserve(4);
+    for (int i = 0; i < 4; ++i) {
+        values.emplace_back(i);
+    }
+    const ThrowingCopy *before = values.data();
+
+    // The new element is made, then the second copy of an old one throws
+    ThrowingCopy::throw_on = 2;
+    EXPECT_THROW(values.emplace_back(4), std::runtime_error);
+    EXPECT_EQ(values.size(), 4u);
+    EXPECT_EQ(values.data(), before);
+    EXPECT_EQ(values[3].value, 3);
+}
+
+// ============================================================================
+// VALUE SEMANTICS
+// ============================================================================
+
+TEST_F(VectorTest, CopyAndMove) {
+    shared_ptr<int> source = make_shared<int>(2);
+    vector<shared_ptr<int>> first{source, source};
+    vector<shared_ptr<int>> copy = first;
+    EXPECT_EQ(source.use_count(), 5);
+
+    vector<shared_ptr<int>> moved = std::move(first);
+    EXPECT_TRUE(first.empty());
+    EXPECT_EQ(moved.size(), 2u);
+    EXPECT_EQ(source.use_count(), 5);
+
+    copy = moved;
+    EXPECT_EQ(source.use_count(), 5);
+    moved = vector<shared_ptr<int>>();
+    EXPECT_EQ(source.use_count(), 3);
+}
+
+TEST_F(VectorTest, NestedVectorsRelocate) {
+    static_assert(is_trivially_relocatable_v<vector<std::string>>);
+    vector<vector<std::string>> rows;
+    for (int i = 0; i < 100; ++i) {
+        rows.emplace_back();
+        rows.back().push_back(std::to_string(i));
+    }
+    EXPECT_EQ(rows[42][0], "42");
+    std::size_t total = 0;
+    for (const auto &row : rows) {
+        total += row.size();
+    }
+    EXPECT_EQ(total, 100u);
+}
+
+} // namespace ksl
@@ -0,0 +1 @@
+#include <weak_cache.h>
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <shared_ptr.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace ksl {
+
+/// Cache counters, summed shard by shard, so they may be slightly out of
+/// step with each other while the cache is in use. Hits are not counted:
+/// a shared counter would be written by every reader of a shard, which
+/// costs a lookup about half its time.
+struct weak_cache_stats {
+    /// get_or_create() calls that ran the factory.
+    std::size_t misses;
+    /// Sweeps run, amortized or through sweep().
+    std::size_t sweeps;
+    /// Expired entries the sweeps erased.
+    std::size_t swept;
+    /// Entries held, expired ones included until they are swept.
+    std::size_t size;
+};
+
+// ============================================================================
+// WEAK CACHE DEFINITION
+// ============================================================================
+
+/// Map from keys to values owned elsewhere: entries are weak_ptrs, so a
+/// value lives exactly as long as something outside the cache holds it,
+/// and a lookup either shares it or finds it gone.
+///
+/// Keys are striped over k_shard_count shards, each behind its own
+/// shared_mutex. Lookups of live values take the shard's lock shared;
+/// only inserting takes it exclusively. get_or_create() runs the factory
+/// under that exclusive lock, so racing callers for a key construct one
+/// value and all share it. The factory must not use the same cache, as
+/// its key's shard is locked.
+///
+/// Entries whose value has expired are erased by a sweep of their shard,
+/// run once the shard has seen as many inserts as it kept entries after
+/// the last sweep (and at least k_min_sweep_interval), which keeps the
+/// work per insert constant.
+template <typename K, typename V, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class weak_cache {
+    /// Keys of one stripe. Everything in it is guarded by its mutex.
+    struct alignas(padded_layout_t::k_cache_line) shard {
+        mutable std::shared_mutex d_mutex;
+        std::unordered_map<K, weak_ptr<V>, Hash, KeyEqual> d_entries;
+        std::size_t d_inserts_since_sweep = 0;
+        std::size_t d_next_sweep = k_min_sweep_interval;
+        std::size_t d_misses = 0;
+        std::size_t d_sweeps = 0;
+        std::size_t d_swept = 0;
+    };
+
+  public:
+    using Value_Type = V;
+    using Key_Type = K;
+
+    static constexpr std::size_t k_shard_count = 16;
+    /// Fewest inserts between two amortized sweeps of a shard.
+    static constexpr std::size_t k_min_sweep_interval = 64;
+
+    weak_cache() = default;
+    weak_cache(const weak_cache &) = delete;
+    weak_cache &operator=(const weak_cache &) = delete;
+
+    /// The live value cached for key, or an empty pointer.
+    [[nodiscard]] shared_ptr<V> get(const K &key) const {
+        const shard &stripe = shard_for(key);
+        std::shared_lock lock(stripe.d_mutex);
+        return find(stripe, key);
+    }
+
+    /// The live value cached for key, or the one factory() makes, which is
+    /// cached unless empty. A factory that throws leaves the cache as it
+    /// was.
+    template <typename Factory>
+        requires std::convertible_to<std::invoke_result_t<Factory &>, shared_ptr<V>>
+    [[nodiscard]] shared_ptr<V> get_or_create(const K &key, Factory &&factory) {
+        shard &stripe = shard_for(key);
+        {
+            std::shared_lock lock(stripe.d_mutex);
+            if (shared_ptr<V> value = find(stripe, key)) {
+                return value;
+            }
+        }
+
+        std::unique_lock lock(stripe.d_mutex);
+        // Another caller may have made it between the two locks
+        auto it = stripe.d_entries.find(key);
+        if (it != stripe.d_entries.end()) {
+            if (shared_ptr<V> value = it->second.lock()) {
+                return value;
+            }
+        }
+
+        shared_ptr<V> value = std::invoke(factory);
+        stripe.d_misses++;
+        if (!value) {
+            return value;
+        }
+        if (it != stripe.d_entries.end()) {
+            it->second = value;
+        } else {
+            stripe.d_entries.emplace(key, value);
+        }
+        if (++stripe.d_inserts_since_sweep >= stripe.d_next_sweep) {
+            sweep_locked(stripe);
+        }
+        return value;
+    }
+
+    /// Drops the entry for key, live or not; its value, if any, is not
+    /// affected. Returns whether there was one.
+    bool erase(const K &key) {
+        shard &stripe = shard_for(key);
+        std::unique_lock lock(stripe.d_mutex);
+        return stripe.d_entries.erase(key) != 0;
+    }
+
+    /// Erases every expired entry now. Returns how many there were.
+    std::size_t sweep() {
+        std::size_t erased = 0;
+        for (shard &stripe : d_shards) {
+            std::unique_lock lock(stripe.d_mutex);
+            erased += sweep_locked(stripe);
+        }
+        return erased;
+    }
+
+    void clear() {
+        for (shard &stripe : d_shards) {
+            std::unique_lock lock(stripe.d_mutex);
+            stripe.d_entries.clear();
+            stripe.d_inserts_since_sweep = 0;
+            stripe.d_next_sweep = k_min_sweep_interval;
+        }
+    }
+
+    /// Entries held, expired ones included until they are swept.
+    [[nodiscard]] std::size_t size() const {
+        std::size_t result = 0;
+        for (const shard &stripe : d_shards) {
+            std::shared_lock lock(stripe.d_mutex);
+            result += stripe.d_entries.size();
+        }
+        return result;
+    }
+
+    [[nodiscard]] weak_cache_stats stats() const {
+        weak_cache_stats result{};
+        for (const shard &stripe : d_shards) {
+            std::shared_lock lock(stripe.d_mutex);
+            result.misses += stripe.d_misses;
+            result.sweeps += stripe.d_sweeps;
+            result.swept += stripe.d_swept;
+            result.size += stripe.d_entries.size();
+        }
+        return result;
+    }
+
+  private:
+    shard d_shards[k_shard_count];
+    [[no_unique_address]] Hash d_hash;
+
+    /// The map buckets by the hash's low bits, so the stripe is picked from
+    /// the high bits of a mix of it, or each shard would use a fraction of
+    /// its buckets.
+    static std::size_t shard_index(const K &key, const Hash &hash) {
+        const auto mixed = static_cast<std::uint64_t>(hash(key)) * 0x9e3779b97f4a7c15ull;
+        return static_cast<std::size_t>(mixed >> (64 - 4));
+    }
+    static_assert(k_shard_count == 16, "shard_index() takes the top 4 bits");
+
+    shard &shard_for(const K &key) { return d_shards[shard_index(key, d_hash)]; }
+    const shard &shard_for(const K &key) const { return d_shards[shard_index(key, d_hash)]; }
+
+    /// Called with the shard's lock held, in either mode.
+    static shared_ptr<V> find(const shard &stripe, const K &key) {
+        auto it = stripe.d_entries.find(key);
+        if (it == stripe.d_entries.end()) {
+            return {};
+        }
+        return it->second.lock();
+    }
+
+    /// Called with the shard's lock held exclusively.
+    static std::size_t sweep_locked(shard &stripe) {
+        const std::size_t erased = std::erase_if(
+            stripe.d_entries, [](const auto &entry) { return entry.second.expired(); });
+        stripe.d_inserts_since_sweep = 0;
+        stripe.d_next_sweep = std::max(k_min_sweep_interval, stripe.d_entries.size());
+        stripe.d_sweeps++;
+        stripe.d_swept += erased;
+        return erased;
+    }
+};
+
+} // namespace ksl
@@ -0,0 +1,205 @@
+// Component being tested
+#include <weak_cache.h>
+
+// Testing framework
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ksl {
+
+class WeakCacheTest : public ::testing::Test {
+  protected:
+    struct Texture {
+        int id;
+        static std::atomic<int> constructor_count;
+        static std::atomic<int> destructor_count;
+
+        explicit Texture(int value) : id(value) { constructor_count++; }
+        ~Texture() { destructor_count++; }
+    };
+
+    void SetUp() override {
+        Texture::constructor_count = 0;
+        Texture::destructor_count = 0;
+    }
+};
+
+std::atomic<int> WeakCacheTest::Texture::constructor_count = 0;
+std::atomic<int> WeakCacheTest::Texture::destructor_count = 0;
+
+// ============================================================================
+// LOOKUP
+// ============================================================================
+
+TEST_F(WeakCacheTest, GetOrCreateSharesTheLiveValue) {
+    weak_cache<std::string, Texture> cache;
+    EXPECT_FALSE(cache.get("grass"));
+
+    shared_ptr<Texture> first =
+        cache.get_or_create("grass", [] { return make_shared<Texture>(1); });
+    shared_ptr<Texture> second =
+        cache.get_or_create("grass", [] { return make_shared<Texture>(2); });
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(second->id, 1);
+    EXPECT_EQ(cache.get("grass"), first);
+    EXPECT_EQ(Texture::constructor_count, 1);
+
+    const weak_cache_stats stats = cache.stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.size, 1u);
+}
+
+TEST_F(WeakCacheTest, CacheDoesNotOwnItsValues) {
+    weak_cache<int, Texture> cache;
+    shared_ptr<Texture> value = cache.get_or_create(7, [] { return make_shared<Texture>(7); });
+    value.reset();
+
+    // Gone with its last owner, though the entry stays until swept
+    EXPECT_EQ(Texture::destructor_count, 1);
+    EXPECT_FALSE(cache.get(7));
+    EXPECT_EQ(cache.size(), 1u);
+
+    // An expired entry is replaced in place
+    value = cache.get_or_create(7, [] { return make_shared<Texture>(8); });
+    EXPECT_EQ(value->id, 8);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.stats().misses, 2u);
+}
+
+TEST_F(WeakCacheTest, EmptyResultIsNotCached) {
+    weak_cache<int, Texture> cache;
+    EXPECT_FALSE(cache.get_or_create(1, [] { return shared_ptr<Texture>(); }));
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST_F(WeakCacheTest, ThrowingFactoryLeavesCacheUnchanged) {
+    weak_cache<int, Texture> cache;
+    EXPECT_THROW((void)cache.get_or_create(
+                     1, []() -> shared_ptr<Texture> { throw std::runtime_error("load failed"); }),
+                 std::runtime_error);
+    EXPECT_EQ(cache.size(), 0u);
+
+    shared_ptr<Texture> value = cache.get_or_create(1, [] { return make_shared<Texture>(1); });
+    EXPECT_EQ(cache.get(1), value);
+}
+
+TEST_F(WeakCacheTest, EraseDropsTheEntryOnly) {
+    weak_cache<int, Texture> cache;
+    shared_ptr<Texture> value = cache.get_or_create(3, [] { return make_shared<Texture>(3); });
+    EXPECT_TRUE(cache.erase(3));
+    EXPECT_FALSE(cache.erase(3));
+    EXPECT_FALSE(cache.get(3));
+    EXPECT_EQ(value->id, 3);
+    EXPECT_EQ(Texture::destructor_count, 0);
+}
+
+// ============================================================================
+// SWEEPING
+// ============================================================================
+
+TEST_F(WeakCacheTest, SweepErasesExpiredEntries) {
+    weak_cache<int, Texture> cache;
+    shared_ptr<Texture> kept = cache.get_or_create(0, [] { return make_shared<Texture>(0); });
+    for (int i = 1; i < 10; ++i) {
+        (void)cache.get_or_create(i, [i] { return make_shared<Texture>(i); });
+    }
+    EXPECT_EQ(cache.size(), 10u);
+
+    EXPECT_EQ(cache.sweep(), 9u);
+    EXPECT_EQ(cache.size(), 1u);
+    EXPECT_EQ(cache.get(0), kept);
+    EXPECT_EQ(cache.stats().swept, 9u);
+}
+
+TEST_F(WeakCacheTest, InsertsSweepAsTheyGo) {
+    using cache_type = weak_cache<int, Texture>;
+    constexpr int k_keys = 20000;
+    cache_type cache;
+    for (int i = 0; i < k_keys; ++i) {
+        (void)cache.get_or_create(i, [i] { return make_shared<Texture>(i); });
+    }
+
+    // Every value expired at once, and no shard may hold more than about
+    // twice its minimum sweep interval of them
+    const weak_cache_stats stats = cache.stats();
+    EXPECT_GT(stats.sweeps, 0u);
+    EXPECT_EQ(stats.swept + stats.size, std::size_t{k_keys});
+    EXPECT_LE(stats.size, 2 * cache_type::k_shard_count * cache_type::k_min_sweep_interval);
+}
+
+// ============================================================================
+// CONCURRENCY
+// ============================================================================
+
+TEST_F(WeakCacheTest, RacingCallersConstructOnce) {
+    constexpr int k_threads = 8;
+    weak_cache<int, Texture> cache;
+    std::latch start(k_threads);
+
+    std::vector<shared_ptr<Texture>> results(k_threads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&, t] {
+            start.arrive_and_wait();
+            results[static_cast<std::size_t>(t)] = cache.get_or_create(42, [] {
+                // Slow enough for the others to pile up behind it
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                return make_shared<Texture>(42);
+            });
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(Texture::constructor_count, 1);
+    for (const auto &result : results) {
+        EXPECT_EQ(result, results[0]);
+    }
+    EXPECT_EQ(cache.stats().misses, 1u);
+}
+
+TEST_F(WeakCacheTest, ConcurrentChurn) {
+    constexpr int k_threads = 4;
+    constexpr int k_rounds = 5000;
+    constexpr int k_keys = 64;
+    weak_cache<int, Texture> cache;
+    std::latch start(k_threads);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_threads; ++t) {
+        threads.emplace_back([&, t] {
+            start.arrive_and_wait();
+            shared_ptr<Texture> held;
+            for (int i = 0; i < k_rounds; ++i) {
+                const int key = (i * 7 + t) % k_keys;
+                shared_ptr<Texture> value =
+                    cache.get_or_create(key, [key] { return make_shared<Texture>(key); });
+                EXPECT_EQ(value->id, key);
+                // Keep some values alive across rounds so others hit them
+                if (i % 3 == 0) {
+                    held = value;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    const weak_cache_stats stats = cache.stats();
+    EXPECT_LE(stats.misses, std::size_t{k_threads * k_rounds});
+    EXPECT_EQ(Texture::constructor_count, static_cast<int>(stats.misses));
+    EXPECT_EQ(Texture::destructor_count, Texture::constructor_count);
+    cache.sweep();
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+} // namespace ksl